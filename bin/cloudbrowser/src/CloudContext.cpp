@@ -607,10 +607,10 @@ CloudContext::RequestPool::RequestPool()
               request_.pop_front();
               current_request_ = r.request_;
               lock.unlock();
-              if (!done_)
-                r.request_->finish();
-              else
-                r.request_->cancel();
+              // Cancelling doesn't wait, the callback still has to be
+              // called before the context goes away.
+              if (done_) r.request_->cancel();
+              r.request_->finish();
             }
             lock.lock();
           }
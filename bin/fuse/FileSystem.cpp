@@ -92,8 +92,6 @@ FileSystem::FileSystem(const std::vector<ProviderEntry>& provider,
       running_(true),
       http_(std::move(http)),
       temporary_directory_(std::move(temporary_directory)),
-      cancelled_request_thread_(std::async(
-          std::launch::async, std::bind(&FileSystem::cancelled, this))),
       cleanup_(std::async(std::launch::async,
                           std::bind(&FileSystem::cleanup, this))) {
   add(nullptr, 0,
@@ -101,7 +99,9 @@ FileSystem::FileSystem(const std::vector<ProviderEntry>& provider,
                                             IItem::UnknownTimeStamp,
                                             IItem::FileType::Directory));
   std::unordered_set<FileId> root_directory;
+  std::vector<std::shared_ptr<ICloudProvider>> providers;
   for (auto&& entry : provider) {
+    providers.push_back(entry.provider_);
     IItem::Pointer item = util::make_unique<cloudstorage::Item>(
         entry.label_, entry.provider_->rootDirectory()->id(),
         IItem::UnknownSize, IItem::UnknownTimeStamp,
@@ -113,13 +113,21 @@ FileSystem::FileSystem(const std::vector<ProviderEntry>& provider,
             ->inode();
   }
   node_directory_[1] = root_directory;
+  for (auto&& p : providers) {
+    auto listener = std::make_shared<ChangesListener>(this, p);
+    changes_listener_.push_back({p, listener});
+    tracked_.insert(p);
+    p->subscribeChanges(listener);
+  }
 }
 
 FileSystem::~FileSystem() {
+  for (auto&& l : changes_listener_) {
+    l.first->unsubscribeChanges(l.second);
+    l.second->detach();
+  }
   running_ = false;
   request_data_condition_.notify_one();
-  cancelled_request_condition_.notify_one();
-  cancelled_request_thread_.wait();
   cleanup_.wait();
 }
 
@@ -141,30 +149,56 @@ void FileSystem::cleanup() {
   }
 }
 
-void FileSystem::cancelled() {
-  util::set_thread_name("fs-cancelled");
-  while (running_) {
-    std::unique_lock<mutex> lock(request_data_mutex_);
-    cancelled_request_condition_.wait(
-        lock, [=]() { return !cancelled_request_.empty() || !running_; });
-    while (!cancelled_request_.empty()) {
-      {
-        auto r = std::move(cancelled_request_.front());
-        cancelled_request_.pop_front();
-        lock.unlock();
-        r->cancel();
-      }
-      lock.lock();
-    }
-  }
+FileSystem::ChangesListener::ChangesListener(FileSystem* fs,
+                                             std::shared_ptr<ICloudProvider> p)
+    : file_system_(fs), provider_(std::move(p)) {}
+
+void FileSystem::ChangesListener::changed(const std::vector<Change>& changes) {
+  std::lock_guard<mutex> lock(mutex_);
+  if (!file_system_) return;
+  std::lock_guard<mutex> node_lock(file_system_->node_data_mutex_);
+  for (auto&& change : changes) file_system_->apply(provider_, change);
+  file_system_->tracked_.insert(provider_);
 }
 
-void FileSystem::cancel(std::shared_ptr<IGenericRequest> r) {
-  {
-    std::unique_lock<mutex> lock(request_data_mutex_);
-    cancelled_request_.emplace_back(std::move(r));
+void FileSystem::ChangesListener::failed(const Error& e) {
+  std::lock_guard<mutex> lock(mutex_);
+  if (!file_system_) return;
+  log("changes failed", provider_->name(), e.code_, e.description_);
+  std::lock_guard<mutex> node_lock(file_system_->node_data_mutex_);
+  file_system_->tracked_.erase(provider_);
+}
+
+void FileSystem::ChangesListener::detach() {
+  std::lock_guard<mutex> lock(mutex_);
+  file_system_ = nullptr;
+  provider_ = nullptr;
+}
+
+void FileSystem::apply(const std::shared_ptr<ICloudProvider>& p,
+                       const Change& change) {
+  std::lock_guard<mutex> lock(node_data_mutex_);
+  std::vector<Node::Pointer> changed;
+  std::unordered_set<FileId> directories;
+  for (auto&& d : node_map_) {
+    auto node = d.second;
+    if (node->provider() != p || !node->item()) continue;
+    auto id = node->item()->id();
+    if (id == change.item_->id())
+      changed.push_back(node);
+    else if (node->type() == IItem::FileType::Directory &&
+             std::find(change.parents_.begin(), change.parents_.end(), id) !=
+                 change.parents_.end())
+      directories.insert(node->inode());
   }
-  cancelled_request_condition_.notify_one();
+  for (auto&& node : changed) {
+    if (node->upload_request()) continue;
+    log("changed", node->filename());
+    directories.insert(node->parent_);
+    invalidate(node->inode());
+    set(node->inode(), std::make_shared<Node>());
+  }
+  for (auto&& directory : directories) node_directory_.erase(directory);
 }
 
 void FileSystem::add(RequestData r) {
@@ -212,12 +246,13 @@ void FileSystem::set(FileId idx, const Node::Pointer& node) {
       auto it2 =
           node_id_map_.find(id(it1->second->provider(), it1->second->item()));
       if (it2 != std::end(node_id_map_)) node_id_map_.erase(it2);
+      auto it4 = node_path_to_id_.find(it1->second->path_);
+      if (it4 != node_path_to_id_.end() && it4->second == idx)
+        node_path_to_id_.erase(it4);
       node_map_.erase(it1);
     }
     auto it3 = node_directory_.find(idx);
     if (it3 != std::end(node_directory_)) node_directory_.erase(it3);
-    auto it4 = node_path_to_id_.find(node->path_);
-    if (it4 != node_path_to_id_.end()) node_path_to_id_.erase(it4);
   }
 }
 
@@ -376,16 +411,12 @@ void FileSystem::readdir(FileId node, ListDirectoryCallback cb) {
   auto nd = get(node);
   if (nd->provider() == nullptr && !reported)
     return cb(Error{IHttpRequest::Bad, ""});
-  std::unique_lock<std::recursive_mutex> lock(nd->mutex_);
   if (reported) {
-    if (nd->list_directory_pending_) return;
-    auto it = node_timestamp_.find(node);
-    if (it != node_timestamp_.end() &&
-        std::chrono::system_clock::now() - it->second <=
-            CACHE_DIRECTORY_DURATION) {
-      return;
-    }
+    std::lock_guard<mutex> lock(node_data_mutex_);
+    if (tracked_.find(nd->provider()) != tracked_.end()) return;
   }
+  std::unique_lock<std::recursive_mutex> lock(nd->mutex_);
+  if (reported && nd->list_directory_pending_) return;
   nd->list_directory_pending_ = true;
   lock.unlock();
   list_directory_async(
@@ -399,7 +430,6 @@ void FileSystem::readdir(FileId node, ListDirectoryCallback cb) {
           {
             std::lock_guard<mutex> lock(node_data_mutex_);
             node_directory_[node] = ret;
-            node_timestamp_[node] = std::chrono::system_clock::now();
           }
           if (!reported) {
             INode::List nodes;
@@ -564,7 +594,7 @@ void FileSystem::remove(FileId parent, const char* name,
   auto remove_file = [=](Node::Pointer node) {
     std::lock_guard<mutex> lock(node_data_mutex_);
     if (node->upload_request()) {
-      this->cancel(node->upload_request());
+      node->upload_request()->cancel();
       update_lists(node);
       return callback(nullptr);
     }
@@ -20,7 +20,6 @@ namespace cloudstorage {
 
 const int READ_AHEAD = 2 * 1024 * 1024;
 const int CACHED_CHUNK_COUNT = 4;
-const auto CACHE_DIRECTORY_DURATION = std::chrono::seconds(60);
 
 class FileSystem : public IFileSystem {
  public:
@@ -105,6 +104,24 @@ class FileSystem : public IFileSystem {
     std::shared_ptr<IGenericRequest> request_;
   };
 
+  class ChangesListener : public ICloudProvider::IChangesListener {
+   public:
+    ChangesListener(FileSystem *, std::shared_ptr<ICloudProvider>);
+
+    void changed(const std::vector<Change> &) override;
+    void failed(const Error &) override;
+
+    /**
+     * Waits for callbacks in progress; later ones do nothing.
+     */
+    void detach();
+
+   private:
+    mutex mutex_;
+    FileSystem *file_system_;
+    std::shared_ptr<ICloudProvider> provider_;
+  };
+
   void add(RequestData r);
   Node::Pointer add(std::shared_ptr<ICloudProvider>, FileId parent,
                     IItem::Pointer);
@@ -116,8 +133,7 @@ class FileSystem : public IFileSystem {
 
   void invalidate(FileId);
   void cleanup();
-  void cancelled();
-  void cancel(std::shared_ptr<IGenericRequest>);
+  void apply(const std::shared_ptr<ICloudProvider> &, const Change &);
 
   void list_directory_async(const std::shared_ptr<ICloudProvider> &,
                             const IItem::Pointer &,
@@ -138,19 +154,18 @@ class FileSystem : public IFileSystem {
   std::unordered_map<FileId, Node::Pointer> node_map_;
   std::unordered_map<std::string, Node::Pointer> node_id_map_;
   std::unordered_map<FileId, std::unordered_set<FileId>> node_directory_;
-  std::unordered_map<FileId, std::chrono::system_clock::time_point>
-      node_timestamp_;
   std::unordered_map<std::string, FileId> auth_node_;
+  std::unordered_set<std::shared_ptr<ICloudProvider>> tracked_;
   FileId next_;
   std::deque<RequestData> request_data_;
-  std::deque<std::shared_ptr<IGenericRequest>> cancelled_request_;
   std::atomic_bool running_;
   IHttp::Pointer http_;
   std::string temporary_directory_;
-  std::condition_variable_any cancelled_request_condition_;
   std::condition_variable_any request_data_condition_;
-  std::future<void> cancelled_request_thread_;
   std::future<void> cleanup_;
+  std::vector<std::pair<std::shared_ptr<ICloudProvider>,
+                        std::shared_ptr<ChangesListener>>>
+      changes_listener_;
 };
 
 }  // namespace cloudstorage
@@ -129,6 +129,10 @@ ICloudProvider::Pointer create(
   init_data.hints_["state"] = std::to_string(index);
   init_data.hints_["access_token"] = config["access_token"].asString();
   init_data.hints_["temporary_directory"] = std::move(temporary_directory);
+  init_data.hints_["cache_directory_ttl"] = "60000";
+  init_data.hints_["metadata_store"] =
+      util::home_directory() + "/.config/cloudstorage";
+  init_data.hints_["metadata_store_account"] = config["label"].asString();
   return ICloudStorage::create()->provider(config["type"].asString(),
                                            std::move(init_data));
 }
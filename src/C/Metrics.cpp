@@ -0,0 +1,102 @@
+/*****************************************************************************
+ * Metrics.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2018 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Metrics.h"
+#include "CloudStorage.h"
+
+#include "IMetrics.h"
+
+using namespace cloudstorage;
+
+namespace {
+
+const IMetrics::Entry &entry(const cloud_metrics *d, size_t idx) {
+  return (*reinterpret_cast<const std::vector<IMetrics::Entry> *>(d))[idx];
+}
+
+const IMetrics::Histogram &histogram(const cloud_metrics *d, size_t idx,
+                                     cloud_metrics_histogram type) {
+  return type == cloud_metrics_first_byte_time ? entry(d, idx).first_byte_time_
+                                               : entry(d, idx).total_time_;
+}
+
+}  // namespace
+
+cloud_metrics *cloud_metrics_create() {
+  return reinterpret_cast<cloud_metrics *>(
+      new std::vector<IMetrics::Entry>(IMetrics::instance().entries()));
+}
+
+void cloud_metrics_release(cloud_metrics *d) {
+  delete reinterpret_cast<std::vector<IMetrics::Entry> *>(d);
+}
+
+void cloud_metrics_reset() { IMetrics::instance().reset(); }
+
+size_t cloud_metrics_length(const cloud_metrics *d) {
+  return reinterpret_cast<const std::vector<IMetrics::Entry> *>(d)->size();
+}
+
+cloud_string *cloud_metrics_provider(const cloud_metrics *d, size_t idx) {
+  return cloud_string_create(entry(d, idx).provider_.c_str());
+}
+
+cloud_string *cloud_metrics_operation(const cloud_metrics *d, size_t idx) {
+  return cloud_string_create(entry(d, idx).operation_.c_str());
+}
+
+uint64_t cloud_metrics_count(const cloud_metrics *d, size_t idx) {
+  return entry(d, idx).count_;
+}
+
+uint64_t cloud_metrics_errors(const cloud_metrics *d, size_t idx) {
+  return entry(d, idx).errors_;
+}
+
+uint64_t cloud_metrics_reused_connections(const cloud_metrics *d, size_t idx) {
+  return entry(d, idx).reused_connections_;
+}
+
+uint64_t cloud_metrics_downloaded_bytes(const cloud_metrics *d, size_t idx) {
+  return entry(d, idx).downloaded_bytes_;
+}
+
+uint64_t cloud_metrics_uploaded_bytes(const cloud_metrics *d, size_t idx) {
+  return entry(d, idx).uploaded_bytes_;
+}
+
+uint64_t cloud_metrics_time_sum(const cloud_metrics *d, size_t idx,
+                                cloud_metrics_histogram type) {
+  return histogram(d, idx, type).sum_;
+}
+
+uint64_t cloud_metrics_time_max(const cloud_metrics *d, size_t idx,
+                                cloud_metrics_histogram type) {
+  return histogram(d, idx, type).max_;
+}
+
+uint64_t cloud_metrics_time_percentile(const cloud_metrics *d, size_t idx,
+                                       cloud_metrics_histogram type,
+                                       double p) {
+  return histogram(d, idx, type).percentile(p);
+}
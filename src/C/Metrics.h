@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * Metrics.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2018 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Item.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+struct cloud_metrics;
+
+enum cloud_metrics_histogram {
+  cloud_metrics_first_byte_time,
+  cloud_metrics_total_time
+};
+
+CLOUDSTORAGE_API struct cloud_metrics* cloud_metrics_create();
+CLOUDSTORAGE_API void cloud_metrics_release(struct cloud_metrics*);
+CLOUDSTORAGE_API void cloud_metrics_reset();
+
+CLOUDSTORAGE_API size_t cloud_metrics_length(const struct cloud_metrics*);
+CLOUDSTORAGE_API cloud_string* cloud_metrics_provider(
+    const struct cloud_metrics*, size_t idx);
+CLOUDSTORAGE_API cloud_string* cloud_metrics_operation(
+    const struct cloud_metrics*, size_t idx);
+CLOUDSTORAGE_API uint64_t cloud_metrics_count(const struct cloud_metrics*,
+                                              size_t idx);
+CLOUDSTORAGE_API uint64_t cloud_metrics_errors(const struct cloud_metrics*,
+                                               size_t idx);
+CLOUDSTORAGE_API uint64_t
+cloud_metrics_reused_connections(const struct cloud_metrics*, size_t idx);
+CLOUDSTORAGE_API uint64_t
+cloud_metrics_downloaded_bytes(const struct cloud_metrics*, size_t idx);
+CLOUDSTORAGE_API uint64_t
+cloud_metrics_uploaded_bytes(const struct cloud_metrics*, size_t idx);
+CLOUDSTORAGE_API uint64_t cloud_metrics_time_sum(
+    const struct cloud_metrics*, size_t idx, enum cloud_metrics_histogram);
+CLOUDSTORAGE_API uint64_t cloud_metrics_time_max(
+    const struct cloud_metrics*, size_t idx, enum cloud_metrics_histogram);
+CLOUDSTORAGE_API uint64_t
+cloud_metrics_time_percentile(const struct cloud_metrics*, size_t idx,
+                              enum cloud_metrics_histogram, double p);
+
+#ifdef __cplusplus
+}
+#endif  // __cplusplus
+
+#endif  // METRICS_H
@@ -29,7 +29,9 @@
 #include <iomanip>
 
 #include "Request/RecursiveRequest.h"
+#include "Utility/ChunkedBuffer.h"
 #include "Utility/Utility.h"
+#include "Utility/XmlStream.h"
 
 using namespace std::placeholders;
 
@@ -37,21 +39,6 @@ namespace cloudstorage {
 
 namespace {
 
-std::string escapePath(const std::string& str) {
-  std::string data = util::Url::escape(str);
-  std::string slash = util::Url::escape("/");
-  std::string result;
-  for (size_t i = 0; i < data.size();)
-    if (data.substr(i, slash.length()) == slash) {
-      result += "/";
-      i += slash.length();
-    } else {
-      result += data[i];
-      i++;
-    }
-  return result;
-}
-
 std::string currentDate() {
   auto time =
       util::gmtime(std::chrono::duration_cast<std::chrono::seconds>(
@@ -184,15 +171,17 @@ ICloudProvider::MoveItemRequest::Pointer AmazonS3::moveItemAsync(
           auto request = http()->create(endpoint() + "/" + new_path, "PUT");
           if (item->type() != IItem::FileType::Directory)
             request->setHeaderParameter(
-                "x-amz-copy-source", bucket() + "/" + escapePath(item->id()));
+                "x-amz-copy-source",
+                bucket() + "/" + util::Url::escapePath(item->id()));
           return request;
         },
         [=](EitherError<Response> e) {
           if (e.left()) return callback(e.left());
           r->request(
               [=](util::Output) {
-                return http()->create(endpoint() + "/" + escapePath(item->id()),
-                                      "DELETE");
+                return http()->create(
+                    endpoint() + "/" + util::Url::escapePath(item->id()),
+                    "DELETE");
               },
               [=](EitherError<Response> e) {
                 if (e.left()) return callback(e.left());
@@ -223,15 +212,17 @@ ICloudProvider::RenameItemRequest::Pointer AmazonS3::renameItemAsync(
           auto request = http()->create(endpoint() + "/" + new_path, "PUT");
           if (item->type() != IItem::FileType::Directory)
             request->setHeaderParameter(
-                "x-amz-copy-source", bucket() + "/" + escapePath(item->id()));
+                "x-amz-copy-source",
+                bucket() + "/" + util::Url::escapePath(item->id()));
           return request;
         },
         [=](EitherError<Response> e) {
           if (e.left()) return callback(e.left());
           r->request(
               [=](util::Output) {
-                return http()->create(endpoint() + "/" + escapePath(item->id()),
-                                      "DELETE");
+                return http()->create(
+                    endpoint() + "/" + util::Url::escapePath(item->id()),
+                    "DELETE");
               },
               [=](EitherError<Response> e) {
                 if (e.left()) return callback(e.left());
@@ -249,8 +240,9 @@ ICloudProvider::RenameItemRequest::Pointer AmazonS3::renameItemAsync(
 IHttpRequest::Pointer AmazonS3::createDirectoryRequest(const IItem& parent,
                                                        const std::string& name,
                                                        std::ostream&) const {
-  return http()->create(endpoint() + "/" + escapePath(parent.id() + name + "/"),
-                        "PUT");
+  return http()->create(
+      endpoint() + "/" + util::Url::escapePath(parent.id() + name + "/"),
+      "PUT");
 }
 
 IItem::Pointer AmazonS3::createDirectoryResponse(const IItem& parent,
@@ -268,8 +260,8 @@ ICloudProvider::DeleteItemRequest::Pointer AmazonS3::deleteItemAsync(
                      Request::CompleteCallback complete) {
     r->request(
         [=](util::Output) {
-          return http()->create(endpoint() + "/" + escapePath(item->id()),
-                                "DELETE");
+          return http()->create(
+              endpoint() + "/" + util::Url::escapePath(item->id()), "DELETE");
         },
         [=](EitherError<Response> e) {
           if (e.left())
@@ -316,10 +308,10 @@ ICloudProvider::GetItemDataRequest::Pointer AmazonS3::getItemDataAsync(
                };
                r->request(factory, [=](EitherError<Response> e) {
                  if (e.left()) return r->done(e.left());
-                 std::stringstream sstream;
-                 sstream << e.right()->output().rdbuf();
+                 std::string storage;
+                 auto xml = util::contents(e.right()->output(), storage);
                  tinyxml2::XMLDocument document;
-                 if (document.Parse(sstream.str().c_str()) !=
+                 if (document.Parse(xml.data_, xml.size_) !=
                      tinyxml2::XML_SUCCESS)
                    return r->done(Error{IHttpRequest::Failure,
                                         util::Error::FAILED_TO_PARSE_XML});
@@ -352,6 +344,70 @@ ICloudProvider::GetItemDataRequest::Pointer AmazonS3::getItemDataAsync(
       ->run();
 }
 
+ICloudProvider::GetItemRequest::Pointer AmazonS3::getItemAsync(
+    const std::string& path, GetItemCallback callback) {
+  return std::make_shared<Request<EitherError<IItem>>>(
+             shared_from_this(), callback,
+             [=](Request<EitherError<IItem>>::Pointer r) {
+               if (path.empty() || path.front() != '/')
+                 return r->done(
+                     Error{IHttpRequest::Forbidden, util::Error::INVALID_PATH});
+               auto key = path.substr(1);
+               while (!key.empty() && key.back() == '/') key.pop_back();
+               if (key.empty()) return r->done(rootDirectory());
+               auto factory = [=](util::Output) {
+                 auto request = http()->create(endpoint() + "/", "GET");
+                 request->setParameter("list-type", "2");
+                 request->setParameter("prefix", key);
+                 request->setParameter("delimiter", "/");
+                 return request;
+               };
+               r->request(factory, [=](EitherError<Response> e) {
+                 if (e.left()) return r->done(e.left());
+                 std::string storage;
+                 auto xml = util::contents(e.right()->output(), storage);
+                 tinyxml2::XMLDocument document;
+                 if (document.Parse(xml.data_, xml.size_) !=
+                     tinyxml2::XML_SUCCESS)
+                   return r->done(Error{IHttpRequest::Failure,
+                                        util::Error::FAILED_TO_PARSE_XML});
+                 auto node = document.RootElement();
+                 for (auto e = node->FirstChildElement("Contents"); e;
+                      e = e->NextSiblingElement("Contents")) {
+                   auto key_element = e->FirstChildElement("Key");
+                   if (!key_element || !key_element->GetText() ||
+                       key_element->GetText() != key)
+                     continue;
+                   auto size = IItem::UnknownSize;
+                   auto timestamp = IItem::UnknownTimeStamp;
+                   if (auto size_element = e->FirstChildElement("Size"))
+                     if (auto text = size_element->GetText())
+                       size = std::stoull(text);
+                   if (auto time_element = e->FirstChildElement("LastModified"))
+                     if (auto text = time_element->GetText())
+                       timestamp = util::parse_time(text);
+                   auto item = std::make_shared<Item>(
+                       getFilename(key), key, size, timestamp,
+                       IItem::FileType::Unknown);
+                   item->set_url(getUrl(*item));
+                   return r->done(EitherError<IItem>(item));
+                 }
+                 for (auto e = node->FirstChildElement("CommonPrefixes"); e;
+                      e = e->NextSiblingElement("CommonPrefixes")) {
+                   auto prefix_element = e->FirstChildElement("Prefix");
+                   if (prefix_element && prefix_element->GetText() &&
+                       prefix_element->GetText() == key + "/")
+                     return r->done(EitherError<IItem>(std::make_shared<Item>(
+                         getFilename(key + "/"), key + "/", IItem::UnknownSize,
+                         IItem::UnknownTimeStamp, IItem::FileType::Directory)));
+                 }
+                 r->done(Error{IHttpRequest::NotFound,
+                               util::Error::ITEM_NOT_FOUND});
+               });
+             })
+      ->run();
+}
+
 IHttpRequest::Pointer AmazonS3::listDirectoryRequest(
     const IItem& item, const std::string& page_token, std::ostream&) const {
   auto request = http()->create(endpoint() + "/", "GET");
@@ -368,7 +424,8 @@ IHttpRequest::Pointer AmazonS3::uploadFileRequest(const IItem& directory,
                                                   std::ostream&,
                                                   std::ostream&) const {
   return http()->create(
-      endpoint() + "/" + escapePath(directory.id() + filename), "PUT");
+      endpoint() + "/" + util::Url::escapePath(directory.id() + filename),
+      "PUT");
 }
 
 IItem::Pointer AmazonS3::uploadFileResponse(const IItem& item,
@@ -382,61 +439,65 @@ IItem::Pointer AmazonS3::uploadFileResponse(const IItem& item,
 
 IHttpRequest::Pointer AmazonS3::downloadFileRequest(const IItem& item,
                                                     std::ostream&) const {
-  return http()->create(endpoint() + "/" + escapePath(item.id()), "GET");
-}
-
-IItem::List AmazonS3::listDirectoryResponse(
-    const IItem& parent, std::istream& stream,
-    std::string& next_page_token) const {
-  std::stringstream sstream;
-  sstream << stream.rdbuf();
-  tinyxml2::XMLDocument document;
-  if (document.Parse(sstream.str().c_str()) != tinyxml2::XML_SUCCESS)
-    throw std::logic_error(util::Error::FAILED_TO_PARSE_XML);
-  IItem::List result;
-  if (document.RootElement()->FirstChildElement("Name")) {
-    for (auto child = document.RootElement()->FirstChildElement("Contents");
-         child; child = child->NextSiblingElement("Contents")) {
-      auto size_element = child->FirstChildElement("Size");
-      if (!size_element) throw std::logic_error(util::Error::INVALID_XML);
-      auto size = std::stoull(size_element->GetText());
-      auto key_element = child->FirstChildElement("Key");
-      if (!key_element) throw std::logic_error(util::Error::INVALID_XML);
-      std::string id = key_element->GetText();
-      if (size == 0 && id == parent.id()) continue;
-      auto timestamp_element = child->FirstChildElement("LastModified");
-      if (!timestamp_element) throw std::logic_error(util::Error::INVALID_XML);
-      std::string timestamp = timestamp_element->GetText();
-      auto item = util::make_unique<Item>(getFilename(id), id, size,
-                                          util::parse_time(timestamp),
-                                          IItem::FileType::Unknown);
-      item->set_url(getUrl(*item));
-      result.push_back(std::move(item));
-    }
-    for (auto child =
-             document.RootElement()->FirstChildElement("CommonPrefixes");
-         child; child = child->NextSiblingElement("CommonPrefixes")) {
-      auto prefix_element = child->FirstChildElement("Prefix");
-      if (!prefix_element) throw std::logic_error(util::Error::INVALID_XML);
-      std::string id = prefix_element->GetText();
-      auto item = util::make_unique<Item>(
-          getFilename(id), id, IItem::UnknownSize, IItem::UnknownTimeStamp,
-          IItem::FileType::Directory);
-      result.push_back(std::move(item));
-    }
-    auto is_truncated_element =
-        document.RootElement()->FirstChildElement("IsTruncated");
-    if (!is_truncated_element) throw std::logic_error(util::Error::INVALID_XML);
-    if (is_truncated_element->GetText() == std::string("true")) {
-      auto next_token_element =
-          document.RootElement()->FirstChildElement("NextContinuationToken");
-      if (!next_token_element) throw std::logic_error(util::Error::INVALID_XML);
-      next_page_token = next_token_element->GetText();
-    }
-  }
-  return result;
+  return http()->create(endpoint() + "/" + util::Url::escapePath(item.id()),
+                        "GET");
+}
+
+std::unique_ptr<CloudProvider::ListingStream> AmazonS3::listDirectoryStream(
+    const IItem& parent, const ListingStream::ItemCallback& callback) const {
+  auto buffer = util::make_unique<util::XmlBuffer>(
+      std::vector<std::string>{"Contents", "CommonPrefixes"},
+      [=, &parent](const tinyxml2::XMLElement& child) {
+        if (child.Name() == std::string("CommonPrefixes")) {
+          auto prefix_element = child.FirstChildElement("Prefix");
+          if (!prefix_element) throw std::logic_error(util::Error::INVALID_XML);
+          std::string id = prefix_element->GetText();
+          return callback(util::make_unique<Item>(
+              getFilename(id), id, IItem::UnknownSize, IItem::UnknownTimeStamp,
+              IItem::FileType::Directory));
+        }
+        auto size_element = child.FirstChildElement("Size");
+        if (!size_element) throw std::logic_error(util::Error::INVALID_XML);
+        auto size = std::stoull(size_element->GetText());
+        auto key_element = child.FirstChildElement("Key");
+        if (!key_element) throw std::logic_error(util::Error::INVALID_XML);
+        std::string id = key_element->GetText();
+        if (size == 0 && id == parent.id()) return;
+        auto timestamp_element = child.FirstChildElement("LastModified");
+        if (!timestamp_element)
+          throw std::logic_error(util::Error::INVALID_XML);
+        std::string timestamp = timestamp_element->GetText();
+        auto item = util::make_unique<Item>(getFilename(id), id, size,
+                                            util::parse_time(timestamp),
+                                            IItem::FileType::Unknown);
+        item->set_url(getUrl(*item));
+        callback(std::move(item));
+      });
+  auto xml = buffer.get();
+  return util::make_unique<ListingStream>(
+      std::move(buffer), [=](std::string& next_page_token) {
+        tinyxml2::XMLDocument document;
+        xml->finish(document);
+        if (document.RootElement()->FirstChildElement("Name")) {
+          auto is_truncated_element =
+              document.RootElement()->FirstChildElement("IsTruncated");
+          if (!is_truncated_element)
+            throw std::logic_error(util::Error::INVALID_XML);
+          if (is_truncated_element->GetText() == std::string("true")) {
+            auto next_token_element =
+                document.RootElement()->FirstChildElement(
+                    "NextContinuationToken");
+            if (!next_token_element)
+              throw std::logic_error(util::Error::INVALID_XML);
+            next_page_token = next_token_element->GetText();
+          }
+        }
+        return IItem::List();
+      });
 }
 
+bool AmazonS3::listDirectoryStreamable(const IItem&) const { return true; }
+
 void AmazonS3::authorizeRequest(IHttpRequest& request) const {
   if (!crypto()) throw std::runtime_error("no crypto functions provided");
   std::string region = this->region().empty() ? "us-east-1" : this->region();
@@ -564,8 +625,8 @@ bool AmazonS3::unpackCredentials(const std::string& code) {
 }
 
 std::string AmazonS3::getUrl(const Item& item) const {
-  auto request =
-      http()->create(endpoint() + "/" + escapePath(item.id()), "GET");
+  auto request = http()->create(
+      endpoint() + "/" + util::Url::escapePath(item.id()), "GET");
   authorizeRequest(*request);
   std::string parameters;
   for (const auto& p : request->parameters())
@@ -53,6 +53,8 @@ class AmazonS3 : public CloudProvider {
   AuthorizeRequest::Pointer authorizeAsync() override;
   GetItemDataRequest::Pointer getItemDataAsync(const std::string& id,
                                                GetItemDataCallback f) override;
+  GetItemRequest::Pointer getItemAsync(const std::string& absolute_path,
+                                       GetItemCallback) override;
   MoveItemRequest::Pointer moveItemAsync(IItem::Pointer source,
                                          IItem::Pointer destination,
                                          MoveItemCallback) override;
@@ -75,8 +77,9 @@ class AmazonS3 : public CloudProvider {
   IHttpRequest::Pointer downloadFileRequest(
       const IItem&, std::ostream& input_stream) const override;
 
-  IItem::List listDirectoryResponse(
-      const IItem&, std::istream&, std::string& next_page_token) const override;
+  std::unique_ptr<ListingStream> listDirectoryStream(
+      const IItem&, const ListingStream::ItemCallback&) const override;
+  bool listDirectoryStreamable(const IItem&) const override;
   IItem::Pointer createDirectoryResponse(const IItem& parent,
                                          const std::string& name,
                                          std::istream& response) const override;
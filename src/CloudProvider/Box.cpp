@@ -201,17 +201,25 @@ IItem::Pointer Box::getItemDataResponse(std::istream& stream) const {
   return toItem(util::json::from_stream(stream));
 }
 
-IItem::List Box::listDirectoryResponse(const IItem&, std::istream& stream,
-                                       std::string& next_page_token) const {
-  auto response = util::json::from_stream(stream);
-  IItem::List result;
-  for (const Json::Value& v : response["entries"]) result.push_back(toItem(v));
+bool Box::listDirectoryItemsPath(const IItem&,
+                                 std::vector<std::string>& path) const {
+  path = {"entries"};
+  return true;
+}
+
+IItem::Pointer Box::listDirectoryItem(const IItem&,
+                                      const Json::Value& v) const {
+  return toItem(v);
+}
+
+IItem::List Box::listDirectoryRest(const IItem&, const Json::Value& response,
+                                   std::string& next_page_token) const {
   int offset = response["offset"].asInt();
   int limit = response["limit"].asInt();
   int total_count = response["total_count"].asInt();
   if (offset + limit < total_count)
     next_page_token = std::to_string(offset + limit);
-  return result;
+  return {};
 }
 
 IItem::Pointer Box::toItem(const Json::Value& v) const {
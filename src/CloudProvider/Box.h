@@ -66,8 +66,12 @@ class Box : public CloudProvider {
   IHttpRequest::Pointer getGeneralDataRequest(std::ostream&) const override;
 
   IItem::Pointer getItemDataResponse(std::istream& response) const override;
-  IItem::List listDirectoryResponse(
-      const IItem&, std::istream&, std::string& next_page_token) const override;
+  bool listDirectoryItemsPath(const IItem&,
+                              std::vector<std::string>& path) const override;
+  IItem::Pointer listDirectoryItem(const IItem&,
+                                   const Json::Value&) const override;
+  IItem::List listDirectoryRest(const IItem&, const Json::Value&,
+                                std::string& next_page_token) const override;
   std::string getItemUrlResponse(const IItem& item,
                                  const IHttpRequest::HeaderParameters&,
                                  std::istream& response) const override;
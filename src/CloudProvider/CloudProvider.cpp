@@ -25,14 +25,18 @@
 
 #include <json/json.h>
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <random>
 #include <sstream>
 
 #include "Utility/FileServer.h"
 #include "Utility/Item.h"
+#include "Utility/JsonStream.h"
 #include "Utility/Utility.h"
 
+#include "Request/ChangesRequest.h"
 #include "Request/CreateDirectoryRequest.h"
 #include "Request/DeleteItemRequest.h"
 #include "Request/DownloadFileRequest.h"
@@ -44,6 +48,7 @@
 #include "Request/ListDirectoryRequest.h"
 #include "Request/MoveItemRequest.h"
 #include "Request/RenameItemRequest.h"
+#include "Request/StreamDirectoryRequest.h"
 #include "Request/UploadFileRequest.h"
 
 #undef CreateDirectory
@@ -52,6 +57,11 @@ using namespace std::placeholders;
 
 const std::string DEFAULT_STATE = "DEFAULT_STATE";
 const std::string DEFAULT_FILE_URL = "http://127.0.0.1:12346";
+const uint32_t DEFAULT_RETRY_ATTEMPTS = 5;
+const std::chrono::milliseconds DEFAULT_RETRY_BASE_DELAY(500);
+const std::chrono::milliseconds DEFAULT_RETRY_MAX_DELAY(32000);
+const std::chrono::seconds TOKEN_REFRESH_LEAD(300);
+const std::chrono::milliseconds DEFAULT_CHANGES_INTERVAL(30000);
 
 namespace {
 
@@ -130,7 +140,18 @@ class UploadFileCallback : public cloudstorage::IUploadFileCallback {
 namespace cloudstorage {
 
 CloudProvider::CloudProvider(IAuth::Pointer auth)
-    : auth_(std::move(auth)), http_(), deleted_() {}
+    : auth_(std::move(auth)),
+      http_(),
+      throttle_(IThrottle::create()),
+      retry_attempts_(DEFAULT_RETRY_ATTEMPTS),
+      retry_base_delay_(DEFAULT_RETRY_BASE_DELAY),
+      retry_max_delay_(DEFAULT_RETRY_MAX_DELAY),
+      request_timeout_(),
+      item_data_flights_(SingleFlight<EitherError<IItem>>::create()),
+      page_flights_(SingleFlight<EitherError<PageData>>::create()),
+      token_generation_(),
+      deleted_(),
+      pending_cancelled_() {}
 
 void CloudProvider::initialize(InitData&& data) {
   auto lock = auth_lock();
@@ -139,10 +160,18 @@ void CloudProvider::initialize(InitData&& data) {
   http_ = std::move(data.http_engine_);
   http_server_ = std::move(data.http_server_);
   thread_pool_ = std::move(data.thread_pool_);
+  shared_throttle_ = std::move(data.throttle_);
 
   auto t = auth()->fromTokenString(data.token_);
   setWithHint(data.hints_, "access_token",
               [&t](std::string v) { t->token_ = v; });
+  setWithHint(data.hints_, "access_token_expires", [&t](std::string v) {
+    auto expires = std::chrono::system_clock::time_point(
+        std::chrono::seconds(std::strtoll(v.c_str(), nullptr, 10)));
+    auto expires_in = std::chrono::duration_cast<std::chrono::seconds>(
+        expires - std::chrono::system_clock::now());
+    if (expires_in.count() > 0) t->expires_in_ = expires_in.count();
+  });
   auth()->set_access_token(std::move(t));
   auth()->set_permission(data.permission_);
 
@@ -162,13 +191,128 @@ void CloudProvider::initialize(InitData&& data) {
               [this](std::string v) { auth()->set_error_page(v); });
   setWithHint(data.hints_, "file_url",
               [this](std::string v) { file_url_ = v; });
+  setWithHint(data.hints_, "download_limit", [this](std::string v) {
+    throttle_->setLimit(IThrottle::Direction::Download,
+                        std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "upload_limit", [this](std::string v) {
+    throttle_->setLimit(IThrottle::Direction::Upload,
+                        std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "retry_attempts", [this](std::string v) {
+    retry_attempts_ = std::strtoul(v.c_str(), nullptr, 10);
+  });
+  setWithHint(data.hints_, "retry_base_delay", [this](std::string v) {
+    retry_base_delay_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "retry_max_delay", [this](std::string v) {
+    retry_max_delay_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "request_timeout", [this](std::string v) {
+    request_timeout_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "max_provider_requests", [this](std::string v) {
+    concurrency_limit_.set_maximum(std::strtoul(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "hedge_percentile", [this](std::string v) {
+    hedge_policy_.set_percentile(std::strtod(v.c_str(), nullptr));
+  });
+  setWithHint(data.hints_, "hedge_budget", [this](std::string v) {
+    hedge_policy_.set_budget(std::strtod(v.c_str(), nullptr) / 100);
+  });
+
+  MetadataCache::Options cache_options;
+  setWithHint(data.hints_, "cache_item_ttl", [&](std::string v) {
+    cache_options.item_ttl_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "cache_directory_ttl", [&](std::string v) {
+    cache_options.directory_ttl_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "cache_url_ttl", [&](std::string v) {
+    cache_options.url_ttl_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "cache_path_ttl", [&](std::string v) {
+    cache_options.path_ttl_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "path_index_ttl", [&](std::string v) {
+    cache_options.path_index_ttl_ =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  setWithHint(data.hints_, "cache_memory_budget", [&](std::string v) {
+    cache_options.memory_budget_ = std::strtoull(v.c_str(), nullptr, 10);
+  });
+  std::string metadata_store, metadata_store_account;
+  setWithHint(data.hints_, "metadata_store",
+              [&](std::string v) { metadata_store = v; });
+  setWithHint(data.hints_, "metadata_store_account",
+              [&](std::string v) { metadata_store_account = v; });
+  metadata_cache_ = std::make_shared<MetadataCache>(
+      cache_options,
+      metadata_store.empty() || metadata_store_account.empty()
+          ? nullptr
+          : MetadataStore::open(MetadataStore::path(metadata_store, name(),
+                                                    metadata_store_account)));
+  auto changes_interval = DEFAULT_CHANGES_INTERVAL;
+  setWithHint(data.hints_, "changes_interval", [&](std::string v) {
+    changes_interval =
+        std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+  });
+  changes_notifier_ =
+      std::make_shared<ChangesNotifier>(shared_from_this(), changes_interval);
 
 #ifdef WITH_CRYPTOPP
   if (!crypto_) crypto_ = ICrypto::create();
 #endif
 
 #ifdef WITH_CURL
-  if (!http_) http_ = IHttp::create();
+  if (!http_) {
+    IHttp::Options options;
+    setWithHint(data.hints_, "http_version", [&options](std::string v) {
+      if (v == "2")
+        options.version_ = IHttp::Version::Http2;
+      else if (v == "2-prior-knowledge")
+        options.version_ = IHttp::Version::Http2PriorKnowledge;
+    });
+    setWithHint(data.hints_, "max_host_connections",
+                [&options](std::string v) {
+                  options.max_host_connections_ =
+                      std::strtoul(v.c_str(), nullptr, 10);
+                });
+    setWithHint(data.hints_, "max_concurrent_streams",
+                [&options](std::string v) {
+                  options.max_concurrent_streams_ =
+                      std::strtoul(v.c_str(), nullptr, 10);
+                });
+    setWithHint(data.hints_, "max_requests", [&options](std::string v) {
+      options.max_requests_ = std::strtoul(v.c_str(), nullptr, 10);
+    });
+    setWithHint(data.hints_, "max_host_requests", [&options](std::string v) {
+      options.max_host_requests_ = std::strtoul(v.c_str(), nullptr, 10);
+    });
+    setWithHint(data.hints_, "http_worker_count", [&options](std::string v) {
+      options.worker_count_ = std::strtoul(v.c_str(), nullptr, 10);
+    });
+    setWithHint(data.hints_, "connect_timeout", [&options](std::string v) {
+      options.connect_timeout_ =
+          std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+    });
+    setWithHint(data.hints_, "first_byte_timeout", [&options](std::string v) {
+      options.first_byte_timeout_ =
+          std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+    });
+    setWithHint(data.hints_, "stall_timeout", [&options](std::string v) {
+      options.stall_timeout_ =
+          std::chrono::milliseconds(std::strtoull(v.c_str(), nullptr, 10));
+    });
+    http_ = IHttp::create(options);
+  }
 #endif
 
 #ifdef WITH_MICROHTTPD
@@ -192,15 +336,23 @@ void CloudProvider::initialize(InitData&& data) {
   if (auth()->error_page().empty())
     auth()->set_error_page(util::error_page(name()));
   auth()->initialize(http(), http_server());
+  lock.unlock();
+  // Token restored from hints is refreshed ahead of time as well.
+  scheduleTokenRefresh();
 }
 
 void CloudProvider::destroy() {
+  if (changes_notifier_) changes_notifier_->clear();
   cancelStreamRequests();
+  cancelPendingRequests();
   file_daemon_ = nullptr;
   crypto_ = nullptr;
   http_ = nullptr;
   http_server_ = nullptr;
   thread_pool_ = nullptr;
+  std::unique_lock<std::mutex> lock(current_authorization_mutex_);
+  auto token_refresh = std::move(token_refresh_);
+  lock.unlock();
 }
 
 std::string ICloudProvider::serializeSession(const std::string& token,
@@ -236,9 +388,16 @@ bool ICloudProvider::deserializeSession(const std::string& serialized_data,
 }
 
 ICloudProvider::Hints CloudProvider::hints() const {
-  return {{"access_token", access_token()},
-          {"state", auth()->state()},
-          {"file_url", file_url_}};
+  Hints result = {{"access_token", access_token()},
+                  {"state", auth()->state()},
+                  {"file_url", file_url_}};
+  auto lock = auth_lock();
+  if (token_expiry_ != std::chrono::system_clock::time_point())
+    result["access_token_expires"] = std::to_string(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            token_expiry_.time_since_epoch())
+            .count());
+  return result;
 }
 
 std::string CloudProvider::access_token() const {
@@ -281,17 +440,74 @@ ICrypto* CloudProvider::crypto() const { return crypto_.get(); }
 
 IHttp* CloudProvider::http() const { return http_.get(); }
 
+IThrottle::Pointer CloudProvider::throttle() const { return throttle_; }
+
+void CloudProvider::throttle(IHttpRequest* request) const {
+  request->addThrottle(throttle_);
+  if (shared_throttle_) request->addThrottle(shared_throttle_);
+}
+
+IMetrics::Key CloudProvider::metricsKey(const char* operation) const {
+  std::lock_guard<std::mutex> lock(metrics_keys_mutex_);
+  auto& key = metrics_keys_[operation];
+  if (!key) key = IMetrics::instance().key(name(), operation);
+  return key;
+}
+
 IHttpServerFactory* CloudProvider::http_server() const {
   return http_server_.get();
 }
 
 IThreadPool* CloudProvider::thread_pool() const { return thread_pool_.get(); }
 
+const MetadataCache::Pointer& CloudProvider::metadata_cache() const {
+  return metadata_cache_;
+}
+
 bool CloudProvider::isSuccess(int code,
                               const IHttpRequest::HeaderParameters&) const {
   return IHttpRequest::isSuccess(code);
 }
 
+bool CloudProvider::isThrottled(int code,
+                                const IHttpRequest::HeaderParameters&) const {
+  return code == IHttpRequest::TooManyRequests ||
+         code == IHttpRequest::ServiceUnavailable;
+}
+
+bool CloudProvider::isRetryable(
+    const std::string& method, int code,
+    const IHttpRequest::HeaderParameters& headers) const {
+  if (isThrottled(code, headers)) return true;
+  if (code != IHttpRequest::InternalServerError &&
+      code != IHttpRequest::BadGateway &&
+      code != IHttpRequest::GatewayTimeout && code != IHttpRequest::Timeout)
+    return false;
+  return method == "GET" || method == "HEAD" || method == "PUT" ||
+         method == "DELETE" || method == "OPTIONS" || method == "PROPFIND";
+}
+
+std::chrono::milliseconds CloudProvider::retryDelay(
+    uint32_t attempt, const IHttpRequest::HeaderParameters& headers) const {
+  auto it = headers.find("retry-after");
+  if (it != headers.end()) {
+    char* end;
+    auto seconds = std::strtoull(it->second.c_str(), &end, 10);
+    if (*end == '\0') return std::chrono::seconds(seconds);
+    auto time = util::parse_http_time(it->second);
+    if (time != IItem::UnknownTimeStamp)
+      return std::max(std::chrono::milliseconds(),
+                      std::chrono::duration_cast<std::chrono::milliseconds>(
+                          time - std::chrono::system_clock::now()));
+  }
+  thread_local std::minstd_rand engine(std::random_device{}());
+  auto bound = retry_max_delay_;
+  if (attempt < 31 && retry_base_delay_ * (1ull << attempt) < bound)
+    bound = retry_base_delay_ * (1ull << attempt);
+  return std::chrono::milliseconds(
+      std::uniform_int_distribution<int64_t>(0, bound.count())(engine));
+}
+
 ICloudProvider::ExchangeCodeRequest::Pointer CloudProvider::exchangeCodeAsync(
     const std::string& code, ExchangeCodeCallback callback) {
   return std::make_shared<cloudstorage::ExchangeCodeRequest>(shared_from_this(),
@@ -306,6 +522,14 @@ ICloudProvider::ListDirectoryRequest::Pointer CloudProvider::listDirectoryAsync(
       ->run();
 }
 
+ICloudProvider::StreamDirectoryRequest::Pointer
+CloudProvider::streamDirectoryAsync(
+    IItem::Pointer item, IStreamDirectoryCallback::Pointer callback) {
+  return std::make_shared<cloudstorage::StreamDirectoryRequest>(
+             shared_from_this(), std::move(item), std::move(callback))
+      ->run();
+}
+
 ICloudProvider::GetItemRequest::Pointer CloudProvider::getItemAsync(
     const std::string& absolute_path, GetItemCallback callback) {
   return std::make_shared<cloudstorage::GetItemRequest>(shared_from_this(),
@@ -317,7 +541,9 @@ ICloudProvider::DownloadFileRequest::Pointer CloudProvider::downloadFileAsync(
     IItem::Pointer file, IDownloadFileCallback::Pointer callback, Range range) {
   return std::make_shared<cloudstorage::DownloadFileRequest>(
              shared_from_this(), std::move(file), std::move(callback), range,
-             std::bind(&CloudProvider::downloadFileRequest, this, _1, _2))
+             [this](const IItem& item, std::ostream& input) {
+               return downloadFileRequest(item, input);
+             })
       ->run();
 }
 
@@ -348,6 +574,55 @@ bool CloudProvider::reauthorize(int code,
 
 bool CloudProvider::unpackCredentials(const std::string&) { return false; }
 
+void CloudProvider::scheduleTokenRefresh() {
+  auto lock = auth_lock();
+  auto token = auth()->access_token();
+  if (!token || token->expires_in_ <= 0 || token->refresh_token_.empty())
+    return;
+  auto expires_in = std::chrono::seconds(token->expires_in_);
+  auto generation = ++token_generation_;
+  token_expiry_ = std::chrono::system_clock::now() + expires_in;
+  auto when = token_expiry_ - std::min<std::chrono::seconds>(
+                                  expires_in / 2, TOKEN_REFRESH_LEAD);
+  lock.unlock();
+  std::weak_ptr<CloudProvider> provider = shared_from_this();
+  thread_pool()->schedule(
+      [=] {
+        auto p = provider.lock();
+        // Delayed tasks are run early when thread pool is being destroyed.
+        if (!p || std::chrono::system_clock::now() < when) return;
+        {
+          auto lock = p->auth_lock();
+          if (generation != p->token_generation_) return;
+        }
+        // Authorization in flight schedules the next refresh itself.
+        std::unique_lock<std::mutex> lock(p->current_authorization_mutex_);
+        if (p->current_authorization_) return;
+        OperationScope scope("authorize");
+        auto r = p->authorizeAsync();
+        r->set_refresh_only();
+        auto previous = std::move(p->token_refresh_);
+        lock.unlock();
+        previous = nullptr;
+        auto request = r->run();
+        lock.lock();
+        p->token_refresh_ = std::move(request);
+      },
+      when);
+}
+
+IHttpRequest::Priority CloudProvider::requestPriority() const {
+  return PriorityScope::current() ? *PriorityScope::current()
+                                  : IHttpRequest::Priority::Interactive;
+}
+
+DeadlineScope::Clock::time_point CloudProvider::requestDeadline() const {
+  if (DeadlineScope::current()) return *DeadlineScope::current();
+  if (request_timeout_.count() > 0)
+    return DeadlineScope::Clock::now() + request_timeout_;
+  return DeadlineScope::Clock::time_point::max();
+}
+
 AuthorizeRequest::Pointer CloudProvider::authorizeAsync() {
   return std::make_shared<AuthorizeRequest>(shared_from_this());
 }
@@ -389,6 +664,48 @@ void CloudProvider::cancelStreamRequests() {
   }
 }
 
+void CloudProvider::cancelPendingRequests() {
+  std::unique_lock<std::mutex> lock(pending_request_mutex_);
+  pending_cancelled_ = true;
+  std::vector<std::weak_ptr<IGenericRequest>> pending;
+  for (auto&& r : pending_requests_) pending.push_back(r.second.request_);
+  lock.unlock();
+  for (auto&& r : pending)
+    if (auto request = r.lock()) request->cancel();
+  lock.lock();
+  // Requests whose callback is destroying the provider can't be waited for.
+  auto thread = std::this_thread::get_id();
+  pending_request_removed_.wait(lock, [&] {
+    return std::all_of(
+        pending_requests_.begin(), pending_requests_.end(),
+        [&](const std::pair<const IGenericRequest* const, PendingRequest>& r) {
+          return r.second.callback_thread_ == thread;
+        });
+  });
+}
+
+void CloudProvider::addPendingRequest(
+    const std::shared_ptr<IGenericRequest>& r) {
+  std::unique_lock<std::mutex> lock(pending_request_mutex_);
+  pending_requests_[r.get()] = {r, {}};
+  if (pending_cancelled_) {
+    lock.unlock();
+    r->cancel();
+  }
+}
+
+void CloudProvider::callbackPendingRequest(const IGenericRequest* r) {
+  std::lock_guard<std::mutex> lock(pending_request_mutex_);
+  auto it = pending_requests_.find(r);
+  if (it != pending_requests_.end())
+    it->second.callback_thread_ = std::this_thread::get_id();
+}
+
+void CloudProvider::removePendingRequest(const IGenericRequest* r) {
+  std::lock_guard<std::mutex> lock(pending_request_mutex_);
+  if (pending_requests_.erase(r)) pending_request_removed_.notify_all();
+}
+
 ICloudProvider::DownloadFileRequest::Pointer
 CloudProvider::makeDownloadFileRequest(
     IItem::Pointer file, Range range,
@@ -453,7 +770,7 @@ ICloudProvider::DownloadFileRequest::Pointer CloudProvider::getThumbnailAsync(
           if (!e.left()) return r->done(nullptr);
           if (e.left()->code_ == IHttpRequest::Aborted) return r->done(e);
           r->make_subrequest(
-              &CloudProvider::getItemDataAsync, item->id(),
+              &CloudProvider::getItemDataCoalescedAsync, item->id(),
               [=](EitherError<IItem> e) {
                 if (e.left()) return r->done(e.left());
                 Item* previous_item = static_cast<Item*>(item.get());
@@ -528,6 +845,45 @@ CloudProvider::listDirectoryPageAsync(IItem::Pointer directory,
       ->run();
 }
 
+ICloudProvider::GetItemDataRequest::Pointer
+CloudProvider::getItemDataCoalescedAsync(const std::string& id,
+                                         GetItemDataCallback callback) {
+  return item_data_flights_->run(
+      id, requestPriority(), requestDeadline(), callback,
+      [=](const GetItemDataCallback& c) {
+        // Shared by callers of different operations, it's charged to its own.
+        OperationScope scope("getItemData");
+        return getItemDataAsync(id, c);
+      });
+}
+
+ICloudProvider::ListDirectoryPageRequest::Pointer
+CloudProvider::listDirectoryPageStreamAsync(
+    IItem::Pointer directory, const std::string& token,
+    const ListingStream::ItemCallback& sink,
+    ListDirectoryPageCallback completed) {
+  if (!sink || !listDirectoryStreamable(*directory))
+    return listDirectoryPageAsync(directory, token, completed);
+  return std::make_shared<cloudstorage::ListDirectoryPageRequest>(
+             shared_from_this(), directory, token, completed, sink)
+      ->run();
+}
+
+ICloudProvider::ListDirectoryPageRequest::Pointer
+CloudProvider::listDirectoryPageCoalescedAsync(
+    IItem::Pointer directory, const std::string& token,
+    const ListingStream::ItemCallback& sink,
+    ListDirectoryPageCallback callback) {
+  auto key = std::to_string(directory->id().size()) + ":" + directory->id() +
+             token;
+  return page_flights_->run(
+      key, requestPriority(), requestDeadline(), callback,
+      [=](const ListDirectoryPageCallback& c) {
+        OperationScope scope("listDirectoryPage");
+        return listDirectoryPageStreamAsync(directory, token, sink, c);
+      });
+}
+
 ICloudProvider::ListDirectoryRequest::Pointer
 CloudProvider::listDirectorySimpleAsync(IItem::Pointer item,
                                         ListDirectoryCallback callback) {
@@ -613,11 +969,32 @@ ICloudProvider::GetItemUrlRequest::Pointer CloudProvider::getFileDaemonUrlAsync(
       ->run();
 }
 
+ICloudProvider::ChangesRequest::Pointer CloudProvider::changesAsync(
+    const std::string& cursor, ChangesCallback callback) {
+  return std::make_shared<cloudstorage::ChangesRequest>(shared_from_this(),
+                                                        cursor, callback)
+      ->run();
+}
+
+void CloudProvider::subscribeChanges(IChangesListener::Pointer listener) {
+  changes_notifier_->subscribe(std::move(listener));
+}
+
+void CloudProvider::unsubscribeChanges(
+    const IChangesListener::Pointer& listener) {
+  changes_notifier_->unsubscribe(listener);
+}
+
 IHttpRequest::Pointer CloudProvider::getItemDataRequest(const std::string&,
                                                         std::ostream&) const {
   return nullptr;
 }
 
+IHttpRequest::Pointer CloudProvider::getItemByPathRequest(
+    const std::string&, std::ostream&) const {
+  return nullptr;
+}
+
 IHttpRequest::Pointer CloudProvider::getItemUrlRequest(
     const IItem& item, std::ostream& stream) const {
   return getItemDataRequest(item.id(), stream);
@@ -674,6 +1051,16 @@ IHttpRequest::Pointer CloudProvider::getGeneralDataRequest(
   return nullptr;
 }
 
+IHttpRequest::Pointer CloudProvider::changesRequest(const std::string&,
+                                                    std::ostream&) const {
+  return nullptr;
+}
+
+IHttpRequest::Pointer CloudProvider::longPollRequest(const std::string&,
+                                                     std::ostream&) const {
+  return nullptr;
+}
+
 IItem::Pointer CloudProvider::getItemDataResponse(std::istream&) const {
   return nullptr;
 }
@@ -699,17 +1086,82 @@ GeneralData CloudProvider::getGeneralDataResponse(std::istream&) const {
   return {};
 }
 
+std::vector<Change> CloudProvider::changesResponse(std::istream&,
+                                                   std::string&, bool&) const {
+  return {};
+}
+
+bool CloudProvider::longPollResponse(std::istream&,
+                                     std::chrono::milliseconds&) const {
+  return true;
+}
+
 std::string CloudProvider::getItemUrlResponse(
     const IItem&, const IHttpRequest::HeaderParameters&,
     std::istream& stream) const {
   return std::static_pointer_cast<Item>(getItemDataResponse(stream))->url();
 }
 
-IItem::List CloudProvider::listDirectoryResponse(const IItem&, std::istream&,
-                                                 std::string&) const {
+IItem::List CloudProvider::listDirectoryResponse(
+    const IItem& directory, std::istream& stream,
+    std::string& next_page_token) const {
+  IItem::List result;
+  auto parser = listDirectoryStream(
+      directory, [&](IItem::Pointer item) { result.push_back(item); });
+  if (!parser) return {};
+  std::string storage;
+  auto data = util::contents(stream, storage);
+  parser->write(data.data_, static_cast<std::streamsize>(data.size_));
+  for (auto&& item : parser->finish(next_page_token)) result.push_back(item);
+  return result;
+}
+
+std::unique_ptr<CloudProvider::ListingStream>
+CloudProvider::listDirectoryStream(
+    const IItem& directory, const ListingStream::ItemCallback& callback) const {
+  std::vector<std::string> path;
+  if (!listDirectoryItemsPath(directory, path)) return nullptr;
+  auto buffer = util::make_unique<util::JsonBuffer>(
+      std::move(path), [=, &directory](const Json::Value& v) {
+        callback(listDirectoryItem(directory, v));
+      });
+  auto json = buffer.get();
+  return util::make_unique<ListingStream>(
+      std::move(buffer), [=, &directory](std::string& next_page_token) {
+        return listDirectoryRest(directory, json->finish(), next_page_token);
+      });
+}
+
+bool CloudProvider::listDirectoryStreamable(const IItem& directory) const {
+  std::vector<std::string> path;
+  return listDirectoryItemsPath(directory, path);
+}
+
+bool CloudProvider::listDirectoryItemsPath(const IItem&,
+                                           std::vector<std::string>&) const {
+  return false;
+}
+
+IItem::Pointer CloudProvider::listDirectoryItem(const IItem&,
+                                                const Json::Value&) const {
+  throw std::logic_error(util::Error::UNIMPLEMENTED);
+}
+
+IItem::List CloudProvider::listDirectoryRest(const IItem&, const Json::Value&,
+                                             std::string&) const {
   return {};
 }
 
+CloudProvider::ListingStream::ListingStream(
+    std::unique_ptr<std::streambuf> buffer, Finish finish)
+    : std::ostream(buffer.get()),
+      buffer_(std::move(buffer)),
+      finish_(std::move(finish)) {}
+
+IItem::List CloudProvider::ListingStream::finish(std::string& next_page_token) {
+  return finish_(next_page_token);
+}
+
 IItem::Pointer CloudProvider::createDirectoryResponse(
     const IItem&, const std::string&, std::istream& stream) const {
   return getItemDataResponse(stream);
@@ -24,15 +24,25 @@
 #ifndef CLOUDPROVIDER_H
 #define CLOUDPROVIDER_H
 
+#include <json/json.h>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <mutex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "ICloudProvider.h"
+#include "IMetrics.h"
 #include "Request/AuthorizeRequest.h"
 #include "Utility/Auth.h"
+#include "Utility/ChangesNotifier.h"
+#include "Utility/ConcurrencyLimit.h"
+#include "Utility/HedgePolicy.h"
+#include "Utility/MetadataCache.h"
+#include "Utility/SingleFlight.h"
 
 namespace cloudstorage {
 
@@ -41,6 +51,32 @@ class CloudProvider : public ICloudProvider,
  public:
   using Pointer = std::shared_ptr<CloudProvider>;
 
+  /**
+   * Stream parsing listing response while it is being received.
+   */
+  class ListingStream : public std::ostream {
+   public:
+    using ItemCallback = std::function<void(IItem::Pointer)>;
+    using Finish = std::function<IItem::List(std::string& next_page_token)>;
+
+    ListingStream(std::unique_ptr<std::streambuf>, Finish);
+
+    /**
+     * Should be called once the whole response was written, throws if it was
+     * malformed.
+     *
+     * @param next_page_token should be set to string describing the next page
+     * or to empty string if there is no next page
+     *
+     * @return items which weren't passed to the item callback
+     */
+    IItem::List finish(std::string& next_page_token);
+
+   private:
+    std::unique_ptr<std::streambuf> buffer_;
+    Finish finish_;
+  };
+
   CloudProvider(IAuth::Pointer);
 
   virtual void initialize(InitData&&);
@@ -53,16 +89,69 @@ class CloudProvider : public ICloudProvider,
   std::string authorizeLibraryUrl() const override;
   std::string token() const override;
   IItem::Pointer rootDirectory() const override;
+  IThrottle::Pointer throttle() const override;
   OperationSet supportedOperations() const override;
   ICrypto* crypto() const;
   IHttp* http() const;
   IHttpServerFactory* http_server() const;
   IThreadPool* thread_pool() const;
   IAuthCallback* auth_callback() const;
+
+  /**
+   * Cache configured with provider's cache_* hints, shared by the file daemon
+   * and CachedCloudProvider.
+   */
+  const MetadataCache::Pointer& metadata_cache() const;
+
+  /**
+   * Attaches provider's throttles to the request.
+   */
+  void throttle(IHttpRequest*) const;
+
+  /**
+   * @param operation one of the OperationScope names
+   * @return IMetrics key transfers done for the operation are recorded under,
+   * interned once per operation
+   */
+  IMetrics::Key metricsKey(const char* operation) const;
   std::string file_url() const;
 
   virtual bool isSuccess(int code, const IHttpRequest::HeaderParameters&) const;
 
+  /**
+   * Returns whether the server asked to slow down; requests which got such
+   * response shrink provider's concurrency limit.
+   *
+   * @param code http code
+   * @return whether the request was throttled
+   */
+  virtual bool isThrottled(int code,
+                           const IHttpRequest::HeaderParameters&) const;
+
+  /**
+   * Returns whether request which failed with http code may succeed when sent
+   * again later. Throttled requests are always retried; server errors and
+   * timeouts only for idempotent methods, as the server may have applied the
+   * request before failing.
+   *
+   * @param method http method of the request
+   * @param code http code
+   * @return whether to retry the request
+   */
+  virtual bool isRetryable(const std::string& method, int code,
+                           const IHttpRequest::HeaderParameters&) const;
+
+  /**
+   * Computes how long to wait before sending the request again: as long as
+   * Retry-After header says, otherwise exponential backoff with full jitter.
+   * Retry-After may exceed retry_max_delay_, retry() gives up then.
+   *
+   * @param attempt count of attempts which failed so far
+   * @return delay
+   */
+  std::chrono::milliseconds retryDelay(
+      uint32_t attempt, const IHttpRequest::HeaderParameters&) const;
+
   virtual AuthorizeRequest::Pointer authorizeAsync();
 
   GetItemUrlRequest::Pointer getItemUrlAsync(IItem::Pointer,
@@ -71,6 +160,8 @@ class CloudProvider : public ICloudProvider,
                                                  ExchangeCodeCallback) override;
   ListDirectoryRequest::Pointer listDirectoryAsync(
       IItem::Pointer, IListDirectoryCallback::Pointer) override;
+  StreamDirectoryRequest::Pointer streamDirectoryAsync(
+      IItem::Pointer, IStreamDirectoryCallback::Pointer) override;
   GetItemRequest::Pointer getItemAsync(const std::string& absolute_path,
                                        GetItemCallback) override;
   DownloadFileRequest::Pointer downloadFileAsync(IItem::Pointer,
@@ -111,6 +202,10 @@ class CloudProvider : public ICloudProvider,
   GeneralDataRequest::Pointer getGeneralDataAsync(GeneralDataCallback) override;
   GetItemUrlRequest::Pointer getFileDaemonUrlAsync(IItem::Pointer,
                                                    GetItemUrlCallback) override;
+  ChangesRequest::Pointer changesAsync(const std::string& cursor,
+                                       ChangesCallback) override;
+  void subscribeChanges(IChangesListener::Pointer) override;
+  void unsubscribeChanges(const IChangesListener::Pointer&) override;
 
   /**
    * Used by default implementation of getItemDataAsync.
@@ -122,6 +217,19 @@ class CloudProvider : public ICloudProvider,
   virtual IHttpRequest::Pointer getItemDataRequest(
       const std::string& id, std::ostream& input_stream) const;
 
+  /**
+   * Used by default implementation of getItemAsync, for providers which can
+   * address items by path. Response is parsed with getItemDataResponse.
+   * Returns nullptr by default, then getItemAsync lists each directory on the
+   * path.
+   *
+   * @param path absolute path, without trailing slash
+   * @param input_stream request body
+   * @return http request
+   */
+  virtual IHttpRequest::Pointer getItemByPathRequest(
+      const std::string& path, std::ostream& input_stream) const;
+
   virtual IHttpRequest::Pointer getItemUrlRequest(
       const IItem&, std::ostream& input_stream) const;
 
@@ -211,6 +319,32 @@ class CloudProvider : public ICloudProvider,
 
   virtual IHttpRequest::Pointer getGeneralDataRequest(std::ostream&) const;
 
+  /**
+   * Used by default implementation of changesAsync, for providers with a feed
+   * of changes. Returns nullptr by default, then changesAsync compares
+   * listings of cached directories with fresh ones.
+   *
+   * @param cursor cursor of the page of changes, empty if querying for the
+   * cursor denoting current state
+   * @param input_stream request body
+   * @return http request
+   */
+  virtual IHttpRequest::Pointer changesRequest(
+      const std::string& cursor, std::ostream& input_stream) const;
+
+  /**
+   * Used by subscribeChanges, for providers able to notify about changes.
+   * Should make request which completes once there are changes after the
+   * cursor or its timeout elapses; it's sent without authorization. Returns
+   * nullptr by default, then changesAsync is queried every changes_interval.
+   *
+   * @param cursor cursor returned by changesAsync
+   * @param input_stream request body
+   * @return http request
+   */
+  virtual IHttpRequest::Pointer longPollRequest(
+      const std::string& cursor, std::ostream& input_stream) const;
+
   /**
    * Used by default implementation of getItemDataAsync, should translate
    * reponse into IItem object.
@@ -239,6 +373,60 @@ class CloudProvider : public ICloudProvider,
                                             std::istream& response,
                                             std::string& next_page_token) const;
 
+  /**
+   * Used by listDirectoryAsync and default implementation of
+   * listDirectoryResponse, items should be passed to the callback as soon as
+   * they are parsed. Default implementation parses json responses with
+   * listDirectoryItemsPath, listDirectoryItem and listDirectoryRest.
+   *
+   * @param directory has to outlive the stream
+   *
+   * @return stream parsing the response or nullptr if listing responses can't
+   * be parsed incrementally
+   */
+  virtual std::unique_ptr<ListingStream> listDirectoryStream(
+      const IItem& directory, const ListingStream::ItemCallback&) const;
+
+  /**
+   * Tells whether listDirectoryStream returns a stream without building one;
+   * has to be overridden along with it. Default implementation checks
+   * listDirectoryItemsPath.
+   */
+  virtual bool listDirectoryStreamable(const IItem& directory) const;
+
+  /**
+   * Providers listing directories with json responses should point at the
+   * array of items here, so that items are parsed one at a time, while the
+   * response is still being received; listDirectoryResponse and
+   * listDirectoryStream then don't have to be overridden.
+   *
+   * @param path set to keys of the objects leading to the array of items
+   *
+   * @return whether listing responses can be parsed incrementally
+   */
+  virtual bool listDirectoryItemsPath(const IItem& directory,
+                                      std::vector<std::string>& path) const;
+
+  /**
+   * Used by incremental listing, should translate element of the array of
+   * items into IItem object.
+   */
+  virtual IItem::Pointer listDirectoryItem(const IItem& directory,
+                                           const Json::Value& item) const;
+
+  /**
+   * Used by incremental listing, called with the response without the array
+   * of items once it was received.
+   *
+   * @param next_page_token should be set to string describing the next page or
+   * to empty string if there is no next page
+   *
+   * @return items which should be appended to the listing
+   */
+  virtual IItem::List listDirectoryRest(const IItem& directory,
+                                        const Json::Value& response,
+                                        std::string& next_page_token) const;
+
   virtual IItem::Pointer renameItemResponse(const IItem& old_item,
                                             const std::string& name,
                                             std::istream& response) const;
@@ -252,6 +440,40 @@ class CloudProvider : public ICloudProvider,
                                             std::istream& response) const;
   virtual GeneralData getGeneralDataResponse(std::istream& response) const;
 
+  /**
+   * Used by default implementation of changesAsync, should extract changes
+   * from response. Items which were added, modified or moved should be
+   * reported as Change::Type::Modify, changesAsync tells them apart with the
+   * metadata cache.
+   *
+   * @param response
+   *
+   * @param cursor cursor the response was requested with; should be set to
+   * cursor of the next page or, if there is no next page, to cursor which
+   * will return later changes
+   *
+   * @param more should be set to whether there is next page
+   *
+   * @return changes
+   */
+  virtual std::vector<Change> changesResponse(std::istream& response,
+                                              std::string& cursor,
+                                              bool& more) const;
+
+  /**
+   * Used by subscribeChanges, should tell whether long poll's response
+   * reported changes.
+   *
+   * @param response
+   *
+   * @param backoff should be set to how long the server asked to wait before
+   * the next request, if it did
+   *
+   * @return whether there are changes after the cursor
+   */
+  virtual bool longPollResponse(std::istream& response,
+                                std::chrono::milliseconds& backoff) const;
+
   /**
    * Used by default implementation of createDirectoryAsync, should translate
    * response into new directory's item object.
@@ -298,12 +520,44 @@ class CloudProvider : public ICloudProvider,
   DownloadFileRequest::Pointer downloadFileRangeAsync(
       IItem::Pointer, Range, IDownloadFileCallback::Pointer);
 
+  /**
+   * Same as getItemDataAsync, but attaches to identical request which is
+   * already in flight instead of sending another one.
+   */
+  GetItemDataRequest::Pointer getItemDataCoalescedAsync(const std::string& id,
+                                                        GetItemDataCallback);
+
+  /**
+   * Same as listDirectoryPageAsync, but items are also passed to sink while
+   * the response is being received, if the provider can parse it that way.
+   */
+  ListDirectoryPageRequest::Pointer listDirectoryPageStreamAsync(
+      IItem::Pointer, const std::string& token,
+      const ListingStream::ItemCallback& sink, ListDirectoryPageCallback);
+
+  /**
+   * Same as listDirectoryPageStreamAsync, but attaches to identical request
+   * which is already in flight instead of sending another one; sink is used
+   * only if the request is sent, callers attached to it get all items with
+   * the page.
+   */
+  ListDirectoryPageRequest::Pointer listDirectoryPageCoalescedAsync(
+      IItem::Pointer, const std::string& token,
+      const ListingStream::ItemCallback& sink, ListDirectoryPageCallback);
+
  protected:
   void setWithHint(const Hints& hints, const std::string& name,
                    const std::function<void(std::string)>&) const;
   std::string defaultFileDaemonUrl(const IItem& item, uint64_t size) const;
   void cancelStreamRequests();
 
+  /**
+   * Cancels requests which didn't call back yet and waits until they do, so
+   * that members released afterwards are no longer used by their callbacks.
+   * Requests started later are cancelled right away.
+   */
+  void cancelPendingRequests();
+
  private:
   friend class AuthorizeRequest;
   template <class T>
@@ -314,13 +568,56 @@ class CloudProvider : public ICloudProvider,
       std::function<IHttpRequest::Pointer(const IItem&, std::ostream&)>,
       IDownloadFileCallback::Pointer);
 
+  /**
+   * Schedules authorization shortly before current access token expires, so
+   * that requests don't have to fail with 401 first. Requests sent in the
+   * meantime keep using the old token, which is still valid.
+   */
+  void scheduleTokenRefresh();
+
+  /**
+   * @return priority of an interactive request started now on the current
+   * thread
+   */
+  IHttpRequest::Priority requestPriority() const;
+
+  /**
+   * @return deadline of a request started now on the current thread
+   */
+  DeadlineScope::Clock::time_point requestDeadline() const;
+
+  struct PendingRequest {
+    std::weak_ptr<IGenericRequest> request_;
+    std::thread::id callback_thread_;  // set while its callback runs
+  };
+
+  void addPendingRequest(const std::shared_ptr<IGenericRequest>&);
+  void callbackPendingRequest(const IGenericRequest*);
+  void removePendingRequest(const IGenericRequest*);
+
   IAuth::Pointer auth_;
   IAuthCallback::Pointer callback_;
   ICrypto::Pointer crypto_;
   IHttp::Pointer http_;
   IHttpServerFactory::Pointer http_server_;
   IThreadPool::Pointer thread_pool_;
+  IThrottle::Pointer throttle_;
+  IThrottle::Pointer shared_throttle_;
+  uint32_t retry_attempts_;
+  std::chrono::milliseconds retry_base_delay_;
+  std::chrono::milliseconds retry_max_delay_;
+  std::chrono::milliseconds request_timeout_;
+  mutable ConcurrencyLimit concurrency_limit_;
+  mutable HedgePolicy hedge_policy_;
+  mutable std::unordered_map<const char*, IMetrics::Key> metrics_keys_;
+  SingleFlight<EitherError<IItem>>::Pointer item_data_flights_;
+  SingleFlight<EitherError<PageData>>::Pointer page_flights_;
+  MetadataCache::Pointer metadata_cache_;
+  ChangesNotifier::Pointer changes_notifier_;
   AuthorizeRequest::Pointer current_authorization_;
+  IRequest<EitherError<void>>::Pointer token_refresh_;
+  uint64_t token_generation_;
+  std::chrono::system_clock::time_point token_expiry_;
   std::unordered_map<IGenericRequest*,
                      std::vector<AuthorizeRequest::AuthorizeCompleted>>
       auth_callbacks_;
@@ -328,10 +625,15 @@ class CloudProvider : public ICloudProvider,
       stream_requests_;
   std::string file_url_;
   IHttpServer::Pointer file_daemon_;
+  std::unordered_map<const IGenericRequest*, PendingRequest> pending_requests_;
   std::mutex stream_request_mutex_;
+  std::mutex pending_request_mutex_;
+  std::condition_variable pending_request_removed_;
   std::mutex current_authorization_mutex_;
   mutable std::mutex auth_mutex_;
+  mutable std::mutex metrics_keys_mutex_;
   bool deleted_;
+  bool pending_cancelled_;
 };
 
 }  // namespace cloudstorage
@@ -33,6 +33,9 @@
 #include "Request/Request.h"
 
 const std::string DROPBOXAPI_ENDPOINT = "https://api.dropboxapi.com";
+const std::string DROPBOXNOTIFY_ENDPOINT = "https://notify.dropboxapi.com";
+// In seconds, the server adds up to 90 seconds of random jitter to it.
+const int LONG_POLL_TIMEOUT = 120;
 const int CHUNK_SIZE = 60 * 1024 * 1024;
 
 namespace cloudstorage {
@@ -86,7 +89,7 @@ void upload(const Request<EitherError<IItem>>::Pointer& r,
         }
       },
       [] { return std::make_shared<std::stringstream>(); },
-      std::make_shared<std::stringstream>(), nullptr,
+      nullptr, nullptr,
       [=](uint64_t, uint64_t now) { callback->progress(size, sent + now); },
       true);
 }
@@ -98,6 +101,8 @@ std::string Dropbox::name() const { return "dropbox"; }
 
 std::string Dropbox::endpoint() const { return DROPBOXAPI_ENDPOINT; }
 
+std::string Dropbox::notifyEndpoint() const { return DROPBOXNOTIFY_ENDPOINT; }
+
 IItem::Pointer Dropbox::rootDirectory() const {
   return util::make_unique<Item>("/", "", IItem::UnknownSize,
                                  IItem::UnknownTimeStamp,
@@ -189,6 +194,11 @@ IHttpRequest::Pointer Dropbox::getItemDataRequest(const std::string& id,
   return request;
 }
 
+IHttpRequest::Pointer Dropbox::getItemByPathRequest(
+    const std::string& path, std::ostream& input) const {
+  return getItemDataRequest(path, input);
+}
+
 IItem::Pointer Dropbox::getItemDataResponse(std::istream& stream) const {
   return toItem(util::json::from_stream(stream));
 }
@@ -292,15 +302,24 @@ IHttpRequest::Pointer Dropbox::renameItemRequest(const IItem& item,
   return request;
 }
 
-IItem::List Dropbox::listDirectoryResponse(const IItem&, std::istream& stream,
-                                           std::string& next_page_token) const {
-  auto response = util::json::from_stream(stream);
-  IItem::List result;
-  for (const Json::Value& v : response["entries"]) result.push_back(toItem(v));
+bool Dropbox::listDirectoryItemsPath(const IItem&,
+                                     std::vector<std::string>& path) const {
+  path = {"entries"};
+  return true;
+}
+
+IItem::Pointer Dropbox::listDirectoryItem(const IItem&,
+                                          const Json::Value& v) const {
+  return toItem(v);
+}
+
+IItem::List Dropbox::listDirectoryRest(const IItem&,
+                                       const Json::Value& response,
+                                       std::string& next_page_token) const {
   if (response["has_more"].asBool()) {
     next_page_token = response["cursor"].asString();
   }
-  return result;
+  return {};
 }
 
 IItem::Pointer Dropbox::createDirectoryResponse(const IItem&,
@@ -325,6 +344,63 @@ IItem::Pointer Dropbox::moveItemResponse(const IItem& source, const IItem&,
   return item;
 }
 
+IHttpRequest::Pointer Dropbox::changesRequest(
+    const std::string& cursor, std::ostream& input_stream) const {
+  IHttpRequest::Pointer request;
+  Json::Value parameter;
+  if (cursor.empty()) {
+    request = http()->create(
+        endpoint() + "/2/files/list_folder/get_latest_cursor", "POST");
+    parameter["path"] = "";
+    parameter["recursive"] = true;
+    parameter["include_deleted"] = true;
+  } else {
+    request =
+        http()->create(endpoint() + "/2/files/list_folder/continue", "POST");
+    parameter["cursor"] = cursor;
+  }
+  request->setHeaderParameter("Content-Type", "application/json");
+  input_stream << util::json::to_string(parameter);
+  return request;
+}
+
+std::vector<Change> Dropbox::changesResponse(std::istream& response,
+                                             std::string& cursor,
+                                             bool& more) const {
+  auto json = util::json::from_stream(response);
+  std::vector<Change> result;
+  for (const auto& v : json["entries"]) {
+    if (v[".tag"].asString() == "deleted")
+      result.push_back({Change::Type::Delete, toItem(v), {}});
+    else
+      result.push_back({Change::Type::Modify, toItem(v),
+                        {getPath(v["path_display"].asString())}});
+  }
+  cursor = json["cursor"].asString();
+  more = json["has_more"].asBool();
+  return result;
+}
+
+IHttpRequest::Pointer Dropbox::longPollRequest(const std::string& cursor,
+                                               std::ostream& input) const {
+  auto request = http()->create(
+      notifyEndpoint() + "/2/files/list_folder/longpoll", "POST");
+  request->setHeaderParameter("Content-Type", "application/json");
+  Json::Value parameter;
+  parameter["cursor"] = cursor;
+  parameter["timeout"] = LONG_POLL_TIMEOUT;
+  input << util::json::to_string(parameter);
+  return request;
+}
+
+bool Dropbox::longPollResponse(std::istream& response,
+                               std::chrono::milliseconds& backoff) const {
+  auto json = util::json::from_stream(response);
+  if (json.isMember("backoff"))
+    backoff = std::chrono::seconds(json["backoff"].asInt64());
+  return json["changes"].asBool();
+}
+
 IItem::Pointer Dropbox::toItem(const Json::Value& v) {
   IItem::FileType type = IItem::FileType::Unknown;
   if (v[".tag"].asString() == "folder") type = IItem::FileType::Directory;
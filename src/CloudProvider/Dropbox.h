@@ -36,6 +36,12 @@ class Dropbox : public CloudProvider {
 
   std::string name() const override;
   std::string endpoint() const override;
+
+  /**
+   * @return base url of the long poll endpoint
+   */
+  virtual std::string notifyEndpoint() const;
+
   IItem::Pointer rootDirectory() const override;
   bool reauthorize(int code,
                    const IHttpRequest::HeaderParameters&) const override;
@@ -48,6 +54,8 @@ class Dropbox : public CloudProvider {
       const IItem&, std::ostream& input_stream) const override;
   IHttpRequest::Pointer getItemDataRequest(
       const std::string&, std::ostream& input_stream) const override;
+  IHttpRequest::Pointer getItemByPathRequest(
+      const std::string&, std::ostream& input_stream) const override;
   IHttpRequest::Pointer listDirectoryRequest(
       const IItem&, const std::string& page_token,
       std::ostream& input_stream) const override;
@@ -65,9 +73,17 @@ class Dropbox : public CloudProvider {
   IHttpRequest::Pointer renameItemRequest(const IItem& item,
                                           const std::string& name,
                                           std::ostream&) const override;
+  IHttpRequest::Pointer changesRequest(const std::string& cursor,
+                                       std::ostream&) const override;
+  IHttpRequest::Pointer longPollRequest(const std::string& cursor,
+                                        std::ostream&) const override;
 
-  IItem::List listDirectoryResponse(
-      const IItem&, std::istream&, std::string& next_page_token) const override;
+  bool listDirectoryItemsPath(const IItem&,
+                              std::vector<std::string>& path) const override;
+  IItem::Pointer listDirectoryItem(const IItem&,
+                                   const Json::Value&) const override;
+  IItem::List listDirectoryRest(const IItem&, const Json::Value&,
+                                std::string& next_page_token) const override;
   std::string getItemUrlResponse(const IItem& item,
                                  const IHttpRequest::HeaderParameters&,
                                  std::istream& response) const override;
@@ -80,6 +96,11 @@ class Dropbox : public CloudProvider {
                                     std::istream& response) const override;
   IItem::Pointer moveItemResponse(const IItem&, const IItem&,
                                   std::istream&) const override;
+  std::vector<Change> changesResponse(std::istream& response,
+                                      std::string& cursor,
+                                      bool& more) const override;
+  bool longPollResponse(std::istream& response,
+                        std::chrono::milliseconds& backoff) const override;
   void authorizeRequest(IHttpRequest&) const override;
 
   static IItem::Pointer toItem(const Json::Value&);
@@ -26,6 +26,7 @@
 #include <json/json.h>
 #include <algorithm>
 #include <cstring>
+#include <iterator>
 #include <sstream>
 
 #include "Request/DownloadFileRequest.h"
@@ -187,7 +188,9 @@ ICloudProvider::DownloadFileRequest::Pointer GoogleDrive::downloadFileAsync(
   }
   return std::make_shared<cloudstorage::DownloadFileRequest>(
              shared_from_this(), std::move(file), std::move(callback), range,
-             std::bind(&CloudProvider::downloadFileRequest, this, _1, _2))
+             [this](const IItem& item, std::ostream& input) {
+               return downloadFileRequest(item, input);
+             })
       ->run();
 }
 
@@ -229,7 +232,7 @@ ICloudProvider::UploadFileRequest::Pointer GoogleDrive::uploadFileAsync(
             }
           },
           [=] { return std::make_shared<std::iostream>(stream_wrapper.get()); },
-          std::make_shared<std::stringstream>(), nullptr,
+          nullptr, nullptr,
           std::bind(&IUploadFileCallback::progress, cb, _1, _2), true);
     };
     r->make_subrequest(&GoogleDrive::listDirectorySimpleAsync, directory,
@@ -300,16 +303,47 @@ IHttpRequest::Pointer GoogleDrive::getGeneralDataRequest(std::ostream&) const {
   return request;
 }
 
+// Cursor is "<root id>:<page token>"; changes report the real id of the root
+// directory as parent, it's translated to the alias used by rootDirectory.
+IHttpRequest::Pointer GoogleDrive::changesRequest(const std::string& cursor,
+                                                  std::ostream&) const {
+  auto separator = cursor.find(':');
+  if (separator == std::string::npos) {
+    auto request = http()->create(endpoint() + "/drive/v3/files/root", "GET");
+    request->setParameter("fields", "id");
+    return request;
+  }
+  if (separator + 1 == cursor.size())
+    return http()->create(endpoint() + "/drive/v3/changes/startPageToken");
+  auto request = http()->create(endpoint() + "/drive/v3/changes", "GET");
+  request->setParameter("pageToken", cursor.substr(separator + 1));
+  request->setParameter("includeRemoved", "true");
+  request->setParameter("fields",
+                        "changes(fileId,removed,file(id,name,thumbnailLink,"
+                        "trashed,mimeType,iconLink,parents,size,modifiedTime)),"
+                        "nextPageToken,newStartPageToken");
+  return request;
+}
+
 IItem::Pointer GoogleDrive::getItemDataResponse(std::istream& response) const {
   return toItem(util::json::from_stream(response));
 }
 
-IItem::List GoogleDrive::listDirectoryResponse(
-    const IItem& item, std::istream& stream,
-    std::string& next_page_token) const {
-  auto response = util::json::from_stream(stream);
+bool GoogleDrive::listDirectoryItemsPath(const IItem&,
+                                         std::vector<std::string>& path) const {
+  path = {"files"};
+  return true;
+}
+
+IItem::Pointer GoogleDrive::listDirectoryItem(const IItem&,
+                                              const Json::Value& v) const {
+  return toItem(v);
+}
+
+IItem::List GoogleDrive::listDirectoryRest(const IItem& item,
+                                           const Json::Value& response,
+                                           std::string& next_page_token) const {
   IItem::List result;
-  for (const auto& v : response["files"]) result.push_back(toItem(v));
   if (item.id() == rootDirectory()->id())
     result.push_back(util::make_unique<Item>(
         SHARED_FILENAME, SHARED_ID, IItem::UnknownSize, IItem::UnknownTimeStamp,
@@ -335,6 +369,46 @@ GeneralData GoogleDrive::getGeneralDataResponse(std::istream& response) const {
   return data;
 }
 
+std::vector<Change> GoogleDrive::changesResponse(std::istream& response,
+                                                 std::string& cursor,
+                                                 bool& more) const {
+  auto json = util::json::from_stream(response);
+  std::vector<Change> result;
+  auto separator = cursor.find(':');
+  if (separator == std::string::npos) {
+    cursor = json["id"].asString() + ":";
+    more = true;
+    return result;
+  }
+  auto root = cursor.substr(0, separator);
+  if (separator + 1 == cursor.size()) {
+    cursor = root + ":" + json["startPageToken"].asString();
+    return result;
+  }
+  for (const auto& v : json["changes"]) {
+    if (!v.isMember("fileId")) continue;
+    if (v["removed"].asBool() || !v.isMember("file")) {
+      result.push_back({Change::Type::Delete,
+                        util::make_unique<Item>(
+                            "", v["fileId"].asString(), IItem::UnknownSize,
+                            IItem::UnknownTimeStamp, IItem::FileType::Unknown),
+                        {}});
+    } else {
+      std::vector<std::string> parents;
+      for (const auto& id : v["file"]["parents"]) {
+        parents.push_back(id.asString());
+        if (id.asString() == root) parents.push_back(rootDirectory()->id());
+      }
+      result.push_back({Change::Type::Modify, toItem(v["file"]), parents});
+    }
+  }
+  more = json.isMember("nextPageToken");
+  const auto& token =
+      more ? json["nextPageToken"] : json["newStartPageToken"];
+  cursor = root + ":" + token.asString();
+  return result;
+}
+
 IHttpRequest::Pointer GoogleDrive::upload(const IItem& f,
                                           const std::string& url,
                                           const std::string& method,
@@ -370,16 +444,18 @@ IHttpRequest::Pointer GoogleDrive::upload(const IItem& f,
 }
 
 bool GoogleDrive::isGoogleMimeType(const std::string& mime_type) const {
-  std::vector<std::string> types = {"application/vnd.google-apps.document",
-                                    "application/vnd.google-apps.drawing",
-                                    "application/vnd.google-apps.form",
-                                    "application/vnd.google-apps.fusiontable",
-                                    "application/vnd.google-apps.map",
-                                    "application/vnd.google-apps.presentation",
-                                    "application/vnd.google-apps.script",
-                                    "application/vnd.google-apps.sites",
-                                    "application/vnd.google-apps.spreadsheet"};
-  return std::find(types.begin(), types.end(), mime_type) != types.end();
+  static const char* const types[] = {
+      "application/vnd.google-apps.document",
+      "application/vnd.google-apps.drawing",
+      "application/vnd.google-apps.form",
+      "application/vnd.google-apps.fusiontable",
+      "application/vnd.google-apps.map",
+      "application/vnd.google-apps.presentation",
+      "application/vnd.google-apps.script",
+      "application/vnd.google-apps.sites",
+      "application/vnd.google-apps.spreadsheet"};
+  return std::find(std::begin(types), std::end(types), mime_type) !=
+         std::end(types);
 }
 
 IItem::FileType GoogleDrive::toFileType(const std::string& mime_type) const {
@@ -66,14 +66,23 @@ class GoogleDrive : public CloudProvider {
   IHttpRequest::Pointer renameItemRequest(const IItem&, const std::string& name,
                                           std::ostream&) const override;
   IHttpRequest::Pointer getGeneralDataRequest(std::ostream&) const override;
+  IHttpRequest::Pointer changesRequest(const std::string& cursor,
+                                       std::ostream&) const override;
 
   IItem::Pointer getItemDataResponse(std::istream& response) const override;
   std::string getItemUrlResponse(const IItem& item,
                                  const IHttpRequest::HeaderParameters&,
                                  std::istream& response) const override;
-  IItem::List listDirectoryResponse(
-      const IItem&, std::istream&, std::string& next_page_token) const override;
+  bool listDirectoryItemsPath(const IItem&,
+                              std::vector<std::string>& path) const override;
+  IItem::Pointer listDirectoryItem(const IItem&,
+                                   const Json::Value&) const override;
+  IItem::List listDirectoryRest(const IItem&, const Json::Value&,
+                                std::string& next_page_token) const override;
   GeneralData getGeneralDataResponse(std::istream& response) const override;
+  std::vector<Change> changesResponse(std::istream& response,
+                                      std::string& cursor,
+                                      bool& more) const override;
 
   IHttpRequest::Pointer upload(const IItem& f, const std::string& url,
                                const std::string& method,
@@ -857,6 +857,7 @@ std::string MegaNz::endpoint() const { return file_url(); }
 
 void MegaNz::destroy() {
   cancelStreamRequests();
+  cancelPendingRequests();
   mega_ = nullptr;
   CloudProvider::destroy();
 }
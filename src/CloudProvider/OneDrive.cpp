@@ -67,7 +67,7 @@ void upload(const Request<EitherError<IItem>>::Pointer& r,
         }
       },
       [] { return std::make_shared<std::stringstream>(); },
-      std::make_shared<std::stringstream>(), nullptr,
+      nullptr, nullptr,
       [=](uint64_t, uint64_t now) { callback->progress(size, sent + now); },
       true);
 }
@@ -208,6 +208,17 @@ IHttpRequest::Pointer OneDrive::getItemDataRequest(const std::string& id,
   return request;
 }
 
+IHttpRequest::Pointer OneDrive::getItemByPathRequest(
+    const std::string& path, std::ostream&) const {
+  IHttpRequest::Pointer request = http()->create(
+      endpoint() + "/drive/root:" + util::Url::escapePath(path), "GET");
+  request->setParameter("select",
+                        "name,folder,audio,image,photo,video,id,size,"
+                        "lastModifiedDateTime,thumbnails,@content.downloadUrl");
+  request->setParameter("expand", "thumbnails");
+  return request;
+}
+
 IHttpRequest::Pointer OneDrive::listDirectoryRequest(
     const IItem& item, const std::string& page_token, std::ostream&) const {
   if (!page_token.empty()) return http()->create(page_token, "GET");
@@ -220,6 +231,18 @@ IHttpRequest::Pointer OneDrive::listDirectoryRequest(
   return request;
 }
 
+IHttpRequest::Pointer OneDrive::changesRequest(const std::string& cursor,
+                                               std::ostream&) const {
+  if (!cursor.empty()) return http()->create(cursor, "GET");
+  auto request = http()->create(endpoint() + "/drive/root/delta", "GET");
+  request->setParameter("token", "latest");
+  request->setParameter("select",
+                        "name,folder,audio,image,photo,video,id,size,"
+                        "lastModifiedDateTime,thumbnails,@content.downloadUrl,"
+                        "parentReference,deleted");
+  return request;
+}
+
 IHttpRequest::Pointer OneDrive::downloadFileRequest(const IItem& f,
                                                     std::ostream&) const {
   const Item& item = static_cast<const Item&>(f);
@@ -294,14 +317,46 @@ IItem::Pointer OneDrive::toItem(const Json::Value& v) const {
   return std::move(item);
 }
 
-IItem::List OneDrive::listDirectoryResponse(
-    const IItem&, std::istream& stream, std::string& next_page_token) const {
-  IItem::List result;
-  auto response = util::json::from_stream(stream);
-  for (const auto& v : response["value"]) result.push_back(toItem(v));
+std::vector<Change> OneDrive::changesResponse(std::istream& response,
+                                              std::string& cursor,
+                                              bool& more) const {
+  auto json = util::json::from_stream(response);
+  std::vector<Change> result;
+  for (const auto& v : json["value"]) {
+    if (v.isMember("deleted")) {
+      result.push_back({Change::Type::Delete, toItem(v), {}});
+    } else {
+      std::vector<std::string> parents;
+      const auto& parent = v["parentReference"];
+      if (parent.isMember("id")) parents.push_back(parent["id"].asString());
+      if (parent["path"].asString() == "/drive/root:")
+        parents.push_back(rootDirectory()->id());
+      result.push_back({Change::Type::Modify, toItem(v), parents});
+    }
+  }
+  more = json.isMember("@odata.nextLink");
+  cursor =
+      (more ? json["@odata.nextLink"] : json["@odata.deltaLink"]).asString();
+  return result;
+}
+
+bool OneDrive::listDirectoryItemsPath(const IItem&,
+                                      std::vector<std::string>& path) const {
+  path = {"value"};
+  return true;
+}
+
+IItem::Pointer OneDrive::listDirectoryItem(const IItem&,
+                                           const Json::Value& v) const {
+  return toItem(v);
+}
+
+IItem::List OneDrive::listDirectoryRest(const IItem&,
+                                        const Json::Value& response,
+                                        std::string& next_page_token) const {
   if (response.isMember("@odata.nextLink"))
     next_page_token = response["@odata.nextLink"].asString();
-  return result;
+  return {};
 }
 
 void OneDrive::Auth::initialize(IHttp* http, IHttpServerFactory* factory) {
@@ -54,6 +54,8 @@ class OneDrive : public CloudProvider {
 
   IHttpRequest::Pointer getItemDataRequest(
       const std::string&, std::ostream& input_stream) const override;
+  IHttpRequest::Pointer getItemByPathRequest(
+      const std::string&, std::ostream& input_stream) const override;
   IHttpRequest::Pointer listDirectoryRequest(
       const IItem&, const std::string& page_token,
       std::ostream& input_stream) const override;
@@ -68,10 +70,19 @@ class OneDrive : public CloudProvider {
                                         std::ostream&) const override;
   IHttpRequest::Pointer renameItemRequest(const IItem&, const std::string& name,
                                           std::ostream&) const override;
-
-  IItem::List listDirectoryResponse(const IItem&, std::istream&,
-                                    std::string&) const override;
+  IHttpRequest::Pointer changesRequest(const std::string& cursor,
+                                       std::ostream&) const override;
+
+  bool listDirectoryItemsPath(const IItem&,
+                              std::vector<std::string>& path) const override;
+  IItem::Pointer listDirectoryItem(const IItem&,
+                                   const Json::Value&) const override;
+  IItem::List listDirectoryRest(const IItem&, const Json::Value&,
+                                std::string& next_page_token) const override;
   IItem::Pointer getItemDataResponse(std::istream& response) const override;
+  std::vector<Change> changesResponse(std::istream& response,
+                                      std::string& cursor,
+                                      bool& more) const override;
 
  private:
   class Auth : public cloudstorage::Auth {
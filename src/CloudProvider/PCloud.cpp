@@ -200,12 +200,15 @@ IHttpRequest::Pointer PCloud::getGeneralDataRequest(std::ostream&) const {
   return http()->create(endpoint() + "/userinfo");
 }
 
-IItem::List PCloud::listDirectoryResponse(const IItem&, std::istream& response,
-                                          std::string&) const {
-  auto json = util::json::from_stream(response);
-  IItem::List result;
-  for (auto&& v : json["metadata"]["contents"]) result.push_back(toItem(v));
-  return result;
+bool PCloud::listDirectoryItemsPath(const IItem&,
+                                    std::vector<std::string>& path) const {
+  path = {"metadata", "contents"};
+  return true;
+}
+
+IItem::Pointer PCloud::listDirectoryItem(const IItem&,
+                                         const Json::Value& v) const {
+  return toItem(v);
 }
 
 IItem::Pointer PCloud::toItem(const Json::Value& v) const {
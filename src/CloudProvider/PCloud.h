@@ -65,8 +65,10 @@ class PCloud : public CloudProvider {
                                           std::ostream&) const override;
   IHttpRequest::Pointer getGeneralDataRequest(std::ostream&) const override;
 
-  IItem::List listDirectoryResponse(
-      const IItem&, std::istream&, std::string& next_page_token) const override;
+  bool listDirectoryItemsPath(const IItem&,
+                              std::vector<std::string>& path) const override;
+  IItem::Pointer listDirectoryItem(const IItem&,
+                                   const Json::Value&) const override;
   std::string getItemUrlResponse(const IItem& item,
                                  const IHttpRequest::HeaderParameters&,
                                  std::istream& response) const override;
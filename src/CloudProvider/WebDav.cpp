@@ -24,29 +24,18 @@
 #include "WebDav.h"
 
 #include "Request/AuthorizeRequest.h"
+#include "Utility/ChunkedBuffer.h"
 #include "Utility/Item.h"
+#include "Utility/XmlStream.h"
 
 #include <json/json.h>
 #include <cstring>
-#include <iomanip>
 #include <iostream>
 
 namespace cloudstorage {
 
 namespace {
 
-IItem::TimeStamp parse_time(const std::string& str) {
-  std::stringstream stream(str);
-  std::tm time;
-  stream >> std::get_time(&time, "%a, %d %b %Y %T GMT");
-  if (!stream.fail()) {
-    return std::chrono::system_clock::time_point(
-        std::chrono::seconds(util::timegm(time)));
-  } else {
-    return IItem::UnknownTimeStamp;
-  }
-}
-
 bool ends_with(const char* str, const char* pattern) {
   auto l1 = strlen(str);
   auto l2 = strlen(pattern);
@@ -125,6 +114,14 @@ IHttpRequest::Pointer WebDav::getItemDataRequest(const std::string& id,
   return request;
 }
 
+IHttpRequest::Pointer WebDav::getItemByPathRequest(const std::string& path,
+                                                   std::ostream&) const {
+  auto request =
+      http()->create(endpoint() + util::Url::escapePath(path), "PROPFIND");
+  request->setHeaderParameter("Depth", "0");
+  return request;
+}
+
 IHttpRequest::Pointer WebDav::listDirectoryRequest(const IItem& item,
                                                    const std::string&,
                                                    std::ostream&) const {
@@ -195,10 +192,10 @@ IItem::Pointer WebDav::uploadFileResponse(const IItem& item,
 }
 
 GeneralData WebDav::getGeneralDataResponse(std::istream& stream) const {
-  std::stringstream sstream;
-  sstream << stream.rdbuf();
+  std::string storage;
+  auto xml = util::contents(stream, storage);
   tinyxml2::XMLDocument document;
-  if (document.Parse(sstream.str().c_str()) != tinyxml2::XML_SUCCESS)
+  if (document.Parse(xml.data_, xml.size_) != tinyxml2::XML_SUCCESS)
     throw std::logic_error(util::Error::FAILED_TO_PARSE_XML);
   auto response = find(document.RootElement(), "response");
   auto propstat = find(response, "propstat");
@@ -218,10 +215,10 @@ GeneralData WebDav::getGeneralDataResponse(std::istream& stream) const {
 }
 
 IItem::Pointer WebDav::getItemDataResponse(std::istream& stream) const {
-  std::stringstream sstream;
-  sstream << stream.rdbuf();
+  std::string storage;
+  auto xml = util::contents(stream, storage);
   tinyxml2::XMLDocument document;
-  if (document.Parse(sstream.str().c_str()) != tinyxml2::XML_SUCCESS)
+  if (document.Parse(xml.data_, xml.size_) != tinyxml2::XML_SUCCESS)
     throw std::logic_error(util::Error::FAILED_TO_PARSE_XML);
   return toItem(document.RootElement()->FirstChildElement());
 }
@@ -250,22 +247,28 @@ IItem::Pointer WebDav::moveItemResponse(const IItem& source, const IItem& dest,
   return std::move(i);
 }
 
-IItem::List WebDav::listDirectoryResponse(const IItem&, std::istream& stream,
-                                          std::string&) const {
-  std::stringstream sstream;
-  sstream << stream.rdbuf();
-  tinyxml2::XMLDocument document;
-  if (document.Parse(sstream.str().c_str()) != tinyxml2::XML_SUCCESS)
-    throw std::logic_error(util::Error::FAILED_TO_PARSE_XML);
-  if (document.RootElement()->FirstChild() == nullptr) return {};
-
-  IItem::List result;
-  for (auto child = document.RootElement()->FirstChild()->NextSiblingElement();
-       child; child = child->NextSiblingElement()) {
-    result.push_back(toItem(child));
-  }
-  return result;
-}
+std::unique_ptr<CloudProvider::ListingStream> WebDav::listDirectoryStream(
+    const IItem&, const ListingStream::ItemCallback& callback) const {
+  auto first = std::make_shared<bool>(true);
+  auto buffer = util::make_unique<util::XmlBuffer>(
+      std::vector<std::string>{"response"},
+      [=](const tinyxml2::XMLElement& child) {
+        // First response describes the directory itself.
+        if (*first) {
+          *first = false;
+          return;
+        }
+        callback(toItem(&child));
+      });
+  auto xml = buffer.get();
+  return util::make_unique<ListingStream>(std::move(buffer), [=](std::string&) {
+    tinyxml2::XMLDocument document;
+    xml->finish(document);
+    return IItem::List();
+  });
+}
+
+bool WebDav::listDirectoryStreamable(const IItem&) const { return true; }
 
 IItem::Pointer WebDav::toItem(const tinyxml2::XMLElement* node) const {
   if (!node) throw std::logic_error(util::Error::INVALID_XML);
@@ -278,7 +281,8 @@ IItem::Pointer WebDav::toItem(const tinyxml2::XMLElement* node) const {
   if (auto size_element = find(prop, "getcontentlength", false))
     if (auto text = size_element->GetText()) size = std::stoull(text);
   if (auto timestamp_element = find(prop, "getlastmodified", false))
-    if (auto text = timestamp_element->GetText()) timestamp = parse_time(text);
+    if (auto text = timestamp_element->GetText())
+      timestamp = util::parse_http_time(text);
   if (auto resource_type = find(prop, "resourcetype", false))
     if (find(resource_type, "collection", false)) {
       type = IItem::FileType::Directory;
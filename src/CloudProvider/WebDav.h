@@ -57,6 +57,8 @@ class WebDav : public CloudProvider {
 
   IHttpRequest::Pointer getItemDataRequest(
       const std::string&, std::ostream& input_stream) const override;
+  IHttpRequest::Pointer getItemByPathRequest(
+      const std::string&, std::ostream& input_stream) const override;
   IHttpRequest::Pointer listDirectoryRequest(
       const IItem&, const std::string& page_token,
       std::ostream& input_stream) const override;
@@ -75,8 +77,9 @@ class WebDav : public CloudProvider {
   IHttpRequest::Pointer getGeneralDataRequest(std::ostream&) const override;
 
   IItem::Pointer getItemDataResponse(std::istream& response) const override;
-  IItem::List listDirectoryResponse(
-      const IItem&, std::istream&, std::string& next_page_token) const override;
+  std::unique_ptr<ListingStream> listDirectoryStream(
+      const IItem&, const ListingStream::ItemCallback&) const override;
+  bool listDirectoryStreamable(const IItem&) const override;
   IItem::Pointer renameItemResponse(const IItem& old_item,
                                     const std::string& name,
                                     std::istream& response) const override;
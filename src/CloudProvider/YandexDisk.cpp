@@ -257,7 +257,7 @@ ICloudProvider::UploadFileRequest::Pointer YandexDisk::uploadFileAsync(
           f(item);
         },
         [=] { return std::make_shared<std::iostream>(wrapper.get()); },
-        std::make_shared<std::stringstream>(), nullptr,
+        nullptr, nullptr,
         std::bind(&IUploadFileCallback::progress, callback.get(), _1, _2),
         true);
   };
@@ -353,18 +353,26 @@ IItem::Pointer YandexDisk::moveItemResponse(const IItem& source,
       source.size(), source.timestamp(), source.type());
 }
 
-IItem::List YandexDisk::listDirectoryResponse(
-    const IItem&, std::istream& stream, std::string& next_page_token) const {
-  auto response = util::json::from_stream(stream);
-  IItem::List result;
-  for (const Json::Value& v : response["_embedded"]["items"])
-    result.push_back(toItem(v));
+bool YandexDisk::listDirectoryItemsPath(const IItem&,
+                                        std::vector<std::string>& path) const {
+  path = {"_embedded", "items"};
+  return true;
+}
+
+IItem::Pointer YandexDisk::listDirectoryItem(const IItem&,
+                                             const Json::Value& v) const {
+  return toItem(v);
+}
+
+IItem::List YandexDisk::listDirectoryRest(const IItem&,
+                                          const Json::Value& response,
+                                          std::string& next_page_token) const {
   int offset = response["_embedded"]["offset"].asInt();
   int limit = response["_embedded"]["limit"].asInt();
   int total_count = response["_embedded"]["total"].asInt();
   if (offset + limit < total_count)
     next_page_token = std::to_string(offset + limit);
-  return result;
+  return {};
 }
 
 IItem::Pointer YandexDisk::toItem(const Json::Value& v) const {
@@ -34,6 +34,7 @@
 #include "Request/ListDirectoryRequest.h"
 #include "Request/Request.h"
 
+#include "Utility/ChunkedBuffer.h"
 #include "Utility/Item.h"
 #include "Utility/Utility.h"
 
@@ -186,7 +187,7 @@ VideoInfo video_info(const std::string& url) {
   return result;
 }
 
-bool find(std::stringstream& stream, const std::string& pattern) {
+bool find(std::istream& stream, const std::string& pattern) {
   std::deque<char> buffer;
   stream.seekg(0);
   while (true) {
@@ -206,8 +207,8 @@ bool find(std::stringstream& stream, const std::string& pattern) {
   return false;
 }
 
-YouTubeDescrambleData descramble_data(std::stringstream& stream) {
-  auto find_descrambler = [](std::stringstream& stream) {
+YouTubeDescrambleData descramble_data(std::istream& stream) {
+  auto find_descrambler = [](std::istream& stream) {
     const std::string descrambler_search = "(k.sp,encodeURIComponent(";
     if (!find(stream, descrambler_search))
       throw std::logic_error(util::Error::COULD_NOT_FIND_DESCRAMBLER_NAME);
@@ -216,7 +217,7 @@ YouTubeDescrambleData descramble_data(std::stringstream& stream) {
     return descrambler;
   };
   auto find_descrambler_code = [](const std::string& name,
-                                  std::stringstream& stream) {
+                                  std::istream& stream) {
     const std::string function_search = name + "=function(a){";
     if (!find(stream, function_search))
       throw std::logic_error(
@@ -226,7 +227,7 @@ YouTubeDescrambleData descramble_data(std::stringstream& stream) {
     std::getline(stream, code, '}');
     return code.substr(0, code.find_last_of(';') + 1);
   };
-  auto find_helper = [](const std::string& code, std::stringstream& stream) {
+  auto find_helper = [](const std::string& code, std::istream& stream) {
     auto helper = code.substr(0, code.find_first_of('.'));
     const std::string helper_search = "var " + helper + "={";
     if (!find(stream, helper_search))
@@ -298,7 +299,7 @@ template <class Result>
 void get_stream(
     const typename Request<Result>::Pointer& r, const std::string& video_id,
     const std::function<void(EitherError<std::vector<VideoInfo>>)>& complete) {
-  auto get_config = [](std::stringstream& stream) {
+  auto get_config = [](std::istream& stream) {
     const std::string player_str = "ytplayer.config = ";
     if (!find(stream, player_str))
       throw std::logic_error(util::Error::YOUTUBE_CONFIG_NOT_FOUND);
@@ -680,11 +681,10 @@ IItem::List YouTube::listDirectoryResponse(const IItem& directory,
                                            std::string& next_page_token) const {
   std::unique_ptr<Json::CharReader> reader(
       Json::CharReaderBuilder().newCharReader());
-  std::stringstream sstream;
-  sstream << stream.rdbuf();
-  std::string str = sstream.str();
+  std::string storage;
+  auto data = util::contents(stream, storage);
   Json::Value response;
-  reader->parse(str.data(), str.data() + str.size(), &response, nullptr);
+  reader->parse(data.data_, data.data_ + data.size_, &response, nullptr);
   IItem::List result;
   auto type = from_string(directory.id()).type;
   if (response["kind"].asString() == "youtube#channelListResponse") {
@@ -88,6 +88,14 @@ class CLOUDSTORAGE_API ICloudAccess {
   virtual Promise<> generateThumbnail(
       IItem::Pointer file, const std::shared_ptr<ICloudDownloadCallback>&) = 0;
 
+  /**
+   * Passes changes made in the cloud to the listener, on the event loop's
+   * thread, until it's unsubscribed; see ICloudProvider::subscribeChanges.
+   */
+  virtual void subscribeChanges(ICloudProvider::IChangesListener::Pointer) = 0;
+  virtual void unsubscribeChanges(
+      const ICloudProvider::IChangesListener::Pointer&) = 0;
+
   static std::unique_ptr<ICloudUploadCallback> streamUploader(
       const std::shared_ptr<std::istream>& stream,
       const ProgressCallback& progress = nullptr);
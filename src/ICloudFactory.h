@@ -62,6 +62,7 @@ class CLOUDSTORAGE_API ICloudFactory {
   struct InitData {
     std::string base_url_;
     IHttp::Pointer http_;
+    IHttp::Options http_options_;  // used when http_ isn't provided
     IHttpServerFactory::Pointer http_server_factory_;
     ICrypto::Pointer crypto_;
     IThreadPoolFactory::Pointer thread_pool_factory_;
@@ -105,6 +106,14 @@ class CLOUDSTORAGE_API ICloudFactory {
   virtual int exec() = 0;
   virtual void quit() = 0;
 
+  /**
+   * Returns throttle shared by all cloud providers created by the factory;
+   * each of them has also its own one, see ICloudProvider::throttle.
+   *
+   * @return throttle
+   */
+  virtual IThrottle::Pointer throttle() const = 0;
+
   virtual Promise<Token> exchangeAuthorizationCode(const std::string& provider,
                                                    const ProviderInitData&,
                                                    const std::string& code) = 0;
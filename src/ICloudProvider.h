@@ -35,6 +35,7 @@
 #include "IItem.h"
 #include "IRequest.h"
 #include "IThreadPool.h"
+#include "IThrottle.h"
 
 namespace cloudstorage {
 
@@ -47,6 +48,7 @@ class CLOUDSTORAGE_API ICloudProvider {
   using GetItemUrlRequest = IRequest<EitherError<std::string>>;
   using ListDirectoryPageRequest = IRequest<EitherError<PageData>>;
   using ListDirectoryRequest = IRequest<EitherError<IItem::List>>;
+  using StreamDirectoryRequest = IRequest<EitherError<uint64_t>>;
   using GetItemRequest = IRequest<EitherError<IItem>>;
   using DownloadFileRequest = IRequest<EitherError<void>>;
   using UploadFileRequest = IRequest<EitherError<IItem>>;
@@ -56,6 +58,7 @@ class CLOUDSTORAGE_API ICloudProvider {
   using MoveItemRequest = IRequest<EitherError<IItem>>;
   using RenameItemRequest = IRequest<EitherError<IItem>>;
   using GeneralDataRequest = IRequest<EitherError<GeneralData>>;
+  using ChangesRequest = IRequest<EitherError<ChangesData>>;
 
   using OperationSet = uint32_t;
 
@@ -82,6 +85,26 @@ class CLOUDSTORAGE_API ICloudProvider {
     virtual void done(const ICloudProvider&, EitherError<void>) = 0;
   };
 
+  class IChangesListener {
+   public:
+    using Pointer = std::shared_ptr<IChangesListener>;
+
+    virtual ~IChangesListener() = default;
+
+    /**
+     * Called with changes made in the cloud, once they were applied to the
+     * metadata cache; after failed was called, it's called also when there
+     * are no changes, as soon as the provider follows them again.
+     */
+    virtual void changed(const std::vector<Change>&) = 0;
+
+    /**
+     * Called when following changes failed; it's retried later from where it
+     * stopped, so no changes are lost.
+     */
+    virtual void failed(const Error&) {}
+  };
+
   enum class Permission {
     ReadMetaData,  // list files
     Read,          // read files
@@ -143,6 +166,12 @@ class CLOUDSTORAGE_API ICloudProvider {
      */
     IThreadPool::Pointer thread_pool_;
 
+    /**
+     * Throttle shared with other cloud providers, e.g. a global one;
+     * provider's transfers are limited by both it and its own throttle.
+     */
+    IThrottle::Pointer throttle_;
+
     /**
      * Various hints which can be retrieved by some previous run with
      * ICloudProvider::hints; providing them may speed up the authorization
@@ -152,6 +181,8 @@ class CLOUDSTORAGE_API ICloudProvider {
      *  - redirect_uri
      *  - state
      *  - access_token
+     *  - access_token_expires (seconds since epoch; lets the restored access
+     *    token be refreshed before it expires)
      *  - file_url (used by mega.nz, url provider's base url)
      *  - metadata_url, content_url (amazon drive's endpoints)
      *  - temporary_directory (used by mega.nz, has to use native path
@@ -163,10 +194,68 @@ class CLOUDSTORAGE_API ICloudProvider {
      *  - success_page (page to be displayed when library was authorized
      *    successfully)
      *  - error_page (page to be displayed when library authorization failed)
+     *  - http_version (used when http_engine_ isn't provided; "2" enables
+     *    HTTP/2 multiplexing over TLS, "2-prior-knowledge" also over
+     *    cleartext)
+     *  - max_host_connections (used when http_engine_ isn't provided; limit
+     *    of simultaneous connections to a single host)
+     *  - max_concurrent_streams (used when http_engine_ isn't provided; limit
+     *    of concurrent streams on a single HTTP/2 connection)
+     *  - max_requests (used when http_engine_ isn't provided; limit of http
+     *    requests in flight, requests over it are started highest priority
+     *    first)
+     *  - max_host_requests (used when http_engine_ isn't provided; limit of
+     *    http requests in flight to a single host)
+     *  - http_worker_count (used when http_engine_ isn't provided; count of
+     *    threads driving http transfers, defaults to processor core count)
+     *  - connect_timeout, first_byte_timeout, stall_timeout (used when
+     *    http_engine_ isn't provided; in milliseconds, see IHttp::Options)
+     *  - download_limit, upload_limit (initial limits of provider's throttle,
+     *    in bytes per second)
+     *  - retry_attempts (count of attempts made for a request which keeps
+     *    failing with throttling or, if it's idempotent, server error http
+     *    code or timeout; defaults to 5)
+     *  - retry_base_delay, retry_max_delay (in milliseconds; delay before
+     *    n-th retry is random, up to min(retry_base_delay * 2^n,
+     *    retry_max_delay), unless the server sent Retry-After; requests the
+     *    server asks to wait longer than retry_max_delay fail right away)
+     *  - request_timeout (in milliseconds; deadline of requests started
+     *    outside of a DeadlineScope, there is none by default)
+     *  - max_provider_requests (upper bound of provider's concurrency limit,
+     *    which otherwise only shrinks when the server throttles requests)
+     *  - hedge_percentile (percentile of recent latency after which an
+     *    unanswered metadata GET request is sent once more and the first
+     *    response wins; hedging is disabled by default)
+     *  - hedge_budget (percent of requests which may be hedged, defaults to 5)
+     *  - cache_item_ttl, cache_directory_ttl, cache_url_ttl, cache_path_ttl
+     *    (in milliseconds; how long results of getItemData, directory
+     *    listings, getItemUrl and getItem are cached; successful mutations
+     *    invalidate affected entries; caching is disabled by default)
+     *  - path_index_ttl (in milliseconds; how long children of directories
+     *    listed to resolve paths in getItem are kept, so resolving a path
+     *    under them takes no requests; providers addressing items by path
+     *    resolve them with a single request regardless)
+     *  - cache_memory_budget (in bytes; least recently used cache entries are
+     *    evicted above it, defaults to 4 MiB)
+     *  - metadata_store (directory where items and directory listings are
+     *    kept between sessions; when set, getItemData and directory listings
+     *    not cached in memory are answered from it immediately and refreshed
+     *    in background)
+     *  - metadata_store_account (distinguishes stores of different accounts of
+     *    the same provider, should stay the same for the account, e.g. its
+     *    user name; the store isn't used without it)
+     *  - changes_interval (in milliseconds; how often subscribed changes are
+     *    queried from providers which can't notify about them, and how long
+     *    to wait before retrying a failed query; defaults to 30000)
      */
     Hints hints_;
   };
 
+  /**
+   * Cancels requests which are still running and waits until their callbacks
+   * return; mustn't be called from a thread on which the provider's http
+   * transfers complete, other than from a request's callback.
+   */
   virtual ~ICloudProvider() = default;
 
   /**
@@ -247,6 +336,14 @@ class CLOUDSTORAGE_API ICloudProvider {
    */
   virtual IItem::Pointer rootDirectory() const = 0;
 
+  /**
+   * Returns throttle limiting bandwidth used by the cloud provider; the limits
+   * can be adjusted at any time.
+   *
+   * @return throttle
+   */
+  virtual IThrottle::Pointer throttle() const = 0;
+
   /**
    * Exchanges authorization code which was sent to redirect_uri() by cloud
    * provider for a token.
@@ -270,6 +367,18 @@ class CLOUDSTORAGE_API ICloudProvider {
   virtual ListDirectoryRequest::Pointer listDirectoryAsync(
       IItem::Pointer directory, IListDirectoryCallback::Pointer) = 0;
 
+  /**
+   * Lists directory without gathering its items, they are only passed to
+   * the callback's receivedItem; memory used doesn't grow with the size of
+   * the directory.
+   *
+   * @param directory directory to list
+   * @return object representing the pending request, finishes with count of
+   * listed items
+   */
+  virtual StreamDirectoryRequest::Pointer streamDirectoryAsync(
+      IItem::Pointer directory, IStreamDirectoryCallback::Pointer) = 0;
+
   /**
    * Tries to get the Item by its absolute path.
    *
@@ -470,6 +579,42 @@ class CLOUDSTORAGE_API ICloudProvider {
   virtual GetItemUrlRequest::Pointer getFileDaemonUrlAsync(
       IItem::Pointer item,
       GetItemUrlCallback = [](const EitherError<std::string>&) {}) = 0;
+
+  /**
+   * Retrieves changes made since the cursor was returned, metadata cache is
+   * updated accordingly. Providers with a feed of changes query it, others
+   * list again directories whose listings are in the cache and compare them
+   * with the cached ones.
+   *
+   * @param cursor returned by the previous call, empty to get the cursor
+   * denoting current state
+   *
+   * @param callback called when finished
+   *
+   * @return object representing the pending request
+   */
+  virtual ChangesRequest::Pointer changesAsync(
+      const std::string& cursor,
+      ChangesCallback callback = [](const EitherError<ChangesData>&) {}) = 0;
+
+  /**
+   * Passes changes made in the cloud to the listener until it's unsubscribed.
+   * While there are listeners, providers able to notify about changes keep a
+   * long poll request open at IHttpRequest::Priority::Bulk and query
+   * changesAsync only once it reports some; others query changesAsync every
+   * changes_interval. Listeners are called from library's threads.
+   *
+   * @param listener
+   */
+  virtual void subscribeChanges(IChangesListener::Pointer listener) = 0;
+
+  /**
+   * Stops passing changes to the listener; watching stops with the last one.
+   *
+   * @param listener
+   */
+  virtual void unsubscribeChanges(
+      const IChangesListener::Pointer& listener) = 0;
 };
 
 }  // namespace cloudstorage
@@ -24,12 +24,15 @@
 #ifndef IHTTP_H
 #define IHTTP_H
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 
 #include "IRequest.h"
+#include "IThrottle.h"
 
 namespace cloudstorage {
 
@@ -42,11 +45,31 @@ class CLOUDSTORAGE_API IHttpRequest {
   using HeaderParameters = std::unordered_multimap<std::string, std::string>;
   using CompleteCallback = GenericCallback<Response>;
 
+  /**
+   * Describes how the transfer went. Times are in microseconds since the
+   * start of the transfer until the end of given phase; phases which didn't
+   * happen, e.g. connecting when the connection was reused, are 0. Http
+   * implementations which don't collect these leave them zeroed.
+   */
+  struct Metrics {
+    uint64_t name_lookup_time_;
+    uint64_t connect_time_;
+    uint64_t tls_handshake_time_;
+    uint64_t pretransfer_time_;
+    uint64_t start_transfer_time_;  // time to the first byte of the response
+    uint64_t redirect_time_;
+    uint64_t total_time_;
+    uint64_t downloaded_bytes_;
+    uint64_t uploaded_bytes_;
+    bool connection_reused_;
+  };
+
   struct Response {
     int http_code_;
     HeaderParameters headers_;  // header names should be lower cased
     std::shared_ptr<std::ostream> output_stream_;
     std::shared_ptr<std::ostream> error_stream_;
+    Metrics metrics_ = {};
   };
 
   static constexpr int Ok = 200;
@@ -59,12 +82,22 @@ class CLOUDSTORAGE_API IHttpRequest {
   static constexpr int Forbidden = 403;
   static constexpr int NotFound = 404;
   static constexpr int RangeInvalid = 416;
+  static constexpr int TooManyRequests = 429;
   static constexpr int InternalServerError = 500;
+  static constexpr int BadGateway = 502;
   static constexpr int ServiceUnavailable = 503;
+  static constexpr int GatewayTimeout = 504;
   static constexpr int Aborted = 600;
+  static constexpr int Timeout = 601;  // transfer or request ran out of time
   static constexpr int Unknown = 700;
   static constexpr int Failure = 800;
 
+  enum class Priority {
+    Interactive,  // metadata requests somebody is waiting for
+    Streaming,    // downloads of content which is being played
+    Bulk          // background uploads and downloads
+  };
+
   virtual ~IHttpRequest() = default;
 
   class ICallback {
@@ -85,6 +118,17 @@ class CLOUDSTORAGE_API IHttpRequest {
      */
     virtual bool pause() = 0;
 
+    /**
+     * Called by http implementations which don't poll abort and pause on
+     * their own, before the transfer starts.
+     *
+     * @param wakeup function to call whenever results of abort or pause may
+     * have changed, it may be called from any thread
+     * @return whether the callback calls wakeup; if it doesn't, the
+     * implementation keeps polling
+     */
+    virtual bool setWakeup(std::function<void()> /*wakeup*/) { return false; }
+
     /**
      * Called when download progress changed.
      *
@@ -134,6 +178,49 @@ class CLOUDSTORAGE_API IHttpRequest {
    */
   virtual const HeaderParameters& headerParameters() const = 0;
 
+  /**
+   * Sets the class the request is scheduled with; transfers of higher
+   * priority are started first when the http implementation limits count of
+   * transfers in flight. Implementations are free to ignore it.
+   */
+  virtual void setPriority(Priority) {}
+
+  /**
+   * @return priority set with setPriority
+   */
+  virtual Priority priority() const { return Priority::Interactive; }
+
+  /**
+   * Attaches a throttle limiting speed of the transfer; implementations are
+   * free to ignore it.
+   */
+  virtual void addThrottle(IThrottle::Pointer) {}
+
+  /**
+   * Sets the time by which the transfer has to complete, otherwise it fails
+   * with the Timeout code. Implementations are free to ignore it.
+   */
+  virtual void setDeadline(std::chrono::steady_clock::time_point) {}
+
+  /**
+   * @return deadline set with setDeadline
+   */
+  virtual std::chrono::steady_clock::time_point deadline() const {
+    return std::chrono::steady_clock::time_point::max();
+  }
+
+  /**
+   * Marks the transfer as a long poll, whose response the server holds back
+   * until something happens; first byte and stall timeouts don't apply to it.
+   * Implementations are free to ignore it.
+   */
+  virtual void setLongPoll(bool) {}
+
+  /**
+   * @return whether the transfer was marked with setLongPoll
+   */
+  virtual bool longPoll() const { return false; }
+
   /**
    * @return url(without parameters set with setParameter)
    */
@@ -182,6 +269,71 @@ class CLOUDSTORAGE_API IHttp {
  public:
   using Pointer = std::unique_ptr<IHttp>;
 
+  enum class Version {
+    Http1,               // HTTP/1.1 only
+    Http2,               // HTTP/2 over TLS if the server supports it
+    Http2PriorKnowledge  // HTTP/2 without upgrade, also over cleartext
+  };
+
+  /**
+   * Options of the default http implementation.
+   */
+  struct Options {
+    /**
+     * With HTTP/2 concurrent requests to the same host are multiplexed over
+     * one connection instead of each opening its own one.
+     */
+    Version version_ = Version::Http1;
+
+    /**
+     * Maximum count of simultaneously open connections to a single host, 0
+     * means no limit. Requests over the limit are queued.
+     */
+    uint32_t max_host_connections_ = 0;
+
+    /**
+     * Maximum count of concurrent streams on a single HTTP/2 connection.
+     */
+    uint32_t max_concurrent_streams_ = 100;
+
+    /**
+     * Maximum count of transfers in flight, 0 means no limit. Transfers over
+     * the limit wait and are started highest priority first.
+     */
+    uint32_t max_requests_ = 0;
+
+    /**
+     * Maximum count of transfers in flight to a single host, 0 means no limit.
+     */
+    uint32_t max_host_requests_ = 0;
+
+    /**
+     * Count of threads driving the transfers, 0 means one per processor core.
+     */
+    uint32_t worker_count_ = 0;
+
+    /**
+     * Time allowed for establishing a connection, 0 means curl's default.
+     * Transfers which run out of this or of the following timeouts fail with
+     * IHttpRequest::Timeout.
+     */
+    std::chrono::milliseconds connect_timeout_ = std::chrono::milliseconds(0);
+
+    /**
+     * Time allowed between starting the transfer and receiving the first byte
+     * of the response, 0 means no limit.
+     */
+    std::chrono::milliseconds first_byte_timeout_ =
+        std::chrono::milliseconds(0);
+
+    /**
+     * Time after which a transfer that is neither sending nor receiving
+     * anything is considered stalled, 0 means no limit. It's checked with a
+     * one second granularity.
+     */
+    std::chrono::milliseconds stall_timeout_ = std::chrono::milliseconds(0);
+  };
+
   virtual ~IHttp() = default;
 
   /**
@@ -197,6 +349,7 @@ class CLOUDSTORAGE_API IHttp {
                                        bool follow_redirect = true) const = 0;
 
   static IHttp::Pointer create();
+  static IHttp::Pointer create(const Options&);
 };
 
 }  // namespace cloudstorage
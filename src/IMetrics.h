@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * IMetrics.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef IMETRICS_H
+#define IMETRICS_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "IHttp.h"
+
+namespace cloudstorage {
+
+/**
+ * Process-wide registry aggregating metrics of http transfers done by cloud
+ * providers, grouped by provider name and ICloudProvider's operation the
+ * transfer was done for. Pairs of provider and operation are interned into
+ * keys once; recording a transfer under a key is a few atomic additions,
+ * nothing is computed until somebody reads entries.
+ */
+class CLOUDSTORAGE_API IMetrics {
+ public:
+  /**
+   * Latency histogram with logarithmic buckets; bucket i counts samples of
+   * less than 2^i microseconds which didn't fit in the previous buckets.
+   */
+  struct Histogram {
+    static constexpr size_t BucketCount = 32;
+
+    /**
+     * @param p quantile, from 0 to 1
+     * @return upper bound of the bucket the quantile falls into, in
+     * microseconds; 0 if there are no samples
+     */
+    uint64_t percentile(double p) const {
+      uint64_t rank = static_cast<uint64_t>(p * count_ + 0.5), seen = 0;
+      for (size_t i = 0; i < BucketCount; i++) {
+        seen += buckets_[i];
+        if (seen > 0 && seen >= rank) return std::min(uint64_t(1) << i, max_);
+      }
+      return max_;
+    }
+
+    std::array<uint64_t, BucketCount> buckets_;
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t max_;
+  };
+
+  struct Entry {
+    std::string provider_;
+    std::string operation_;
+    uint64_t count_;   // all transfers, including ones which never ran
+    uint64_t errors_;  // transfers which didn't end with successful http code
+    uint64_t reused_connections_;
+    uint64_t downloaded_bytes_;
+    uint64_t uploaded_bytes_;
+    Histogram first_byte_time_;
+    Histogram total_time_;
+  };
+
+  /**
+   * Counters of a single provider and operation, owned by the registry.
+   */
+  struct Series;
+
+  /**
+   * Interned provider and operation pair, valid as long as the registry.
+   */
+  using Key = Series*;
+
+  virtual ~IMetrics() = default;
+
+  /**
+   * @return registry all cloud providers record their transfers into
+   */
+  static IMetrics& instance();
+
+  /**
+   * Interns provider and operation pair; the same pair always gets the same
+   * key.
+   *
+   * @param provider
+   * @param operation
+   * @return key to record transfers under
+   */
+  virtual Key key(const std::string& provider,
+                  const std::string& operation) = 0;
+
+  /**
+   * Adds transfer to the entry of given key. Transfers which never ran, like
+   * the ones aborted or expired before sending, only count towards count_ and
+   * errors_, they have no latency to put into the histograms.
+   *
+   * @param key
+   * @param http_code
+   * @param metrics
+   */
+  virtual void record(Key key, int http_code,
+                      const IHttpRequest::Metrics& metrics) = 0;
+
+  /**
+   * Adds transfer to the entry of given provider and operation.
+   *
+   * @param provider
+   * @param operation
+   * @param http_code
+   * @param metrics
+   */
+  void record(const std::string& provider, const std::string& operation,
+              int http_code, const IHttpRequest::Metrics& metrics) {
+    record(key(provider, operation), http_code, metrics);
+  }
+
+  /**
+   * @return snapshot of all the entries, sorted by provider and operation
+   */
+  virtual std::vector<Entry> entries() const = 0;
+
+  /**
+   * Drops all the entries.
+   */
+  virtual void reset() = 0;
+};
+
+}  // namespace cloudstorage
+
+#endif  // IMETRICS_H
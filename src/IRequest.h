@@ -24,6 +24,7 @@
 #ifndef IREQUEST_H
 #define IREQUEST_H
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -52,6 +53,29 @@ struct PageData {
   std::string next_token_;  // empty if no next page
 };
 
+/**
+ * Change of an item reported by ICloudProvider::changesAsync.
+ */
+struct Change {
+  enum class Type {
+    Add,     // item wasn't known before
+    Modify,  // item's metadata or content changed
+    Delete,  // item was removed, only its id is certain
+    Move     // item was moved to another directory, maybe renamed too
+  };
+
+  Type type_;
+  // state after the change
+  IItem::Pointer item_;
+  // directories containing the item after the change, empty if unknown
+  std::vector<std::string> parents_;
+};
+
+struct ChangesData {
+  std::vector<Change> changes_;
+  std::string cursor_;  // pass to the next changesAsync call
+};
+
 struct Token {
   std::string token_;
   std::string access_token_;
@@ -67,9 +91,36 @@ struct Range {
 
 const Range FullRange = {Range::Begin, Range::Full};
 
+/**
+ * Sets the deadline of requests started on the current thread while the scope
+ * is alive, including their subrequests and http transfers. A request which
+ * doesn't complete in time fails with IHttpRequest::Timeout. Nested scopes
+ * can only shorten the deadline.
+ */
+class CLOUDSTORAGE_API DeadlineScope {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  DeadlineScope(Clock::time_point deadline);
+  DeadlineScope(Clock::duration timeout);
+  ~DeadlineScope();
+
+  /**
+   * @return deadline of the innermost scope alive on the current thread or
+   * nullptr if there is none
+   */
+  static const Clock::time_point* current();
+
+ private:
+  Clock::time_point deadline_;
+  const Clock::time_point* previous_;
+};
+
 /**
  * Class representing pending request. When there is no reference to the
- * request, it's immediately cancelled.
+ * request, it's immediately cancelled; dropping the reference doesn't wait for
+ * the request, its callback is still called, with the Aborted error unless the
+ * request completed before.
  */
 class CLOUDSTORAGE_API IGenericRequest {
  public:
@@ -81,8 +132,9 @@ class CLOUDSTORAGE_API IGenericRequest {
   virtual void finish() = 0;
 
   /**
-   * Cancels request; may involve curl request cancellation which may last very
-   * long if curl was compiled without asynchronous name resolver(c-ares).
+   * Cancels request without waiting for it; the callback reports the Aborted
+   * error once the transfers in flight are torn down. Call finish afterwards
+   * to wait for that.
    */
   virtual void cancel() = 0;
 
@@ -126,6 +178,20 @@ class IListDirectoryCallback
   virtual void receivedItem(IItem::Pointer item) = 0;
 };
 
+class IStreamDirectoryCallback
+    : public IGenericCallback<EitherError<uint64_t>> {
+ public:
+  using Pointer = std::shared_ptr<IStreamDirectoryCallback>;
+
+  /**
+   * Called when directory's child was fetched, the item isn't kept anywhere
+   * else.
+   *
+   * @param item fetched item
+   */
+  virtual void receivedItem(IItem::Pointer item) = 0;
+};
+
 class IDownloadFileCallback : public IGenericCallback<EitherError<void>> {
  public:
   using Pointer = std::shared_ptr<IDownloadFileCallback>;
@@ -218,9 +284,16 @@ class GenericCallback {
 
   GenericCallback(const GenericCallback& d) : functor_(d.functor_) {}
 
+  GenericCallback(GenericCallback&& d) noexcept
+      : functor_(std::move(d.functor_)) {}
+
+  GenericCallback& operator=(const GenericCallback&) = default;
+
+  GenericCallback& operator=(GenericCallback&&) = default;
+
   template <class Function>
   GenericCallback(const Function& callback)
-      : functor_(std::make_shared<Functor>(callback)) {}
+      : functor_(std::make_shared<Functor<Function>>(callback)) {}
 
   GenericCallback(typename IGenericCallback<Arguments...>::Pointer functor)
       : functor_(functor) {}
@@ -244,15 +317,15 @@ class GenericCallback {
   }
 
  private:
+  template <class Function>
   class Functor : public IGenericCallback<Arguments...> {
    public:
-    Functor(const std::function<void(Arguments...)> callback)
-        : callback_(callback) {}
+    Functor(const Function& callback) : callback_(callback) {}
 
     void done(Arguments... args) override { callback_(args...); }
 
    private:
-    std::function<void(Arguments...)> callback_;
+    Function callback_;
   };
 
   typename IGenericCallback<Arguments...>::Pointer functor_;
@@ -272,6 +345,7 @@ using DownloadFileCallback = GenericCallback<EitherError<void>>;
 using UploadFileCallback = GenericCallback<EitherError<IItem>>;
 using GetThumbnailCallback = GenericCallback<EitherError<void>>;
 using GeneralDataCallback = GenericCallback<EitherError<GeneralData>>;
+using ChangesCallback = GenericCallback<EitherError<ChangesData>>;
 
 }  // namespace cloudstorage
 
@@ -0,0 +1,102 @@
+/*****************************************************************************
+ * IThrottle.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef ITHROTTLE_H
+#define ITHROTTLE_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "IRequest.h"
+
+namespace cloudstorage {
+
+/**
+ * Pair of token buckets limiting download and upload speed of the transfers
+ * it's attached to. One throttle may be shared by many transfers, e.g. all
+ * transfers of a cloud provider; a transfer with several throttles attached
+ * doesn't exceed any of them.
+ */
+class CLOUDSTORAGE_API IThrottle {
+ public:
+  using Pointer = std::shared_ptr<IThrottle>;
+
+  enum class Direction { Download, Upload };
+
+  virtual ~IThrottle() = default;
+
+  /**
+   * @param download_limit bytes per second, 0 means no limit
+   * @param upload_limit bytes per second, 0 means no limit
+   */
+  static Pointer create(uint64_t download_limit = 0, uint64_t upload_limit = 0);
+
+  /**
+   * Sets speed limit, it also applies to the transfers which are already
+   * running.
+   *
+   * @param direction
+   * @param limit bytes per second, 0 means no limit
+   */
+  virtual void setLimit(Direction direction, uint64_t limit) = 0;
+
+  /**
+   * @param direction
+   * @return bytes per second, 0 means no limit
+   */
+  virtual uint64_t limit(Direction direction) const = 0;
+
+  /**
+   * Used by http implementations to check whether transfer may proceed.
+   *
+   * @param direction
+   * @return false if the bucket is empty and the transfer has to wait
+   */
+  virtual bool available(Direction direction) = 0;
+
+  /**
+   * Used by http implementations to take tokens for transferred data; the
+   * bucket may go into debt which has to be paid off before the transfers
+   * can proceed again.
+   *
+   * @param direction
+   * @param bytes
+   */
+  virtual void consume(Direction direction, uint64_t bytes) = 0;
+
+  /**
+   * Used by http implementations to tell when a transfer waiting for the
+   * bucket may proceed.
+   *
+   * @param direction
+   * @return time until available returns true, zero if it already does
+   */
+  virtual std::chrono::milliseconds delay(Direction direction) {
+    return available(direction) ? std::chrono::milliseconds()
+                                : std::chrono::milliseconds(100);
+  }
+};
+
+}  // namespace cloudstorage
+
+#endif  // ITHROTTLE_H
@@ -25,19 +25,20 @@
 
 #include "CloudProvider/CloudProvider.h"
 
-using namespace std::placeholders;
-
 namespace cloudstorage {
 
 AuthorizeRequest::AuthorizeRequest(std::shared_ptr<CloudProvider> p,
                                    const AuthorizationFlow& callback)
     : Request(std::move(p),
               [=](EitherError<void> e) {
-                provider()->auth_callback()->done(*provider(), e);
+                if (!e.left()) provider()->scheduleTokenRefresh();
+                if (!e.left() || !refresh_only_)
+                  provider()->auth_callback()->done(*provider(), e);
               },
-              std::bind(&AuthorizeRequest::resolve, this, _1, callback)),
+              [=](Request::Pointer r) { resolve(r, callback); }),
       state_(provider()->auth()->state()),
-      server_cancelled_() {
+      server_cancelled_(),
+      refresh_only_() {
   if (!provider()->auth_callback()) {
     util::log("CloudProvider's callback can't be null.");
     std::terminate();
@@ -49,6 +50,7 @@ AuthorizeRequest::~AuthorizeRequest() { AuthorizeRequest::cancel(); }
 void AuthorizeRequest::resolve(const Request::Pointer& request,
                                const AuthorizationFlow& callback) {
   auto on_complete = [=](EitherError<void> result) {
+    if (refresh_only_) return request->done(result);
     std::unique_lock<std::mutex> lock(provider()->current_authorization_mutex_);
     while (!provider()->auth_callbacks_.empty()) {
       {
@@ -105,7 +107,7 @@ void AuthorizeRequest::cancel() {
     if (provider()) {
       std::lock_guard<std::mutex> lock(
           provider()->current_authorization_mutex_);
-      if (!provider()->auth_callbacks_.empty()) return;
+      if (!refresh_only_ && !provider()->auth_callbacks_.empty()) return;
     }
   }
   sendCancel();
@@ -118,7 +120,7 @@ void AuthorizeRequest::finish() {
     if (provider()) {
       std::lock_guard<std::mutex> lock(
           provider()->current_authorization_mutex_);
-      if (!provider()->auth_callbacks_.empty()) return;
+      if (!refresh_only_ && !provider()->auth_callbacks_.empty()) return;
     }
   }
   Request::finish();
@@ -133,6 +135,8 @@ void AuthorizeRequest::set_server(const std::shared_ptr<IHttpServer>& p) {
   }
 }
 
+void AuthorizeRequest::set_refresh_only() { refresh_only_ = true; }
+
 void AuthorizeRequest::oauth2Authorization(const AuthorizeCompleted& complete) {
   auto auth = provider()->auth();
   auto auth_callback = provider()->auth_callback();
@@ -147,7 +151,8 @@ void AuthorizeRequest::oauth2Authorization(const AuthorizeCompleted& complete) {
            } catch (const std::exception&) {
              return complete(Error{IHttpRequest::Failure, r->output().str()});
            }
-         } else if ((!IHttpRequest::isClientError(e.left()->code_) &&
+         } else if (refresh_only_ ||
+                    (!IHttpRequest::isClientError(e.left()->code_) &&
                      e.left()->code_ != IHttpRequest::Aborted) ||
                     auth_callback->userConsentRequired(*provider()) ==
                         ICloudProvider::IAuthCallback::Status::None) {
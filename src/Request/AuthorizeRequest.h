@@ -47,12 +47,21 @@ class AuthorizeRequest : public Request<EitherError<void>> {
   void finish() override;
   void set_server(const std::shared_ptr<IHttpServer>&);
 
+  /**
+   * Makes the request only refresh the access token, for use before running
+   * it: it doesn't fall back to asking the user for consent, its failures
+   * aren't reported to the auth callback and requests which need to
+   * reauthorize don't wait for it.
+   */
+  void set_refresh_only();
+
  private:
   void resolve(const Request::Pointer&, const AuthorizationFlow& callback);
 
   std::string state_;
   std::mutex lock_;
   bool server_cancelled_;
+  bool refresh_only_;
   std::shared_ptr<IHttpServer> auth_server_;
 };
 
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * ChangesRequest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ChangesRequest.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "CloudProvider/CloudProvider.h"
+#include "Utility/Item.h"
+
+namespace cloudstorage {
+
+namespace {
+
+// Cursor of providers without a feed of changes, they compare listings instead.
+const std::string LISTING_CURSOR = "listing";
+
+}  // namespace
+
+ChangesRequest::ChangesRequest(std::shared_ptr<CloudProvider> p,
+                               const std::string& cursor,
+                               const Callback& callback)
+    : Request(std::move(p), callback,
+              [=](Request::Pointer) {
+                fetch(cursor, std::make_shared<std::vector<Change>>());
+              },
+              IHttpRequest::Priority::Bulk) {}
+
+ChangesRequest::~ChangesRequest() { cancel(); }
+
+void ChangesRequest::fetch(
+    const std::string& cursor,
+    const std::shared_ptr<std::vector<Change>>& changes) {
+  auto request = this->shared_from_this();
+  this->request(
+      [=](util::Output input) {
+        return provider()->changesRequest(cursor, *input);
+      },
+      [=](EitherError<Response> r) {
+        if (r.left()) {
+          if (r.left()->code_ == IHttpRequest::Aborted &&
+              r.left()->description_ == util::Error::UNIMPLEMENTED &&
+              !is_cancelled())
+            return relist(cursor);
+          return request->done(r.left());
+        }
+        std::string next_cursor = cursor;
+        bool more = false;
+        try {
+          auto page = provider()->changesResponse(r.right()->output(),
+                                                  next_cursor, more);
+          changes->insert(changes->end(), page.begin(), page.end());
+        } catch (const std::exception& e) {
+          return request->done(Error{IHttpRequest::Failure, e.what()});
+        }
+        if (more && next_cursor != cursor) return fetch(next_cursor, changes);
+        auto cache = provider()->metadata_cache();
+        for (auto& change : *changes)
+          if (change.type_ != Change::Type::Delete)
+            change.type_ = classify(change);
+        for (const auto& change : *changes) cache->apply(change);
+        request->done(ChangesData{*changes, next_cursor});
+      });
+}
+
+void ChangesRequest::relist(const std::string& cursor) {
+  auto listings = provider()->metadata_cache()->listings();
+  if (cursor.empty() || listings.empty())
+    return done(ChangesData{{}, LISTING_CURSOR});
+  struct State {
+    std::mutex mutex_;
+    size_t pending_;
+    std::vector<Listing> current_;
+    std::shared_ptr<Error> error_;
+  };
+  auto state = std::make_shared<State>();
+  state->pending_ = listings.size();
+  auto request = this->shared_from_this();
+  for (const auto& listing : listings) {
+    auto directory = listing.first;
+    make_subrequest(
+        &CloudProvider::listDirectorySimpleAsync, directory,
+        [=](EitherError<IItem::List> e) {
+          std::unique_lock<std::mutex> lock(state->mutex_);
+          if (e.right())
+            state->current_.push_back({directory, *e.right()});
+          else if (e.left()->code_ == IHttpRequest::NotFound)
+            state->current_.push_back({directory, {}});
+          else
+            state->error_ = e.left();
+          if (--state->pending_ > 0) return;
+          lock.unlock();
+          if (state->current_.empty()) return request->done(state->error_);
+          request->done(compare(listings, state->current_));
+        });
+  }
+}
+
+ChangesData ChangesRequest::compare(const std::vector<Listing>& previous,
+                                    const std::vector<Listing>& current) const {
+  struct Location {
+    IItem::Pointer item_;
+    std::string directory_;
+  };
+  std::unordered_map<std::string, Location> before;
+  std::unordered_set<std::string> relisted, after;
+  for (const auto& listing : current) {
+    relisted.insert(listing.first->id());
+    for (const auto& item : listing.second) after.insert(item->id());
+  }
+  for (const auto& listing : previous)
+    if (relisted.find(listing.first->id()) != relisted.end())
+      for (const auto& item : listing.second)
+        before[item->id()] = {item, listing.first->id()};
+  ChangesData result;
+  result.cursor_ = LISTING_CURSOR;
+  std::unordered_set<std::string> reported;
+  for (const auto& listing : current)
+    for (const auto& item : listing.second) {
+      if (!reported.insert(item->id()).second) continue;
+      Change change{Change::Type::Modify, item, {listing.first->id()}};
+      auto it = before.find(item->id());
+      if (it == before.end()) {
+        change.type_ = Change::Type::Add;
+      } else if (it->second.directory_ != listing.first->id()) {
+        change.type_ = Change::Type::Move;
+      } else {
+        const auto& old = *it->second.item_;
+        if (old.filename() == item->filename() && old.size() == item->size() &&
+            old.timestamp() == item->timestamp())
+          continue;
+      }
+      result.changes_.push_back(change);
+    }
+  for (const auto& listing : previous) {
+    if (relisted.find(listing.first->id()) == relisted.end()) continue;
+    for (const auto& item : listing.second)
+      if (after.find(item->id()) == after.end() &&
+          reported.insert(item->id()).second)
+        result.changes_.push_back({Change::Type::Delete, item, {}});
+  }
+  auto cache = provider()->metadata_cache();
+  for (const auto& change : result.changes_) cache->apply(change);
+  for (const auto& listing : current)
+    cache->put_listing(listing.first, listing.second);
+  return result;
+}
+
+Change::Type ChangesRequest::classify(const Change& change) const {
+  auto cache = provider()->metadata_cache();
+  auto id = change.item_->id();
+  auto directories = cache->directories(id);
+  auto previous = cache->item(id);
+  if (!previous) previous = cache->stored_item(id);
+  if (auto item = std::dynamic_pointer_cast<Item>(previous))
+    for (const auto& directory : item->parents()) directories.insert(directory);
+  if (!previous && directories.empty()) return Change::Type::Add;
+  if (directories.empty() || change.parents_.empty())
+    return Change::Type::Modify;
+  for (const auto& directory : change.parents_)
+    if (directories.find(directory) != directories.end())
+      return Change::Type::Modify;
+  return Change::Type::Move;
+}
+
+}  // namespace cloudstorage
@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * ChangesRequest.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CHANGESREQUEST_H
+#define CHANGESREQUEST_H
+
+#include "Request.h"
+
+namespace cloudstorage {
+
+class ChangesRequest : public Request<EitherError<ChangesData>> {
+ public:
+  using Callback = ChangesCallback;
+  using Listing = std::pair<IItem::Pointer, IItem::List>;
+
+  ChangesRequest(std::shared_ptr<CloudProvider>, const std::string& cursor,
+                 const Callback& callback);
+  ~ChangesRequest() override;
+
+ private:
+  void fetch(const std::string& cursor,
+             const std::shared_ptr<std::vector<Change>>& changes);
+  void relist(const std::string& cursor);
+  ChangesData compare(const std::vector<Listing>& previous,
+                      const std::vector<Listing>& current) const;
+  Change::Type classify(const Change&) const;
+};
+
+}  // namespace cloudstorage
+
+#endif  // CHANGESREQUEST_H
@@ -26,8 +26,6 @@
 #include "CloudProvider/CloudProvider.h"
 #include "Utility/Item.h"
 
-using namespace std::placeholders;
-
 namespace cloudstorage {
 
 DownloadFileRequest::DownloadFileRequest(std::shared_ptr<CloudProvider> p,
@@ -36,9 +34,13 @@ DownloadFileRequest::DownloadFileRequest(std::shared_ptr<CloudProvider> p,
                                          Range range,
                                          const RequestFactory& request_factory)
     : Request(std::move(p), [=](EitherError<void> e) { cb->done(e); },
-              std::bind(&DownloadFileRequest::resolve, this, _1, file, cb.get(),
-                        range, request_factory)),
-      stream_wrapper_(std::bind(&ICallback::receivedData, cb.get(), _1, _2)) {}
+              [=, callback = cb.get()](Request::Pointer r) {
+                resolve(r, file, callback, range, request_factory);
+              },
+              IHttpRequest::Priority::Streaming),
+      stream_wrapper_([callback = cb.get()](const char* data, uint32_t length) {
+        callback->receivedData(data, length);
+      }) {}
 
 DownloadFileRequest::~DownloadFileRequest() { cancel(); }
 
@@ -74,7 +76,9 @@ void DownloadFileRequest::resolve(const Request::Pointer& request,
       },
       []() { return std::make_shared<std::stringstream>(); },
       std::make_shared<std::ostream>(&stream_wrapper_),
-      std::bind(&DownloadFileRequest::ICallback::progress, callback, _1, _2),
+      [callback](uint64_t total, uint64_t now) {
+        callback->progress(total, now);
+      },
       nullptr, true);
 }
 
@@ -92,9 +96,13 @@ DownloadFileFromUrlRequest::DownloadFileFromUrlRequest(
     std::shared_ptr<CloudProvider> p, IItem::Pointer file,
     const ICallback::Pointer& cb, Range range)
     : Request(std::move(p), [=](EitherError<void> e) { cb->done(e); },
-              std::bind(&DownloadFileFromUrlRequest::resolve, this, _1, file,
-                        cb.get(), range)),
-      stream_wrapper_(std::bind(&ICallback::receivedData, cb.get(), _1, _2)) {}
+              [=, callback = cb.get()](Pointer r) {
+                resolve(r, file, callback, range);
+              },
+              IHttpRequest::Priority::Streaming),
+      stream_wrapper_([callback = cb.get()](const char* data, uint32_t length) {
+        callback->receivedData(data, length);
+      }) {}
 
 DownloadFileFromUrlRequest::~DownloadFileFromUrlRequest() { cancel(); }
 
@@ -131,8 +139,10 @@ void DownloadFileFromUrlRequest::resolve(const Pointer& r,
         },
         [] { return std::make_shared<std::stringstream>(); },
         std::make_shared<std::ostream>(&stream_wrapper_),
-        std::bind(&IDownloadFileCallback::progress, callback, _1, _2), nullptr,
-        true);
+        [callback](uint64_t total, uint64_t now) {
+          callback->progress(total, now);
+        },
+        nullptr, true);
   };
   auto cached_url = static_cast<Item*>(file.get())->url();
   auto get_url = [=]() {
@@ -23,6 +23,8 @@
 
 #include "GetItemRequest.h"
 
+#include <sstream>
+
 #include "CloudProvider/CloudProvider.h"
 
 namespace cloudstorage {
@@ -34,7 +36,15 @@ GetItemRequest::GetItemRequest(std::shared_ptr<CloudProvider> p,
         if (path.empty() || path.front() != '/')
           return done(
               Error{IHttpRequest::Forbidden, util::Error::INVALID_PATH});
-        work(provider()->rootDirectory(), path, callback);
+        auto absolute_path = path;
+        while (absolute_path.size() > 1 && absolute_path.back() == '/')
+          absolute_path.pop_back();
+        std::stringstream input;
+        if (absolute_path.size() > 1 &&
+            provider()->getItemByPathRequest(absolute_path, input))
+          fetch(absolute_path);
+        else
+          work(provider()->rootDirectory(), path, callback);
       }) {}
 
 GetItemRequest::~GetItemRequest() { cancel(); }
@@ -46,6 +56,22 @@ IItem::Pointer GetItemRequest::getItem(const IItem::List& items,
   return nullptr;
 }
 
+void GetItemRequest::fetch(const std::string& path) {
+  auto request = this->shared_from_this();
+  this->request(
+      [=](util::Output input) {
+        return provider()->getItemByPathRequest(path, *input);
+      },
+      [=](EitherError<Response> r) {
+        if (r.left()) return request->done(r.left());
+        try {
+          request->done(provider()->getItemDataResponse(r.right()->output()));
+        } catch (const std::exception& e) {
+          request->done(Error{IHttpRequest::Failure, e.what()});
+        }
+      });
+}
+
 void GetItemRequest::work(const IItem::Pointer& item, const std::string& p,
                           const Callback& complete) {
   if (!item)
@@ -60,13 +86,15 @@ void GetItemRequest::work(const IItem::Pointer& item, const std::string& p,
               rest = it == std::string::npos
                          ? ""
                          : std::string(path.begin() + it, path.end());
+  auto cache = provider()->metadata_cache();
+  IItem::Pointer child;
+  if (cache->child(*item, name, child)) return work(child, rest, complete);
   auto request = this->shared_from_this();
   make_subrequest(&CloudProvider::listDirectorySimpleAsync, item,
                   [=](EitherError<IItem::List> e) {
-                    if (e.left())
-                      request->done(e.left());
-                    else
-                      work(getItem(*e.right(), name), rest, complete);
+                    if (e.left()) return request->done(e.left());
+                    cache->put_children(*item, *e.right());
+                    work(getItem(*e.right(), name), rest, complete);
                   });
 }
 
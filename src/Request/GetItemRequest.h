@@ -39,6 +39,7 @@ class GetItemRequest : public Request<EitherError<IItem>> {
  private:
   IItem::Pointer getItem(const IItem::List& items,
                          const std::string& name) const;
+  void fetch(const std::string& path);
   void work(const IItem::Pointer& item, const std::string& path,
             const Callback&);
 };
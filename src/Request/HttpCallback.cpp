@@ -28,23 +28,49 @@
 namespace cloudstorage {
 
 HttpCallback::HttpCallback(
-    std::function<int()> status,
-    std::function<bool(int, const IHttpRequest::HeaderParameters&)> is_success,
-    ProgressFunction progress_download, ProgressFunction progress_upload)
+    util::Function<int()> status,
+    util::Function<bool(int, const IHttpRequest::HeaderParameters&)> is_success,
+    ProgressFunction progress_download, ProgressFunction progress_upload,
+    util::Function<bool()> abandoned,
+    std::chrono::steady_clock::time_point deadline)
     : status_(std::move(status)),
       is_success_(std::move(is_success)),
       progress_download_(std::move(progress_download)),
-      progress_upload_(std::move(progress_upload)) {}
+      progress_upload_(std::move(progress_upload)),
+      abandoned_(std::move(abandoned)),
+      deadline_(deadline) {}
 
 bool HttpCallback::isSuccess(int code,
                              const IHttpRequest::HeaderParameters& h) const {
   return is_success_(code, h);
 }
 
-bool HttpCallback::abort() { return status_() == Request<int>::Cancelled; }
+bool HttpCallback::abort() {
+  return (abandoned_ && abandoned_()) || status_() == Request<int>::Cancelled ||
+         std::chrono::steady_clock::now() >= deadline_.load();
+}
+
+void HttpCallback::extend(std::chrono::steady_clock::time_point deadline) {
+  deadline_ = deadline;
+}
 
 bool HttpCallback::pause() { return status_() == Request<int>::Paused; }
 
+bool HttpCallback::setWakeup(std::function<void()> wakeup) {
+  std::lock_guard<std::mutex> lock(wakeup_mutex_);
+  wakeup_ = std::move(wakeup);
+  return true;
+}
+
+void HttpCallback::wakeup() {
+  std::function<void()> wakeup;
+  {
+    std::lock_guard<std::mutex> lock(wakeup_mutex_);
+    wakeup = wakeup_;
+  }
+  if (wakeup) wakeup();
+}
+
 void HttpCallback::progressDownload(uint64_t total, uint64_t now) {
   if (progress_download_) progress_download_(total, now);
 }
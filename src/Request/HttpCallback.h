@@ -25,20 +25,30 @@
 #define HTTPCALLBACK_H
 
 #include <atomic>
-#include <functional>
+#include <chrono>
+#include <mutex>
 
 #include "IHttp.h"
+#include "Utility/Function.h"
 
 namespace cloudstorage {
 class HttpCallback : public IHttpRequest::ICallback {
  public:
-  using ProgressFunction = std::function<void(uint64_t, uint64_t)>;
+  using ProgressFunction = util::Function<void(uint64_t, uint64_t)>;
 
-  HttpCallback(std::function<int()> status,
-               std::function<bool(int, const IHttpRequest::HeaderParameters&)>
+  /**
+   * @param abandoned optional, when it returns true the request is aborted
+   * regardless of its status
+   * @param deadline the request is aborted once it passes
+   */
+  HttpCallback(util::Function<int()> status,
+               util::Function<bool(int, const IHttpRequest::HeaderParameters&)>
                    is_success,
                ProgressFunction progress_download,
-               ProgressFunction progress_upload);
+               ProgressFunction progress_upload,
+               util::Function<bool()> abandoned = nullptr,
+               std::chrono::steady_clock::time_point deadline =
+                   std::chrono::steady_clock::time_point::max());
 
   bool isSuccess(int, const IHttpRequest::HeaderParameters&) const override;
 
@@ -46,15 +56,31 @@ class HttpCallback : public IHttpRequest::ICallback {
 
   bool pause() override;
 
+  bool setWakeup(std::function<void()>) override;
+
+  /**
+   * Lets the http implementation know that abort or pause may have changed.
+   */
+  void wakeup();
+
+  /**
+   * Moves the deadline the request is aborted at.
+   */
+  void extend(std::chrono::steady_clock::time_point deadline);
+
   void progressDownload(uint64_t total, uint64_t now) override;
 
   void progressUpload(uint64_t, uint64_t) override;
 
  private:
-  std::function<int()> status_;
-  std::function<bool(int, const IHttpRequest::HeaderParameters&)> is_success_;
+  util::Function<int()> status_;
+  util::Function<bool(int, const IHttpRequest::HeaderParameters&)> is_success_;
   ProgressFunction progress_download_;
   ProgressFunction progress_upload_;
+  util::Function<bool()> abandoned_;
+  std::atomic<std::chrono::steady_clock::time_point> deadline_;
+  std::mutex wakeup_mutex_;
+  std::function<void()> wakeup_;
 };
 }  // namespace cloudstorage
 
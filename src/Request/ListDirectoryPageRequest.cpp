@@ -27,14 +27,62 @@
 
 namespace cloudstorage {
 
+namespace {
+
+struct PageStream {
+  std::shared_ptr<CloudProvider::ListingStream> stream_;
+  CloudProvider::ListingStream::ItemCallback sink_;
+};
+
+void streamPage(Request<EitherError<PageData>>::Pointer r,
+                const IItem::Pointer& directory, const std::string& token,
+                const ListDirectoryPageRequest::ItemSink& sink) {
+  // Every attempt parses the page from its beginning, items reported by
+  // attempts which timed out are skipped.
+  auto items = std::make_shared<IItem::List>();
+  auto current = std::make_shared<PageStream>();
+  r->send(
+      [=](util::Output input) {
+        return r->provider()->listDirectoryRequest(*directory, token, *input);
+      },
+      [=](EitherError<Response> e) {
+        if (e.left()) return r->done(e.left());
+        std::string next_token;
+        try {
+          for (auto& t : current->stream_->finish(next_token))
+            current->sink_(t);
+        } catch (const std::exception& e) {
+          return r->done(Error{IHttpRequest::Failure, e.what()});
+        }
+        r->done(PageData{std::move(*items), next_token});
+      },
+      [] { return std::make_shared<std::stringstream>(); },
+      [=]() -> std::shared_ptr<std::ostream> {
+        auto index = std::make_shared<size_t>(0);
+        current->sink_ = [=](IItem::Pointer item) {
+          if ((*index)++ < items->size()) return;
+          items->push_back(item);
+          sink(item);
+        };
+        current->stream_ =
+            r->provider()->listDirectoryStream(*directory, current->sink_);
+        return current->stream_;
+      },
+      nullptr, true);
+}
+
+}  // namespace
+
 ListDirectoryPageRequest::ListDirectoryPageRequest(
     std::shared_ptr<CloudProvider> p, const IItem::Pointer& directory,
-    const std::string& token, const ListDirectoryPageCallback& completed)
+    const std::string& token, const ListDirectoryPageCallback& completed,
+    const ItemSink& sink)
     : Request(std::move(p), completed,
               [=](Request<EitherError<PageData>>::Pointer r) {
                 if (directory->type() != IItem::FileType::Directory)
                   return r->done(
                       Error{IHttpRequest::Bad, util::Error::NOT_A_DIRECTORY});
+                if (sink) return streamPage(r, directory, token, sink);
                 r->request(
                     [=](util::Output input) {
                       return r->provider()->listDirectoryRequest(*directory,
@@ -30,9 +30,17 @@ namespace cloudstorage {
 
 class ListDirectoryPageRequest : public Request<EitherError<PageData>> {
  public:
+  using ItemSink = std::function<void(IItem::Pointer)>;
+
+  /**
+   * @param sink if set, items are passed to it while the response is being
+   * received, provider has to support parsing the listing incrementally;
+   * they are still part of the page
+   */
   ListDirectoryPageRequest(std::shared_ptr<CloudProvider>,
                            const IItem::Pointer &, const std::string &,
-                           const ListDirectoryPageCallback &);
+                           const ListDirectoryPageCallback &,
+                           const ItemSink &sink = nullptr);
 };
 
 }  // namespace cloudstorage
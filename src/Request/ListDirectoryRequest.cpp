@@ -25,16 +25,16 @@
 
 #include "CloudProvider/CloudProvider.h"
 
-using namespace std::placeholders;
-
 namespace cloudstorage {
 
 ListDirectoryRequest::ListDirectoryRequest(std::shared_ptr<CloudProvider> p,
                                            const IItem::Pointer& directory,
                                            const ICallback::Pointer& cb)
-    : Request(std::move(p), [=](EitherError<IItem::List> e) { cb->done(e); },
-              std::bind(&ListDirectoryRequest::resolve, this, _1, directory,
-                        cb.get())) {}
+    : PagedListingRequest(std::move(p),
+                          [=](EitherError<IItem::List> e) { cb->done(e); },
+                          [=, callback = cb.get()](Request::Pointer r) {
+                            resolve(r, directory, callback);
+                          }) {}
 
 ListDirectoryRequest::~ListDirectoryRequest() { cancel(); }
 
@@ -44,25 +44,15 @@ void ListDirectoryRequest::resolve(const Request::Pointer& request,
   if (directory->type() != IItem::FileType::Directory)
     request->done(Error{IHttpRequest::Forbidden, util::Error::NOT_A_DIRECTORY});
   else
-    work(directory, "", callback);
-}
-
-void ListDirectoryRequest::work(const IItem::Pointer& directory,
-                                std::string page_token, ICallback* callback) {
-  auto request = this->shared_from_this();
-  request->make_subrequest(
-      &CloudProvider::listDirectoryPageAsync, directory, std::move(page_token),
-      [=](EitherError<PageData> e) {
-        if (e.left()) return request->done(e.left());
-        for (auto& t : e.right()->items_) {
-          callback->receivedItem(t);
-          result_.push_back(t);
-        }
-        if (!e.right()->next_token_.empty())
-          work(directory, std::move(e.right()->next_token_), callback);
-        else
-          request->done(result_);
-      });
+    listPages(directory, "", true,
+              [=](IItem::Pointer item) {
+                callback->receivedItem(item);
+                result_.push_back(item);
+              },
+              [=](EitherError<void> e) {
+                if (e.left()) return request->done(e.left());
+                request->done(result_);
+              });
 }
 
 }  // namespace cloudstorage
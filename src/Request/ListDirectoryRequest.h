@@ -25,11 +25,12 @@
 #define LISTDIRECTORYREQUEST_H
 
 #include "IItem.h"
-#include "Request.h"
+#include "PagedListingRequest.h"
 
 namespace cloudstorage {
 
-class ListDirectoryRequest : public Request<EitherError<IItem::List>> {
+class ListDirectoryRequest
+    : public PagedListingRequest<EitherError<IItem::List>> {
  public:
   using ICallback = IListDirectoryCallback;
 
@@ -41,8 +42,6 @@ class ListDirectoryRequest : public Request<EitherError<IItem::List>> {
  private:
   void resolve(const Request::Pointer&, const IItem::Pointer& directory,
                ICallback* cb);
-  void work(const IItem::Pointer& directory, std::string page_token,
-            ICallback*);
 
   IItem::List result_;
 };
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * PagedListingRequest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "PagedListingRequest.h"
+
+#include "CloudProvider/CloudProvider.h"
+
+namespace cloudstorage {
+
+template <class T>
+void PagedListingRequest<T>::listPages(IItem::Pointer directory,
+                                       std::string page_token, bool coalesced,
+                                       ItemSink sink,
+                                       CompleteCallback complete) {
+  auto request = this->shared_from_this();
+  std::weak_ptr<Request<T>> weak = request;
+  // Items passed to sink while the page was being received; the rest come
+  // with the page, all of them if it was received for another request.
+  auto streamed = std::make_shared<size_t>(0);
+  request->make_subrequest(
+      coalesced ? &CloudProvider::listDirectoryPageCoalescedAsync
+                : &CloudProvider::listDirectoryPageStreamAsync,
+      directory, std::move(page_token),
+      CloudProvider::ListingStream::ItemCallback([=](IItem::Pointer item) {
+        // Coalesced page request outlives this one if it's shared.
+        auto r = weak.lock();
+        if (!r || r->is_cancelled()) return;
+        ++*streamed;
+        sink(item);
+      }),
+      [=](EitherError<PageData> e) {
+        if (e.left()) return complete(e.left());
+        {
+          // Page request is kept as long as this one, it shouldn't keep
+          // the items, unless they are shared with coalesced requests.
+          auto items = coalesced ? e.right()->items_
+                                 : std::move(e.right()->items_);
+          for (size_t i = *streamed; i < items.size(); i++) sink(items[i]);
+        }
+        if (!e.right()->next_token_.empty())
+          listPages(directory, std::move(e.right()->next_token_), coalesced,
+                    sink, complete);
+        else
+          complete(nullptr);
+      });
+}
+
+template class PagedListingRequest<EitherError<IItem::List>>;
+template class PagedListingRequest<EitherError<uint64_t>>;
+
+}  // namespace cloudstorage
@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * PagedListingRequest.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef PAGEDLISTINGREQUEST_H
+#define PAGEDLISTINGREQUEST_H
+
+#include "IItem.h"
+#include "Request.h"
+
+namespace cloudstorage {
+
+/**
+ * Request listing a directory one page after another; it's what requests
+ * listing directories share, they only differ in what they do with items.
+ */
+template <class ReturnValue>
+class PagedListingRequest : public Request<ReturnValue> {
+ public:
+  using ItemSink = std::function<void(IItem::Pointer)>;
+  using CompleteCallback = std::function<void(EitherError<void>)>;
+
+  using Request<ReturnValue>::Request;
+
+ protected:
+  /**
+   * Lists directory starting with page_token and passes every item to sink.
+   * Pages are parsed while being received if the provider supports it,
+   * otherwise they are fetched with listDirectoryPageAsync.
+   *
+   * @param coalesced whether page requests may attach to identical ones in
+   * flight; their items are shared with these then and reported once the
+   * page is received
+   *
+   * @param complete called once all pages were listed or with the first error
+   */
+  void listPages(IItem::Pointer directory, std::string page_token,
+                 bool coalesced, ItemSink sink, CompleteCallback complete);
+};
+
+}  // namespace cloudstorage
+
+#endif  // PAGEDLISTINGREQUEST_H
@@ -25,17 +25,66 @@
 
 #include "CloudProvider/CloudProvider.h"
 #include "HttpCallback.h"
+#include "IMetrics.h"
 #include "Utility/Utility.h"
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <cctype>
 
-using namespace std::placeholders;
-
 namespace cloudstorage {
 
 namespace {
 
+const char* const DEFAULT_OPERATION = "other";
+
+thread_local const IHttpRequest::Priority* current_priority = nullptr;
+thread_local const char* current_operation = nullptr;
+thread_local const DeadlineScope::Clock::time_point* current_deadline =
+    nullptr;
+
+/**
+ * Passes everything to output owned by the caller, remembering whether
+ * anything was written.
+ */
+class TrackedOutput : public std::ostream {
+ public:
+  explicit TrackedOutput(std::shared_ptr<std::ostream> output)
+      : std::ostream(&buffer_),
+        output_(std::move(output)),
+        buffer_(output_->rdbuf()) {}
+
+  bool written() const { return buffer_.written_; }
+
+ private:
+  class Buffer : public std::streambuf {
+   public:
+    explicit Buffer(std::streambuf* target) : target_(target), written_() {}
+
+    std::streamsize xsputn(const char_type* data,
+                           std::streamsize length) override {
+      written_ = true;
+      return target_->sputn(data, length);
+    }
+
+    int_type overflow(int_type c) override {
+      if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+      written_ = true;
+      return target_->sputc(traits_type::to_char_type(c));
+    }
+
+    int sync() override { return target_->pubsync(); }
+
+    std::streambuf* target_;
+    std::atomic_bool written_;
+  };
+
+  std::shared_ptr<std::ostream> output_;
+  Buffer buffer_;
+};
+
 template <class T1, class T2>
 struct compare {
   bool operator()(Request<T1>*, Request<T2>*) const { return false; }
@@ -48,6 +97,42 @@ struct compare<T, T> {
 
 }  // namespace
 
+PriorityScope::PriorityScope(IHttpRequest::Priority priority)
+    : priority_(priority), previous_(current_priority) {
+  current_priority = &priority_;
+}
+
+PriorityScope::~PriorityScope() { current_priority = previous_; }
+
+const IHttpRequest::Priority* PriorityScope::current() {
+  return current_priority;
+}
+
+OperationScope::OperationScope(const char* operation)
+    : previous_(current_operation) {
+  current_operation = operation;
+}
+
+OperationScope::~OperationScope() { current_operation = previous_; }
+
+const char* OperationScope::current() { return current_operation; }
+
+DeadlineScope::DeadlineScope(Clock::time_point deadline)
+    : deadline_(current_deadline ? std::min(deadline, *current_deadline)
+                                 : deadline),
+      previous_(current_deadline) {
+  current_deadline = &deadline_;
+}
+
+DeadlineScope::DeadlineScope(Clock::duration timeout)
+    : DeadlineScope(Clock::now() + timeout) {}
+
+DeadlineScope::~DeadlineScope() { current_deadline = previous_; }
+
+const DeadlineScope::Clock::time_point* DeadlineScope::current() {
+  return current_deadline;
+}
+
 Response::Response(IHttpRequest::Response r) : http_(std::move(r)) {}
 
 int Response::http_code() const { return http_.http_code_; }
@@ -56,8 +141,8 @@ const IHttpRequest::HeaderParameters& Response::headers() const {
   return http_.headers_;
 }
 
-std::stringstream& Response::output() {
-  return static_cast<std::stringstream&>(*http_.output_stream_.get());
+util::ChunkedStream& Response::output() {
+  return static_cast<util::ChunkedStream&>(*http_.output_stream_.get());
 }
 
 std::stringstream& Response::error_output() {
@@ -98,24 +183,47 @@ void Request<T>::Wrapper::resume() {
   return request_->resume();
 }
 
+template <class T>
+bool Request<T>::Wrapper::is_finished() const {
+  return request_->is_finished();
+}
+
+template <class T>
+void Request<T>::Wrapper::adjust(IHttpRequest::Priority priority,
+                                 DeadlineScope::Clock::time_point deadline) {
+  request_->adjust(priority, deadline);
+}
+
 template <class T>
 Request<T>::Request(std::shared_ptr<CloudProvider> provider, Callback callback,
-                    Resolver resolver)
-    : future_(value_.get_future()),
-      resolver_(std::move(resolver)),
+                    Resolver resolver, IHttpRequest::Priority priority)
+    : resolver_(std::move(resolver)),
       callback_(std::move(callback)),
       provider_(std::move(provider)),
-      status_(None) {}
+      status_(None),
+      finished_(false),
+      priority_(PriorityScope::current() ? *PriorityScope::current()
+                                         : priority),
+      operation_(OperationScope::current() ? OperationScope::current()
+                                           : DEFAULT_OPERATION),
+      metrics_key_(provider_ ? provider_->metricsKey(operation_) : nullptr),
+      deadline_(provider_ ? provider_->requestDeadline()
+                          : DeadlineScope::current()
+                                ? *DeadlineScope::current()
+                                : DeadlineScope::Clock::time_point::max()) {}
 
 template <class T>
 Request<T>::~Request() {
-  Request<T>::finish();
+  // Request dropped without calling back, if it's still registered.
+  if (provider_) provider_->removePendingRequest(this);
 }
 
 template <class T>
 void Request<T>::finish() {
-  std::shared_future<T> future = future_;
-  if (future.valid()) future.wait();
+  {
+    std::unique_lock<std::mutex> lock(value_mutex_);
+    value_ready_.wait(lock, [this] { return finished_.load(); });
+  }
   {
     std::unique_lock<std::recursive_mutex> lock(subrequest_mutex_);
     for (size_t i = 0; i < subrequests_.size(); i++) {
@@ -137,13 +245,21 @@ void Request<T>::cancel() {
     std::unique_lock<std::mutex> lock(status_mutex_);
     status_ = Cancelled;
   }
+  wakeup_transfers();
+  {
+    std::unique_lock<std::mutex> lock(provider_mutex_);
+    auto p = provider();
+    lock.unlock();
+    if (p) p->concurrency_limit_.cancel(this);
+  }
   {
     std::unique_lock<std::mutex> lock(provider_mutex_);
     auto p = provider();
     if (p) {
       std::unique_lock<std::mutex> lock(p->current_authorization_mutex_);
       auto it = p->auth_callbacks_.find(this);
-      if (it != std::end(p->auth_callbacks_)) {
+      bool waiting = it != std::end(p->auth_callbacks_);
+      if (waiting) {
         while (!it->second.empty()) {
           {
             auto c = it->second.back();
@@ -155,9 +271,15 @@ void Request<T>::cancel() {
         }
         p->auth_callbacks_.erase(it);
       }
-      if (p->auth_callbacks_.empty() && p->current_authorization_) {
+      // Authorization is dropped once the last request waiting for it is
+      // cancelled, or when it's cancelled itself.
+      bool self = p->current_authorization_ &&
+                  compare<T, EitherError<void>>()(
+                      this, p->current_authorization_.get());
+      if (p->auth_callbacks_.empty() && p->current_authorization_ &&
+          (self || waiting)) {
         auto auth = util::exchange(p->current_authorization_, nullptr);
-        if (!compare<T, EitherError<void>>()(this, auth.get())) {
+        if (!self) {
           lock.unlock();
           auth->cancel();
         }
@@ -173,40 +295,57 @@ void Request<T>::cancel() {
       lock.lock();
     }
   }
-  finish();
 }
 
 template <class T>
 void Request<T>::pause() {
-  std::unique_lock<std::mutex> lock1(status_mutex_);
-  std::unique_lock<std::recursive_mutex> lock2(subrequest_mutex_);
-  if (status_ != Cancelled) status_ = Paused;
-  for (size_t i = 0; i < subrequests_.size(); i++) {
-    subrequests_[i]->pause();
+  {
+    std::unique_lock<std::mutex> lock1(status_mutex_);
+    std::unique_lock<std::recursive_mutex> lock2(subrequest_mutex_);
+    if (status_ != Cancelled) status_ = Paused;
+    for (size_t i = 0; i < subrequests_.size(); i++) {
+      subrequests_[i]->pause();
+    }
   }
+  wakeup_transfers();
 }
 
 template <class T>
 void Request<T>::resume() {
-  std::unique_lock<std::mutex> lock1(status_mutex_);
-  std::unique_lock<std::recursive_mutex> lock2(subrequest_mutex_);
-  if (status_ != Cancelled) {
-    status_ = None;
-    for (size_t i = 0; i < subrequests_.size(); i++) {
-      subrequests_[i]->resume();
+  {
+    std::unique_lock<std::mutex> lock1(status_mutex_);
+    std::unique_lock<std::recursive_mutex> lock2(subrequest_mutex_);
+    if (status_ != Cancelled) {
+      status_ = None;
+      for (size_t i = 0; i < subrequests_.size(); i++) {
+        subrequests_[i]->resume();
+      }
     }
   }
+  wakeup_transfers();
+}
+
+template <class T>
+void Request<T>::wakeup_transfers() {
+  std::vector<std::shared_ptr<HttpCallback>> transfers;
+  {
+    std::lock_guard<std::mutex> lock(transfers_mutex_);
+    for (auto&& t : transfers_)
+      if (auto callback = t.lock()) transfers.push_back(callback);
+  }
+  for (auto&& t : transfers) t->wakeup();
 }
 
 template <class T>
 T Request<T>::result() {
   finish();
-  return future_.get();
+  return value_;
 }
 
 template <typename T>
 typename Request<T>::Wrapper::Pointer Request<T>::run() {
   if (!resolver_) throw std::runtime_error(util::Error::RESOLVER_NOT_SET);
+  if (provider_) provider_->addPendingRequest(this->shared_from_this());
   util::exchange(resolver_, nullptr)(this->shared_from_this());
   return util::make_unique<Wrapper>(this->shared_from_this());
 }
@@ -214,21 +353,67 @@ typename Request<T>::Wrapper::Pointer Request<T>::run() {
 template <class T>
 void Request<T>::done(const T& t) {
   if (!callback_) throw std::runtime_error(util::Error::CALLBACK_NOT_SET);
+  // finish() drops provider_ only once the request is finished.
+  auto provider = this->provider();
+  if (provider) provider->callbackPendingRequest(this);
   util::exchange(callback_, nullptr)(t);
-  value_.set_value(t);
+  {
+    std::lock_guard<std::mutex> lock(value_mutex_);
+    value_ = t;
+    finished_ = true;
+    value_ready_.notify_all();
+  }
+  if (provider) provider->removePendingRequest(this);
 }
 
 template <class T>
-std::unique_ptr<HttpCallback> Request<T>::http_callback(
+void Request<T>::adjust(IHttpRequest::Priority priority,
+                        DeadlineScope::Clock::time_point deadline) {
+  // Interactive is the highest priority.
+  auto current_priority = priority_.load();
+  while (priority < current_priority &&
+         !priority_.compare_exchange_weak(current_priority, priority))
+    ;
+  auto current_deadline = deadline_.load();
+  while (deadline > current_deadline &&
+         !deadline_.compare_exchange_weak(current_deadline, deadline))
+    ;
+  priority = priority_;
+  deadline = deadline_;
+  {
+    std::lock_guard<std::mutex> lock(transfers_mutex_);
+    for (auto&& t : transfers_)
+      if (auto callback = t.lock()) callback->extend(deadline);
+  }
+  std::unique_lock<std::mutex> provider_lock(provider_mutex_);
+  auto p = provider();
+  provider_lock.unlock();
+  if (p) p->concurrency_limit_.prioritize(this, priority);
+  std::unique_lock<std::recursive_mutex> lock(subrequest_mutex_);
+  for (size_t i = 0; i < subrequests_.size(); i++) {
+    auto r = subrequests_[i];
+    lock.unlock();
+    if (auto adjustable = dynamic_cast<IAdjustable*>(r.get()))
+      adjustable->adjust(priority, deadline);
+    lock.lock();
+  }
+}
+
+template <class T>
+std::shared_ptr<HttpCallback> Request<T>::http_callback(
     const ProgressFunction& progress_download,
-    const ProgressFunction& progress_upload) {
-  return util::make_unique<HttpCallback>(
-      [=] {
+    const ProgressFunction& progress_upload,
+    const util::Function<bool()>& abandoned) {
+  auto provider = provider_.get();
+  return std::make_shared<HttpCallback>(
+      [this] {
         std::unique_lock<std::mutex> lock(status_mutex_);
         return status_;
       },
-      std::bind(&CloudProvider::isSuccess, provider_.get(), _1, _2),
-      progress_download, progress_upload);
+      [provider](int code, const IHttpRequest::HeaderParameters& headers) {
+        return provider->isSuccess(code, headers);
+      },
+      progress_download, progress_upload, abandoned, deadline_);
 }
 
 template <class T>
@@ -242,6 +427,7 @@ void Request<T>::reauthorize(const AuthorizeCompleted& c) {
   p->auth_callbacks_[this].push_back(c);
   if (!p->current_authorization_) {
     {
+      OperationScope scope("authorize");
       auto r = p->authorizeAsync();
       p->current_authorization_ = r;
       lock.unlock();
@@ -270,7 +456,7 @@ void Request<T>::request(const RequestFactory& factory,
                          const RequestCompleted& complete) {
   this->send(factory, complete,
              [] { return std::make_shared<std::stringstream>(); },
-             std::make_shared<std::stringstream>(), nullptr, nullptr, true);
+             nullptr, nullptr, nullptr, true);
 }
 
 template <class T>
@@ -278,7 +464,7 @@ void Request<T>::send(const RequestFactory& factory,
                       const RequestCompleted& complete) {
   this->send(factory, complete,
              [] { return std::make_shared<std::stringstream>(); },
-             std::make_shared<std::stringstream>(), nullptr, nullptr, false);
+             nullptr, nullptr, nullptr, false);
 }
 
 template <class T>
@@ -286,8 +472,7 @@ void Request<T>::query(const RequestFactory& factory,
                        const IHttpRequest::CompleteCallback& complete) {
   auto input = std::make_shared<std::stringstream>();
   auto request = factory(input);
-  this->send(request.get(), complete, input,
-             std::make_shared<std::stringstream>(),
+  this->send(request, complete, input, std::make_shared<util::ChunkedStream>(),
              std::make_shared<std::stringstream>(), nullptr, nullptr);
 }
 
@@ -298,62 +483,227 @@ void Request<T>::send(const RequestFactory& factory,
                       const std::shared_ptr<std::ostream>& output,
                       const ProgressFunction& download,
                       const ProgressFunction& upload, bool authorized) {
+  send(std::make_shared<Transfer>(Transfer{
+           factory, complete, input_factory,
+           output ? std::make_shared<TrackedOutput>(output) : nullptr,
+           nullptr, download, upload, authorized}),
+       0);
+}
+
+template <class T>
+void Request<T>::send(const RequestFactory& factory,
+                      const RequestCompleted& complete,
+                      const InputFactory& input_factory,
+                      const OutputFactory& output,
+                      const ProgressFunction& download, bool authorized) {
+  send(std::make_shared<Transfer>(Transfer{factory, complete, input_factory,
+                                           nullptr, output, download, nullptr,
+                                           authorized}),
+       0);
+}
+
+template <class T>
+void Request<T>::send(const std::shared_ptr<Transfer>& transfer,
+                      uint32_t attempt) {
   auto request = this->shared_from_this();
-  auto input = input_factory();
+  auto output_stream = [=]() -> std::shared_ptr<std::ostream> {
+    if (transfer->output_) return transfer->output_;
+    if (transfer->output_factory_) return transfer->output_factory_();
+    return std::make_shared<util::ChunkedStream>();
+  };
+  auto written = [=] {
+    return transfer->output_ &&
+           static_cast<TrackedOutput&>(*transfer->output_).written();
+  };
+  auto resend = [=] {
+    if (this->is_cancelled())
+      return transfer->complete_(
+          Error{IHttpRequest::Aborted, util::Error::ABORTED});
+    if (this->is_expired())
+      return transfer->complete_(
+          Error{IHttpRequest::Timeout, util::Error::DEADLINE_EXCEEDED});
+    this->send(transfer, attempt + 1);
+  };
+  auto input = transfer->input_factory_();
   auto error_stream = std::make_shared<std::stringstream>();
-  auto r = factory(input);
-  if (authorized) authorize(r);
-  send(r.get(),
-       [=](IHttpRequest::Response response) {
-         if (provider()->isSuccess(response.http_code_, response.headers_))
-           return complete(Response(response));
-         if (authorized &&
-             this->reauthorize(response.http_code_, response.headers_)) {
-           this->reauthorize([=](EitherError<void> e) {
-             if (e.left()) {
-               if (e.left()->code_ != IHttpRequest::Aborted &&
-                   e.left()->code_ > 0)
-                 return complete(
-                     Error{IHttpRequest::Unauthorized, e.left()->description_});
-               else
-                 return complete(
-                     Error{response.http_code_, error_stream->str()});
-             }
-             auto input = input_factory();
-             auto error_stream = std::make_shared<std::stringstream>();
-             auto r = factory(input);
-             if (authorized) authorize(r);
-             this->send(
-                 r.get(),
-                 [=](IHttpRequest::Response response) {
-                   (void)request;
-                   if (provider()->isSuccess(response.http_code_,
-                                             response.headers_))
-                     complete(Response(response));
-                   else
-                     complete(Error{response.http_code_, error_stream->str()});
-                 },
-                 input, output, error_stream, download, upload);
-           });
-         } else {
-           complete(Error{response.http_code_, error_stream->str()});
-         }
-       },
-       input, output, error_stream, download, upload);
-}
-
-template <class T>
-void Request<T>::send(IHttpRequest* request,
+  auto r = transfer->factory_(input);
+  if (transfer->authorized_) authorize(r);
+  std::string method = r ? r->method() : "";
+  auto received = [=](std::shared_ptr<std::stringstream> error_stream)
+      -> IHttpRequest::CompleteCallback {
+    return [=](IHttpRequest::Response response) {
+      if (provider()->isSuccess(response.http_code_, response.headers_))
+        return transfer->complete_(Response(response));
+      if (transfer->authorized_ &&
+          this->reauthorize(response.http_code_, response.headers_)) {
+        this->reauthorize([=](EitherError<void> e) {
+          if (e.left()) {
+            if (e.left()->code_ != IHttpRequest::Aborted && e.left()->code_ > 0)
+              return transfer->complete_(
+                  Error{IHttpRequest::Unauthorized, e.left()->description_});
+            else
+              return transfer->complete_(
+                  Error{response.http_code_, error_stream->str()});
+          }
+          auto input = transfer->input_factory_();
+          auto error_stream = std::make_shared<std::stringstream>();
+          auto r = transfer->factory_(input);
+          if (transfer->authorized_) authorize(r);
+          this->send(
+              r,
+              [=](IHttpRequest::Response response) {
+                (void)request;
+                if (provider()->isSuccess(response.http_code_,
+                                          response.headers_))
+                  transfer->complete_(Response(response));
+                else if (!this->retry(attempt, method, written(), response,
+                                      resend))
+                  transfer->complete_(
+                      Error{response.http_code_, error_stream->str()});
+              },
+              input, output_stream(), error_stream, transfer->download_,
+              transfer->upload_);
+        });
+      } else if (!this->retry(attempt, method, written(), response,
+                              resend)) {
+        transfer->complete_(Error{response.http_code_, error_stream->str()});
+      }
+    };
+  };
+  auto p = provider();
+  if (!p->hedge_policy_.enabled() || transfer->output_ ||
+      transfer->output_factory_ || method != "GET")
+    return send(r, received(error_stream), input, output_stream(),
+                error_stream, transfer->download_, transfer->upload_);
+  // Idempotent request with its own output; if it doesn't answer in time, an
+  // identical one is sent and whichever answers first wins, the other one is
+  // aborted.
+  auto winner = std::make_shared<std::atomic_int>(-1);
+  auto race = [=](int index, const IHttpRequest::Pointer& r,
+                  const std::shared_ptr<std::istream>& input,
+                  const std::shared_ptr<std::stringstream>& error_stream) {
+    auto start = std::chrono::steady_clock::now();
+    auto completed = received(error_stream);
+    this->send(r,
+               [=](IHttpRequest::Response response) {
+                 int none = -1;
+                 if (!winner->compare_exchange_strong(none, index)) return;
+                 this->wakeup_transfers();
+                 if (response.http_code_ != IHttpRequest::Aborted)
+                   p->hedge_policy_.record(
+                       std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start));
+                 completed(response);
+               },
+               input, output_stream(), error_stream, transfer->download_,
+               transfer->upload_, [=] {
+                 int current = *winner;
+                 return current != -1 && current != index;
+               });
+  };
+  auto threshold = p->hedge_policy_.start();
+  race(0, r, input, error_stream);
+  if (threshold == std::chrono::microseconds::max()) return;
+  p->thread_pool()->schedule(
+      [=] {
+        (void)request;
+        if (*winner != -1 || this->is_cancelled() || !p->hedge_policy_.hedge())
+          return;
+        auto input = transfer->input_factory_();
+        auto r = transfer->factory_(input);
+        if (transfer->authorized_) authorize(r);
+        race(1, r, input, std::make_shared<std::stringstream>());
+      },
+      std::chrono::system_clock::now() + threshold);
+}
+
+template <class T>
+bool Request<T>::retry(uint32_t attempt, const std::string& method,
+                       bool written, const IHttpRequest::Response& response,
+                       const util::Function<void()>& resend) {
+  auto p = provider();
+  if (attempt + 1 >= p->retry_attempts_ || is_cancelled() ||
+      (written && response.http_code_ == IHttpRequest::Timeout) ||
+      !p->isRetryable(method, response.http_code_, response.headers_))
+    return false;
+  auto delay = p->retryDelay(attempt, response.headers_);
+  if (delay > p->retry_max_delay_ ||
+      DeadlineScope::Clock::now() + delay >= deadline_.load())
+    return false;
+  auto self = this->shared_from_this();
+  p->thread_pool()->schedule(
+      [=] {
+        (void)self;
+        resend();
+      },
+      std::chrono::system_clock::now() + delay);
+  return true;
+}
+
+template <class T>
+void Request<T>::send(const IHttpRequest::Pointer& request,
                       const IHttpRequest::CompleteCallback& complete,
                       const std::shared_ptr<std::istream>& input,
                       const std::shared_ptr<std::ostream>& output,
                       const std::shared_ptr<std::ostream>& error,
                       const ProgressFunction& download,
-                      const ProgressFunction& upload) {
-  if (request)
-    request->send(complete, input, output, error,
-                  http_callback(download, upload));
-  else {
+                      const ProgressFunction& upload,
+                      const util::Function<bool()>& abandoned) {
+  if (request) {
+    auto provider = this->provider();
+    auto metrics_key = metrics_key_;
+    auto callback = http_callback(download, upload, abandoned);
+    {
+      std::lock_guard<std::mutex> lock(transfers_mutex_);
+      transfers_.erase(
+          std::remove_if(transfers_.begin(), transfers_.end(),
+                         [](const std::weak_ptr<HttpCallback>& t) {
+                           return t.expired();
+                         }),
+          transfers_.end());
+      transfers_.push_back(callback);
+    }
+    request->setPriority(priority_);
+    request->setDeadline(deadline_);
+    provider->throttle(request.get());
+    // Long poll is idle by design and bodies of downloads and uploads, which
+    // can be paused by whoever consumes them, may take arbitrarily long;
+    // either would only hold back the limit for the requests queued behind.
+    bool body = download || upload;
+    bool limited = !request->longPoll() &&
+                   (!body || priority_ == IHttpRequest::Priority::Interactive);
+    IHttpRequest::CompleteCallback completed =
+        [=](IHttpRequest::Response response) {
+          if (limited)
+            provider->concurrency_limit_.release(provider->isThrottled(
+                response.http_code_, response.headers_));
+          if (response.http_code_ == IHttpRequest::Aborted &&
+              !this->is_cancelled() && this->is_expired()) {
+            response.http_code_ = IHttpRequest::Timeout;
+            if (response.error_stream_)
+              *response.error_stream_ << util::Error::DEADLINE_EXCEEDED;
+          }
+          if (metrics_key)
+            IMetrics::instance().record(metrics_key, response.http_code_,
+                                        response.metrics_);
+          complete(response);
+        };
+    auto start = [=] {
+      if (this->is_cancelled()) {
+        *error << util::Error::ABORTED;
+        return completed({IHttpRequest::Aborted, {}, output, error});
+      }
+      if (this->is_expired()) {
+        *error << util::Error::DEADLINE_EXCEEDED;
+        return completed({IHttpRequest::Timeout, {}, output, error});
+      }
+      request->send(completed, input, output, error, callback);
+    };
+    if (limited)
+      provider->concurrency_limit_.acquire(priority_, this, start);
+    else
+      start();
+  } else {
     *error << util::Error::UNIMPLEMENTED;
     complete({IHttpRequest::Aborted, {}, output, error});
   }
@@ -364,28 +714,71 @@ std::shared_ptr<CloudProvider> Request<T>::provider() const {
   return provider_;
 }
 
+template <class T>
+IHttpRequest::Priority Request<T>::priority() const {
+  return priority_;
+}
+
+template <class T>
+const char* Request<T>::operation() const {
+  return operation_;
+}
+
+template <class T>
+DeadlineScope::Clock::time_point Request<T>::deadline() const {
+  return deadline_;
+}
+
 template <class T>
 bool Request<T>::is_cancelled() const {
   std::unique_lock<std::mutex> lock(status_mutex_);
   return status_ == Cancelled;
 }
 
+template <class T>
+bool Request<T>::is_expired() const {
+  return DeadlineScope::Clock::now() >= deadline_.load();
+}
+
 template <class T>
 bool Request<T>::is_paused() const {
   std::unique_lock<std::mutex> lock(status_mutex_);
   return status_ == Paused;
 }
 
+template <class T>
+bool Request<T>::is_finished() const {
+  return finished_;
+}
+
 template <class T>
 void Request<T>::subrequest(std::shared_ptr<IGenericRequest> request) {
   if (is_cancelled())
     request->cancel();
   else {
+    std::vector<std::shared_ptr<IGenericRequest>> finished;
     std::lock_guard<std::recursive_mutex> lock(subrequest_mutex_);
+    release_finished(finished);
     subrequests_.push_back(request);
   }
 }
 
+template <class T>
+void Request<T>::release_finished(
+    std::vector<std::shared_ptr<IGenericRequest>>& finished) {
+  auto it = subrequests_.begin();
+  for (auto& r : subrequests_) {
+    auto f = dynamic_cast<const IFinishable*>(r.get());
+    if (f && f->is_finished()) {
+      finished.push_back(std::move(r));
+    } else {
+      if (&*it != &r) *it = std::move(r);
+      ++it;
+    }
+  }
+  subrequests_.erase(it, subrequests_.end());
+}
+
 template class Request<EitherError<PageData>>;
 template class Request<EitherError<Token>>;
 template class Request<EitherError<std::vector<char>>>;
@@ -394,5 +787,7 @@ template class Request<EitherError<IItem>>;
 template class Request<EitherError<IItem::List>>;
 template class Request<EitherError<void>>;
 template class Request<EitherError<GeneralData>>;
+template class Request<EitherError<uint64_t>>;
+template class Request<EitherError<ChangesData>>;
 
 }  // namespace cloudstorage
@@ -24,13 +24,17 @@
 #ifndef REQUEST_H
 #define REQUEST_H
 
-#include <future>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <sstream>
 #include <vector>
 
 #include "IHttp.h"
+#include "IMetrics.h"
 #include "IRequest.h"
+#include "Utility/ChunkedBuffer.h"
+#include "Utility/Function.h"
 #include "Utility/Utility.h"
 
 namespace cloudstorage {
@@ -45,30 +49,104 @@ class Response {
 
   int http_code() const;
   const IHttpRequest::HeaderParameters& headers() const;
-  std::stringstream& output();
+  util::ChunkedStream& output();
   std::stringstream& error_output();
 
  private:
   IHttpRequest::Response http_;
 };
 
+/**
+ * Requests created while PriorityScope is alive on the current thread inherit
+ * its priority instead of using their default one. That's how make_subrequest
+ * propagates priority through ICloudProvider's methods.
+ */
+class PriorityScope {
+ public:
+  PriorityScope(IHttpRequest::Priority);
+  ~PriorityScope();
+
+  /**
+   * @return priority of the innermost scope alive on the current thread or
+   * nullptr if there is none
+   */
+  static const IHttpRequest::Priority* current();
+
+ private:
+  IHttpRequest::Priority priority_;
+  const IHttpRequest::Priority* previous_;
+};
+
+/**
+ * Names the ICloudProvider's operation requests created while the scope is
+ * alive on the current thread are done for; transfers of these requests and
+ * of their subrequests are recorded in IMetrics under that name.
+ */
+class OperationScope {
+ public:
+  OperationScope(const char* operation);
+  ~OperationScope();
+
+  /**
+   * @return operation of the innermost scope alive on the current thread or
+   * nullptr if there is none
+   */
+  static const char* current();
+
+ private:
+  const char* previous_;
+};
+
+/**
+ * Implemented by requests which can tell, without blocking, that they are
+ * done and their callbacks returned, so dropping them can't wait for anything.
+ * Parents release such subrequests instead of holding them until they finish.
+ */
+class IFinishable {
+ public:
+  virtual ~IFinishable() = default;
+
+  virtual bool is_finished() const = 0;
+};
+
+/**
+ * Implemented by requests which can be made more urgent while they run, for
+ * callers attached to them after they were started.
+ */
+class IAdjustable {
+ public:
+  virtual ~IAdjustable() = default;
+
+  /**
+   * Raises priority and extends deadline of the request and its subrequests,
+   * never the other way round. Transfers in flight abort no sooner than the
+   * new deadline, though they may still time out on the old one and be
+   * retried.
+   */
+  virtual void adjust(IHttpRequest::Priority,
+                      DeadlineScope::Clock::time_point deadline) = 0;
+};
+
 template <class ReturnValue>
 class Request : public IRequest<ReturnValue>,
                 public std::enable_shared_from_this<Request<ReturnValue>> {
  public:
   using Pointer = std::shared_ptr<Request<ReturnValue>>;
-  using ProgressFunction = std::function<void(uint64_t, uint64_t)>;
+  using ProgressFunction = util::Function<void(uint64_t, uint64_t)>;
   using RequestFactory =
-      std::function<IHttpRequest::Pointer(std::shared_ptr<std::ostream>)>;
-  using InputFactory = std::function<std::shared_ptr<std::iostream>()>;
-  using Callback = std::function<void(ReturnValue)>;
-  using Resolver = std::function<void(std::shared_ptr<Request>)>;
-  using AuthorizeCompleted = std::function<void(EitherError<void>)>;
-  using RequestCompleted = std::function<void(EitherError<Response>)>;
+      util::Function<IHttpRequest::Pointer(std::shared_ptr<std::ostream>)>;
+  using InputFactory = util::Function<std::shared_ptr<std::iostream>()>;
+  using OutputFactory = util::Function<std::shared_ptr<std::ostream>()>;
+  using Callback = util::Function<void(ReturnValue)>;
+  using Resolver = util::Function<void(std::shared_ptr<Request>)>;
+  using AuthorizeCompleted = util::Function<void(EitherError<void>)>;
+  using RequestCompleted = util::Function<void(EitherError<Response>)>;
 
   enum Status { None = 0, Cancelled = 1, Paused = 2 };
 
-  class Wrapper : public IRequest<ReturnValue> {
+  class Wrapper : public IRequest<ReturnValue>,
+                  public IFinishable,
+                  public IAdjustable {
    public:
     Wrapper(typename Request<ReturnValue>::Pointer);
     ~Wrapper() override;
@@ -78,12 +156,16 @@ class Request : public IRequest<ReturnValue>,
     ReturnValue result() override;
     void pause() override;
     void resume() override;
+    bool is_finished() const override;
+    void adjust(IHttpRequest::Priority,
+                DeadlineScope::Clock::time_point deadline) override;
 
    private:
     typename Request<ReturnValue>::Pointer request_;
   };
 
-  Request(std::shared_ptr<CloudProvider>, Callback, Resolver);
+  Request(std::shared_ptr<CloudProvider>, Callback, Resolver,
+          IHttpRequest::Priority = IHttpRequest::Priority::Interactive);
   ~Request() override;
 
   void finish() override;
@@ -97,11 +179,28 @@ class Request : public IRequest<ReturnValue>,
 
   void reauthorize(const AuthorizeCompleted&);
 
+  void adjust(IHttpRequest::Priority, DeadlineScope::Clock::time_point);
+
+  /**
+   * Sends request made by factory, reauthorizing and retrying when needed.
+   * When output is null, every attempt writes to its own stringstream which
+   * ends up in the response; GET requests sent that way are idempotent and
+   * may be hedged. Output owned by the caller can't take back what a timed
+   * out attempt wrote, so such attempt is retried only if it wrote nothing.
+   */
   void send(const RequestFactory& factory, const RequestCompleted&,
             const InputFactory&, const std::shared_ptr<std::ostream>& output,
             const ProgressFunction& download, const ProgressFunction& upload,
             bool authorized);
 
+  /**
+   * Same as above, but every attempt writes to a fresh stream made by output
+   * factory, so that it can be retried whatever the previous one wrote.
+   */
+  void send(const RequestFactory& factory, const RequestCompleted&,
+            const InputFactory&, const OutputFactory& output,
+            const ProgressFunction& download, bool authorized);
+
   void request(const RequestFactory& factory, const RequestCompleted&);
   void send(const RequestFactory& factory, const RequestCompleted&);
   void query(const RequestFactory& factory,
@@ -109,8 +208,20 @@ class Request : public IRequest<ReturnValue>,
 
   std::shared_ptr<CloudProvider> provider() const;
 
+  IHttpRequest::Priority priority() const;
+
+  const char* operation() const;
+
+  /**
+   * @return time by which the request has to complete, max if there is no
+   * deadline
+   */
+  DeadlineScope::Clock::time_point deadline() const;
+
   bool is_cancelled() const;
+  bool is_expired() const;
   bool is_paused() const;
+  bool is_finished() const;
 
   template <class Type = CloudProvider, class Method, class... Args>
   void make_subrequest(Method method, Args... args) {
@@ -118,7 +229,12 @@ class Request : public IRequest<ReturnValue>,
       call(LastArgument<Args...>()(args...),
            Error{IHttpRequest::Aborted, util::Error::ABORTED});
     } else {
+      std::vector<std::shared_ptr<IGenericRequest>> finished;
       std::lock_guard<std::recursive_mutex> lock(subrequest_mutex_);
+      release_finished(finished);
+      PriorityScope priority_scope(priority_);
+      OperationScope operation_scope(operation_);
+      DeadlineScope deadline_scope(deadline_);
       subrequests_.push_back((static_cast<Type*>(provider().get())->*method)(
           std::forward<Args>(args)...));
     }
@@ -130,19 +246,55 @@ class Request : public IRequest<ReturnValue>,
  private:
   friend class AuthorizeRequest;
 
-  std::unique_ptr<HttpCallback> http_callback(
+  /**
+   * Parameters of send shared by all its attempts, so that callbacks of every
+   * attempt only have to keep a pointer to them.
+   */
+  struct Transfer {
+    RequestFactory factory_;
+    RequestCompleted complete_;
+    InputFactory input_factory_;
+    std::shared_ptr<std::ostream> output_;
+    OutputFactory output_factory_;
+    ProgressFunction download_;
+    ProgressFunction upload_;
+    bool authorized_;
+  };
+
+  std::shared_ptr<HttpCallback> http_callback(
       const ProgressFunction& progress_download = nullptr,
-      const ProgressFunction& progress_upload = nullptr);
+      const ProgressFunction& progress_upload = nullptr,
+      const util::Function<bool()>& abandoned = nullptr);
+
+  void send(const std::shared_ptr<Transfer>&, uint32_t attempt);
 
-  void send(IHttpRequest*, const IHttpRequest::CompleteCallback& complete,
+  /**
+   * Makes the http implementation check the transfers in flight right away,
+   * after they were cancelled, paused, resumed or abandoned.
+   */
+  void wakeup_transfers();
+
+  bool retry(uint32_t attempt, const std::string& method, bool written,
+             const IHttpRequest::Response&,
+             const util::Function<void()>& resend);
+
+  void send(const IHttpRequest::Pointer&,
+            const IHttpRequest::CompleteCallback& complete,
             const std::shared_ptr<std::istream>& input,
             const std::shared_ptr<std::ostream>& output,
             const std::shared_ptr<std::ostream>& error,
             const ProgressFunction& download = nullptr,
-            const ProgressFunction& upload = nullptr);
+            const ProgressFunction& upload = nullptr,
+            const util::Function<bool()>& abandoned = nullptr);
 
   void subrequest(std::shared_ptr<IGenericRequest>);
 
+  /**
+   * Moves finished subrequests to the given vector, which should be destroyed
+   * after subrequest_mutex_ is unlocked.
+   */
+  void release_finished(std::vector<std::shared_ptr<IGenericRequest>>&);
+
   template <class First, class... Rest>
   struct LastArgument {
     using Type = typename LastArgument<Rest...>::Type;
@@ -174,16 +326,24 @@ class Request : public IRequest<ReturnValue>,
     c(std::forward<Args>(args)...);
   }
 
-  std::promise<ReturnValue> value_;
-  std::shared_future<ReturnValue> future_;
+  std::mutex value_mutex_;
+  std::condition_variable value_ready_;
+  ReturnValue value_;
   Resolver resolver_;
   Callback callback_;
   std::mutex provider_mutex_;
   std::shared_ptr<CloudProvider> provider_;
   mutable std::mutex status_mutex_;
   Status status_;
+  std::atomic_bool finished_;
+  std::atomic<IHttpRequest::Priority> priority_;
+  const char* operation_;
+  IMetrics::Key metrics_key_;
+  std::atomic<DeadlineScope::Clock::time_point> deadline_;
   std::recursive_mutex subrequest_mutex_;
   std::vector<std::shared_ptr<IGenericRequest>> subrequests_;
+  std::mutex transfers_mutex_;
+  std::vector<std::weak_ptr<HttpCallback>> transfers_;
 };
 
 }  // namespace cloudstorage
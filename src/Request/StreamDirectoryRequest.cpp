@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * StreamDirectoryRequest.cpp : StreamDirectoryRequest implementation
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "StreamDirectoryRequest.h"
+
+#include "CloudProvider/CloudProvider.h"
+
+namespace cloudstorage {
+
+StreamDirectoryRequest::StreamDirectoryRequest(
+    std::shared_ptr<CloudProvider> p, const IItem::Pointer& directory,
+    const ICallback::Pointer& cb)
+    : PagedListingRequest(std::move(p),
+                          [=](EitherError<uint64_t> e) { cb->done(e); },
+                          [=, callback = cb.get()](Request::Pointer r) {
+                            resolve(r, directory, callback);
+                          }),
+      count_(0) {}
+
+StreamDirectoryRequest::~StreamDirectoryRequest() { cancel(); }
+
+void StreamDirectoryRequest::resolve(const Request::Pointer& request,
+                                     const IItem::Pointer& directory,
+                                     ICallback* callback) {
+  if (directory->type() != IItem::FileType::Directory)
+    request->done(Error{IHttpRequest::Forbidden, util::Error::NOT_A_DIRECTORY});
+  else
+    listPages(directory, "", false,
+              [=](IItem::Pointer item) {
+                count_++;
+                callback->receivedItem(item);
+              },
+              [=](EitherError<void> e) {
+                if (e.left()) return request->done(e.left());
+                request->done(count_);
+              });
+}
+
+}  // namespace cloudstorage
@@ -0,0 +1,51 @@
+/*****************************************************************************
+ * StreamDirectoryRequest.h : StreamDirectoryRequest headers
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef STREAMDIRECTORYREQUEST_H
+#define STREAMDIRECTORYREQUEST_H
+
+#include "IItem.h"
+#include "PagedListingRequest.h"
+
+namespace cloudstorage {
+
+class StreamDirectoryRequest
+    : public PagedListingRequest<EitherError<uint64_t>> {
+ public:
+  using ICallback = IStreamDirectoryCallback;
+
+  StreamDirectoryRequest(std::shared_ptr<CloudProvider>,
+                         const IItem::Pointer& directory,
+                         const ICallback::Pointer&);
+  ~StreamDirectoryRequest() override;
+
+ private:
+  void resolve(const Request::Pointer&, const IItem::Pointer& directory,
+               ICallback* cb);
+
+  uint64_t count_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // STREAMDIRECTORYREQUEST_H
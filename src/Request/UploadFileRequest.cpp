@@ -25,8 +25,6 @@
 
 #include "CloudProvider/CloudProvider.h"
 
-using namespace std::placeholders;
-
 namespace cloudstorage {
 
 UploadFileRequest::UploadFileRequest(
@@ -35,11 +33,17 @@ UploadFileRequest::UploadFileRequest(
     const UploadFileRequest::ICallback::Pointer& cb)
     : Request(
           std::move(p), [=](EitherError<IItem> e) { cb->done(e); },
-          std::bind(&UploadFileRequest::resolve, _1,
+          [=](Request::Pointer r) {
+            resolve(r,
                     std::make_shared<UploadStreamWrapper>(
-                        std::bind(&ICallback::putData, cb.get(), _1, _2, _3),
+                        [callback = cb.get()](char* data, uint32_t length,
+                                              uint64_t offset) {
+                          return callback->putData(data, length, offset);
+                        },
                         cb->size()),
-                    directory, filename, cb)) {}
+                    directory, filename, cb);
+          },
+          IHttpRequest::Priority::Bulk) {}
 
 void UploadFileRequest::resolve(
     const Request::Pointer& r,
@@ -64,8 +68,10 @@ void UploadFileRequest::resolve(
         }
       },
       [=] { return std::make_shared<std::iostream>(stream_wrapper.get()); },
-      std::make_shared<std::stringstream>(), nullptr,
-      std::bind(&UploadFileRequest::ICallback::progress, callback, _1, _2),
+      nullptr, nullptr,
+      [callback](uint64_t total, uint64_t now) {
+        callback->progress(total, now);
+      },
       true);
 }
 
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * WatchChangesRequest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "WatchChangesRequest.h"
+
+#include "CloudProvider/CloudProvider.h"
+
+namespace cloudstorage {
+
+WatchChangesRequest::WatchChangesRequest(std::shared_ptr<CloudProvider> p,
+                                         const std::string& cursor,
+                                         std::chrono::milliseconds interval,
+                                         const Callback& callback)
+    : Request(std::move(p), callback,
+              [=](Request::Pointer) {
+                if (cursor.empty()) return fetch(cursor);
+                poll(cursor, interval);
+              },
+              IHttpRequest::Priority::Bulk) {}
+
+WatchChangesRequest::~WatchChangesRequest() { cancel(); }
+
+void WatchChangesRequest::poll(const std::string& cursor,
+                               std::chrono::milliseconds interval) {
+  auto request = this->shared_from_this();
+  this->send(
+      [=](util::Output input) {
+        auto r = provider()->longPollRequest(cursor, *input);
+        if (r) r->setLongPoll(true);
+        return r;
+      },
+      [=](EitherError<Response> r) {
+        if (r.left()) {
+          if (r.left()->code_ == IHttpRequest::Aborted &&
+              r.left()->description_ == util::Error::UNIMPLEMENTED &&
+              !is_cancelled())
+            return wait(interval, [=] { fetch(cursor); });
+          return request->done(r.left());
+        }
+        auto backoff = std::chrono::milliseconds::zero();
+        bool changed;
+        try {
+          changed = provider()->longPollResponse(r.right()->output(), backoff);
+        } catch (const std::exception& e) {
+          return request->done(Error{IHttpRequest::Failure, e.what()});
+        }
+        if (changed)
+          wait(backoff, [=] { fetch(cursor); });
+        else
+          wait(backoff, [=] { request->done(ChangesData{{}, cursor}); });
+      });
+}
+
+void WatchChangesRequest::fetch(const std::string& cursor) {
+  auto request = this->shared_from_this();
+  make_subrequest(&CloudProvider::changesAsync, cursor,
+                  [=](EitherError<ChangesData> e) { request->done(e); });
+}
+
+void WatchChangesRequest::wait(std::chrono::milliseconds delay,
+                               const GenericCallback<>& f) {
+  if (delay.count() <= 0) return f();
+  auto request = this->shared_from_this();
+  auto when = std::chrono::system_clock::now() + delay;
+  provider()->thread_pool()->schedule(
+      [=] {
+        // Delayed tasks are run early when thread pool is being destroyed.
+        if (is_cancelled() || std::chrono::system_clock::now() < when)
+          return request->done(
+              Error{IHttpRequest::Aborted, util::Error::ABORTED});
+        f();
+      },
+      when);
+}
+
+}  // namespace cloudstorage
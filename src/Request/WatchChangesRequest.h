@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * WatchChangesRequest.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef WATCHCHANGESREQUEST_H
+#define WATCHCHANGESREQUEST_H
+
+#include <chrono>
+
+#include "Request.h"
+
+namespace cloudstorage {
+
+/**
+ * Waits for changes made after the cursor and completes with them. Sends
+ * provider's long poll request if it has one, otherwise waits for the interval
+ * and queries changesAsync; when the long poll times out, completes with no
+ * changes and the same cursor. Empty cursor is exchanged for the one denoting
+ * current state right away.
+ */
+class WatchChangesRequest : public Request<EitherError<ChangesData>> {
+ public:
+  using Callback = ChangesCallback;
+
+  WatchChangesRequest(std::shared_ptr<CloudProvider>, const std::string& cursor,
+                      std::chrono::milliseconds interval,
+                      const Callback& callback);
+  ~WatchChangesRequest() override;
+
+ private:
+  void poll(const std::string& cursor, std::chrono::milliseconds interval);
+  void fetch(const std::string& cursor);
+  void wait(std::chrono::milliseconds delay, const GenericCallback<>& f);
+};
+
+}  // namespace cloudstorage
+
+#endif  // WATCHCHANGESREQUEST_H
@@ -0,0 +1,444 @@
+/*****************************************************************************
+ * CachedCloudProvider.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "CachedCloudProvider.h"
+
+#include <unordered_set>
+
+#include "IHttp.h"
+#include "Request/Request.h"
+#include "Utility/Item.h"
+#include "Utility/Utility.h"
+
+namespace cloudstorage {
+
+namespace {
+
+template <class Result>
+class CachedRequest : public IRequest<Result>, public IFinishable {
+ public:
+  CachedRequest(Result result) : result_(std::move(result)) {}
+
+  void finish() override {}
+  void cancel() override {}
+  Result result() override { return result_; }
+  void pause() override {}
+  void resume() override {}
+  bool is_finished() const override { return true; }
+
+ private:
+  Result result_;
+};
+
+template <class Result, class Callback>
+typename IRequest<Result>::Pointer cached(const Result& result,
+                                          const Callback& callback) {
+  callback(result);
+  return util::make_unique<CachedRequest<Result>>(result);
+}
+
+class CachingListDirectoryCallback : public IListDirectoryCallback {
+ public:
+  CachingListDirectoryCallback(IListDirectoryCallback::Pointer callback,
+                               MetadataCache::Pointer cache,
+                               IItem::Pointer directory)
+      : callback_(std::move(callback)),
+        cache_(std::move(cache)),
+        directory_(std::move(directory)) {}
+
+  void receivedItem(IItem::Pointer item) override {
+    callback_->receivedItem(item);
+  }
+
+  void done(EitherError<IItem::List> e) override {
+    if (e.right()) cache_->put_listing(directory_, *e.right());
+    callback_->done(e);
+  }
+
+ private:
+  IListDirectoryCallback::Pointer callback_;
+  MetadataCache::Pointer cache_;
+  IItem::Pointer directory_;
+};
+
+class CachingUploadFileCallback : public IUploadFileCallback {
+ public:
+  CachingUploadFileCallback(IUploadFileCallback::Pointer callback,
+                            MetadataCache::Pointer cache,
+                            IItem::Pointer parent)
+      : callback_(std::move(callback)),
+        cache_(std::move(cache)),
+        parent_(std::move(parent)) {}
+
+  uint32_t putData(char* data, uint32_t maxlength, uint64_t offset) override {
+    return callback_->putData(data, maxlength, offset);
+  }
+
+  uint64_t size() override { return callback_->size(); }
+
+  void progress(uint64_t total, uint64_t now) override {
+    callback_->progress(total, now);
+  }
+
+  void done(EitherError<IItem> e) override {
+    if (e.right()) {
+      cache_->invalidate_directory(parent_->id());
+      cache_->put_item(e.right());
+    }
+    callback_->done(e);
+  }
+
+ private:
+  IUploadFileCallback::Pointer callback_;
+  MetadataCache::Pointer cache_;
+  IItem::Pointer parent_;
+};
+
+}  // namespace
+
+struct CachedCloudProvider::Revalidations {
+  bool start(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keys_.insert(key).second;
+  }
+
+  void done(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys_.erase(key);
+  }
+
+  void add(std::shared_ptr<IGenericRequest> request) {
+    std::vector<std::shared_ptr<IGenericRequest>> finished;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = requests_.begin();
+    for (auto& r : requests_) {
+      auto f = dynamic_cast<const IFinishable*>(r.get());
+      if (f && f->is_finished()) {
+        finished.push_back(std::move(r));
+      } else {
+        if (&*it != &r) *it = std::move(r);
+        ++it;
+      }
+    }
+    requests_.erase(it, requests_.end());
+    requests_.push_back(std::move(request));
+  }
+
+  std::mutex mutex_;
+  std::unordered_set<std::string> keys_;
+  std::vector<std::shared_ptr<IGenericRequest>> requests_;
+};
+
+CachedCloudProvider::CachedCloudProvider(ICloudProvider::Pointer p,
+                                         MetadataCache::Pointer cache)
+    : p_(std::move(p)),
+      cache_(std::move(cache)),
+      revalidations_(std::make_shared<Revalidations>()) {}
+
+MetadataCache* CachedCloudProvider::cache() const { return cache_.get(); }
+
+std::string CachedCloudProvider::token() const { return p_->token(); }
+
+ICloudProvider::Hints CachedCloudProvider::hints() const {
+  return p_->hints();
+}
+
+std::string CachedCloudProvider::name() const { return p_->name(); }
+
+std::string CachedCloudProvider::endpoint() const { return p_->endpoint(); }
+
+ICloudProvider::OperationSet CachedCloudProvider::supportedOperations() const {
+  return p_->supportedOperations();
+}
+
+std::string CachedCloudProvider::authorizeLibraryUrl() const {
+  return p_->authorizeLibraryUrl();
+}
+
+IItem::Pointer CachedCloudProvider::rootDirectory() const {
+  return p_->rootDirectory();
+}
+
+IThrottle::Pointer CachedCloudProvider::throttle() const {
+  return p_->throttle();
+}
+
+ICloudProvider::ExchangeCodeRequest::Pointer
+CachedCloudProvider::exchangeCodeAsync(const std::string& code,
+                                       ExchangeCodeCallback callback) {
+  return p_->exchangeCodeAsync(code, callback);
+}
+
+ICloudProvider::GetItemUrlRequest::Pointer CachedCloudProvider::getItemUrlAsync(
+    IItem::Pointer item, GetItemUrlCallback callback) {
+  std::string url;
+  if (cache_->url(*item, url)) {
+    static_cast<Item*>(item.get())->set_url(url);
+    return cached(EitherError<std::string>(url), callback);
+  }
+  auto cache = cache_;
+  return p_->getItemUrlAsync(item, [=](EitherError<std::string> e) {
+    if (e.right()) cache->put_url(*item, *e.right());
+    callback(e);
+  });
+}
+
+ICloudProvider::ListDirectoryRequest::Pointer
+CachedCloudProvider::listDirectoryAsync(
+    IItem::Pointer directory, IListDirectoryCallback::Pointer callback) {
+  IItem::List items;
+  if (cache_->listing(*directory, items)) {
+    for (const auto& item : items) callback->receivedItem(item);
+    return cached(EitherError<IItem::List>(items),
+                  [=](EitherError<IItem::List> e) { callback->done(e); });
+  }
+  if (cache_->stored_listing(*directory, items)) {
+    revalidate_listing(directory);
+    for (const auto& item : items) callback->receivedItem(item);
+    return cached(EitherError<IItem::List>(items),
+                  [=](EitherError<IItem::List> e) { callback->done(e); });
+  }
+  return p_->listDirectoryAsync(
+      directory, std::make_shared<CachingListDirectoryCallback>(
+                     callback, cache_, directory));
+}
+
+ICloudProvider::StreamDirectoryRequest::Pointer
+CachedCloudProvider::streamDirectoryAsync(
+    IItem::Pointer directory, IStreamDirectoryCallback::Pointer callback) {
+  return p_->streamDirectoryAsync(directory, callback);
+}
+
+ICloudProvider::GetItemRequest::Pointer CachedCloudProvider::getItemAsync(
+    const std::string& absolute_path, GetItemCallback callback) {
+  if (auto item = cache_->path(absolute_path))
+    return cached(EitherError<IItem>(item), callback);
+  auto cache = cache_;
+  return p_->getItemAsync(absolute_path, [=](EitherError<IItem> e) {
+    if (e.right()) cache->put_path(absolute_path, e.right());
+    callback(e);
+  });
+}
+
+ICloudProvider::DownloadFileRequest::Pointer
+CachedCloudProvider::downloadFileAsync(IItem::Pointer item,
+                                       IDownloadFileCallback::Pointer callback,
+                                       Range range) {
+  return p_->downloadFileAsync(item, callback, range);
+}
+
+ICloudProvider::UploadFileRequest::Pointer CachedCloudProvider::uploadFileAsync(
+    IItem::Pointer parent, const std::string& filename,
+    IUploadFileCallback::Pointer callback) {
+  return p_->uploadFileAsync(parent, filename,
+                             std::make_shared<CachingUploadFileCallback>(
+                                 callback, cache_, parent));
+}
+
+ICloudProvider::GetItemDataRequest::Pointer
+CachedCloudProvider::getItemDataAsync(const std::string& id,
+                                      GetItemDataCallback callback) {
+  if (auto item = cache_->item(id))
+    return cached(EitherError<IItem>(item), callback);
+  if (auto item = cache_->stored_item(id)) {
+    revalidate_item(id, item);
+    return cached(EitherError<IItem>(item), callback);
+  }
+  auto cache = cache_;
+  return p_->getItemDataAsync(id, [=](EitherError<IItem> e) {
+    if (e.right()) cache->put_item(e.right());
+    callback(e);
+  });
+}
+
+ICloudProvider::DownloadFileRequest::Pointer
+CachedCloudProvider::getThumbnailAsync(IItem::Pointer item,
+                                       IDownloadFileCallback::Pointer callback) {
+  return p_->getThumbnailAsync(item, callback);
+}
+
+ICloudProvider::DeleteItemRequest::Pointer CachedCloudProvider::deleteItemAsync(
+    IItem::Pointer item, DeleteItemCallback callback) {
+  auto cache = cache_;
+  return p_->deleteItemAsync(item, [=](EitherError<void> e) {
+    if (!e.left()) cache->remove(*item);
+    callback(e);
+  });
+}
+
+ICloudProvider::CreateDirectoryRequest::Pointer
+CachedCloudProvider::createDirectoryAsync(IItem::Pointer parent,
+                                          const std::string& name,
+                                          CreateDirectoryCallback callback) {
+  auto cache = cache_;
+  return p_->createDirectoryAsync(parent, name, [=](EitherError<IItem> e) {
+    if (e.right()) {
+      cache->invalidate_directory(parent->id());
+      cache->put_item(e.right());
+    }
+    callback(e);
+  });
+}
+
+ICloudProvider::MoveItemRequest::Pointer CachedCloudProvider::moveItemAsync(
+    IItem::Pointer source, IItem::Pointer destination,
+    MoveItemCallback callback) {
+  auto cache = cache_;
+  return p_->moveItemAsync(source, destination, [=](EitherError<IItem> e) {
+    if (e.right()) {
+      cache->remove(*source);
+      cache->invalidate_directory(destination->id());
+      cache->put_item(e.right());
+    }
+    callback(e);
+  });
+}
+
+ICloudProvider::RenameItemRequest::Pointer CachedCloudProvider::renameItemAsync(
+    IItem::Pointer item, const std::string& name, RenameItemCallback callback) {
+  auto cache = cache_;
+  return p_->renameItemAsync(item, name, [=](EitherError<IItem> e) {
+    if (e.right()) {
+      cache->remove(*item);
+      cache->put_item(e.right());
+    }
+    callback(e);
+  });
+}
+
+ICloudProvider::ListDirectoryPageRequest::Pointer
+CachedCloudProvider::listDirectoryPageAsync(
+    IItem::Pointer directory, const std::string& token,
+    ListDirectoryPageCallback callback) {
+  PageData page;
+  if (cache_->page(*directory, token, page))
+    return cached(EitherError<PageData>(page), callback);
+  auto cache = cache_;
+  return p_->listDirectoryPageAsync(
+      directory, token, [=](EitherError<PageData> e) {
+        if (e.right()) cache->put_page(*directory, token, *e.right());
+        callback(e);
+      });
+}
+
+ICloudProvider::ListDirectoryRequest::Pointer
+CachedCloudProvider::listDirectorySimpleAsync(IItem::Pointer directory,
+                                              ListDirectoryCallback callback) {
+  IItem::List items;
+  if (cache_->listing(*directory, items))
+    return cached(EitherError<IItem::List>(items), callback);
+  if (cache_->stored_listing(*directory, items)) {
+    revalidate_listing(directory);
+    return cached(EitherError<IItem::List>(items), callback);
+  }
+  auto cache = cache_;
+  return p_->listDirectorySimpleAsync(
+      directory, [=](EitherError<IItem::List> e) {
+        if (e.right()) cache->put_listing(directory, *e.right());
+        callback(e);
+      });
+}
+
+ICloudProvider::DownloadFileRequest::Pointer
+CachedCloudProvider::downloadFileAsync(IItem::Pointer item,
+                                       const std::string& filename,
+                                       DownloadFileCallback callback) {
+  return p_->downloadFileAsync(item, filename, callback);
+}
+
+ICloudProvider::DownloadFileRequest::Pointer
+CachedCloudProvider::getThumbnailAsync(IItem::Pointer item,
+                                       const std::string& filename,
+                                       GetThumbnailCallback callback) {
+  return p_->getThumbnailAsync(item, filename, callback);
+}
+
+ICloudProvider::UploadFileRequest::Pointer CachedCloudProvider::uploadFileAsync(
+    IItem::Pointer parent, const std::string& path, const std::string& filename,
+    UploadFileCallback callback) {
+  auto cache = cache_;
+  return p_->uploadFileAsync(
+      parent, path, filename, [=](EitherError<IItem> e) {
+        if (e.right()) {
+          cache->invalidate_directory(parent->id());
+          cache->put_item(e.right());
+        }
+        callback(e);
+      });
+}
+
+ICloudProvider::GeneralDataRequest::Pointer
+CachedCloudProvider::getGeneralDataAsync(GeneralDataCallback callback) {
+  return p_->getGeneralDataAsync(callback);
+}
+
+ICloudProvider::GetItemUrlRequest::Pointer
+CachedCloudProvider::getFileDaemonUrlAsync(IItem::Pointer item,
+                                           GetItemUrlCallback callback) {
+  return p_->getFileDaemonUrlAsync(item, callback);
+}
+
+ICloudProvider::ChangesRequest::Pointer CachedCloudProvider::changesAsync(
+    const std::string& cursor, ChangesCallback callback) {
+  return p_->changesAsync(cursor, callback);
+}
+
+void CachedCloudProvider::subscribeChanges(IChangesListener::Pointer listener) {
+  p_->subscribeChanges(std::move(listener));
+}
+
+void CachedCloudProvider::unsubscribeChanges(
+    const IChangesListener::Pointer& listener) {
+  p_->unsubscribeChanges(listener);
+}
+
+void CachedCloudProvider::revalidate_item(const std::string& id,
+                                          IItem::Pointer stored) {
+  auto key = "i" + id;
+  if (!revalidations_->start(key)) return;
+  auto cache = cache_;
+  std::weak_ptr<Revalidations> revalidations = revalidations_;
+  revalidations_->add(p_->getItemDataAsync(id, [=](EitherError<IItem> e) {
+    if (e.right())
+      cache->put_item(e.right());
+    else if (e.left() && e.left()->code_ == IHttpRequest::NotFound)
+      cache->remove(*stored);
+    if (auto r = revalidations.lock()) r->done(key);
+  }));
+}
+
+void CachedCloudProvider::revalidate_listing(IItem::Pointer directory) {
+  auto key = "l" + directory->id();
+  if (!revalidations_->start(key)) return;
+  auto cache = cache_;
+  std::weak_ptr<Revalidations> revalidations = revalidations_;
+  revalidations_->add(p_->listDirectorySimpleAsync(
+      directory, [=](EitherError<IItem::List> e) {
+        if (e.right())
+          cache->put_listing(directory, *e.right());
+        else if (e.left() && e.left()->code_ == IHttpRequest::NotFound)
+          cache->remove(*directory);
+        if (auto r = revalidations.lock()) r->done(key);
+      }));
+}
+
+}  // namespace cloudstorage
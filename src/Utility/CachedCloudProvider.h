@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * CachedCloudProvider.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef CACHEDCLOUDPROVIDER_H
+#define CACHEDCLOUDPROVIDER_H
+
+#include "ICloudProvider.h"
+#include "Utility/MetadataCache.h"
+
+namespace cloudstorage {
+
+/**
+ * Answers getItemData, listDirectoryPage, listDirectory, getItemUrl and
+ * getItem from the cache when it can, calling the callback before returning
+ * the request; otherwise forwards to the wrapped provider and caches the
+ * result. Successful mutations drop the cached listings of affected
+ * directories and cache the items they return.
+ *
+ * Items and listings missing from memory, but kept in the cache's store, are
+ * answered from the store right away and fetched again in the background.
+ */
+class CachedCloudProvider : public ICloudProvider {
+ public:
+  CachedCloudProvider(ICloudProvider::Pointer, MetadataCache::Pointer);
+
+  MetadataCache* cache() const;
+
+  std::string token() const override;
+  Hints hints() const override;
+  std::string name() const override;
+  std::string endpoint() const override;
+  OperationSet supportedOperations() const override;
+  std::string authorizeLibraryUrl() const override;
+  IItem::Pointer rootDirectory() const override;
+  IThrottle::Pointer throttle() const override;
+
+  ExchangeCodeRequest::Pointer exchangeCodeAsync(const std::string&,
+                                                 ExchangeCodeCallback) override;
+  GetItemUrlRequest::Pointer getItemUrlAsync(IItem::Pointer,
+                                             GetItemUrlCallback) override;
+  ListDirectoryRequest::Pointer listDirectoryAsync(
+      IItem::Pointer, IListDirectoryCallback::Pointer) override;
+  StreamDirectoryRequest::Pointer streamDirectoryAsync(
+      IItem::Pointer, IStreamDirectoryCallback::Pointer) override;
+  GetItemRequest::Pointer getItemAsync(const std::string& absolute_path,
+                                       GetItemCallback) override;
+  DownloadFileRequest::Pointer downloadFileAsync(IItem::Pointer,
+                                                 IDownloadFileCallback::Pointer,
+                                                 Range) override;
+  UploadFileRequest::Pointer uploadFileAsync(
+      IItem::Pointer, const std::string&,
+      IUploadFileCallback::Pointer) override;
+  GetItemDataRequest::Pointer getItemDataAsync(const std::string& id,
+                                               GetItemDataCallback) override;
+  DownloadFileRequest::Pointer getThumbnailAsync(
+      IItem::Pointer, IDownloadFileCallback::Pointer) override;
+  DeleteItemRequest::Pointer deleteItemAsync(IItem::Pointer,
+                                             DeleteItemCallback) override;
+  CreateDirectoryRequest::Pointer createDirectoryAsync(
+      IItem::Pointer parent, const std::string& name,
+      CreateDirectoryCallback) override;
+  MoveItemRequest::Pointer moveItemAsync(IItem::Pointer source,
+                                         IItem::Pointer destination,
+                                         MoveItemCallback) override;
+  RenameItemRequest::Pointer renameItemAsync(IItem::Pointer item,
+                                             const std::string&,
+                                             RenameItemCallback) override;
+  ListDirectoryPageRequest::Pointer listDirectoryPageAsync(
+      IItem::Pointer, const std::string&, ListDirectoryPageCallback) override;
+  ListDirectoryRequest::Pointer listDirectorySimpleAsync(
+      IItem::Pointer item, ListDirectoryCallback callback) override;
+  DownloadFileRequest::Pointer downloadFileAsync(IItem::Pointer item,
+                                                 const std::string& filename,
+                                                 DownloadFileCallback) override;
+  DownloadFileRequest::Pointer getThumbnailAsync(IItem::Pointer item,
+                                                 const std::string& filename,
+                                                 GetThumbnailCallback) override;
+  UploadFileRequest::Pointer uploadFileAsync(IItem::Pointer parent,
+                                             const std::string& path,
+                                             const std::string& filename,
+                                             UploadFileCallback) override;
+  GeneralDataRequest::Pointer getGeneralDataAsync(GeneralDataCallback) override;
+  GetItemUrlRequest::Pointer getFileDaemonUrlAsync(IItem::Pointer,
+                                                   GetItemUrlCallback) override;
+  ChangesRequest::Pointer changesAsync(const std::string& cursor,
+                                       ChangesCallback) override;
+  void subscribeChanges(IChangesListener::Pointer) override;
+  void unsubscribeChanges(const IChangesListener::Pointer&) override;
+
+ private:
+  struct Revalidations;
+
+  void revalidate_item(const std::string& id, IItem::Pointer stored);
+  void revalidate_listing(IItem::Pointer directory);
+
+  ICloudProvider::Pointer p_;
+  MetadataCache::Pointer cache_;
+  std::shared_ptr<Revalidations> revalidations_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // CACHEDCLOUDPROVIDER_H
@@ -0,0 +1,138 @@
+/*****************************************************************************
+ * ChangesNotifier.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ChangesNotifier.h"
+
+#include <algorithm>
+
+#include "CloudProvider/CloudProvider.h"
+#include "Request/WatchChangesRequest.h"
+
+namespace cloudstorage {
+
+namespace {
+
+// Deadline of a single watch, instead of provider's request_timeout; it has to
+// outlast provider's long poll.
+const std::chrono::minutes WATCH_TIMEOUT(5);
+
+}  // namespace
+
+ChangesNotifier::ChangesNotifier(std::weak_ptr<CloudProvider> provider,
+                                 std::chrono::milliseconds interval)
+    : provider_(std::move(provider)),
+      interval_(interval),
+      generation_(),
+      watches_(),
+      failed_() {}
+
+void ChangesNotifier::subscribe(Listener::Pointer listener) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  listeners_.push_back(std::move(listener));
+  if (listeners_.size() > 1) return;
+  auto generation = ++generation_;
+  failed_ = false;
+  lock.unlock();
+  watch(generation, "");
+}
+
+void ChangesNotifier::unsubscribe(const Listener::Pointer& listener) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = std::find(listeners_.begin(), listeners_.end(), listener);
+  if (it == listeners_.end()) return;
+  listeners_.erase(it);
+  if (!listeners_.empty()) return;
+  generation_++;
+  auto request = std::move(request_);
+  lock.unlock();
+}
+
+void ChangesNotifier::clear() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto listeners = std::move(listeners_);
+  listeners_.clear();
+  generation_++;
+  auto request = std::move(request_);
+  lock.unlock();
+}
+
+void ChangesNotifier::watch(uint64_t generation, const std::string& cursor) {
+  auto provider = provider_.lock();
+  if (!provider) return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (generation != generation_) return;
+  auto id = ++watches_;
+  lock.unlock();
+  std::weak_ptr<ChangesNotifier> notifier = shared_from_this();
+  OperationScope operation("watch_changes");
+  DeadlineScope deadline(WATCH_TIMEOUT);
+  auto request =
+      std::make_shared<WatchChangesRequest>(
+          provider, cursor, interval_,
+          [=](EitherError<ChangesData> e) {
+            auto n = notifier.lock();
+            if (!n) return;
+            if (e.left()) return n->retry(generation, cursor, *e.left());
+            n->notify(generation, e.right()->changes_);
+            n->watch(generation, e.right()->cursor_);
+          })
+          ->run();
+  lock.lock();
+  // A watch started from the callback, if it completed right away, is newer.
+  if (generation == generation_ && id == watches_) std::swap(request, request_);
+  lock.unlock();
+}
+
+void ChangesNotifier::retry(uint64_t generation, const std::string& cursor,
+                            const Error& e) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (generation != generation_) return;
+  auto listeners = failed_ ? std::vector<Listener::Pointer>() : listeners_;
+  failed_ = true;
+  lock.unlock();
+  for (const auto& listener : listeners) listener->failed(e);
+  auto provider = provider_.lock();
+  if (!provider) return;
+  std::weak_ptr<ChangesNotifier> notifier = shared_from_this();
+  auto when = std::chrono::system_clock::now() + interval_;
+  provider->thread_pool()->schedule(
+      [=] {
+        auto n = notifier.lock();
+        // Delayed tasks are run early when thread pool is being destroyed.
+        if (!n || std::chrono::system_clock::now() < when) return;
+        n->watch(generation, cursor);
+      },
+      when);
+}
+
+void ChangesNotifier::notify(uint64_t generation,
+                             const std::vector<Change>& changes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (generation != generation_ || (changes.empty() && !failed_)) return;
+  failed_ = false;
+  auto listeners = listeners_;
+  lock.unlock();
+  for (const auto& listener : listeners) listener->changed(changes);
+}
+
+}  // namespace cloudstorage
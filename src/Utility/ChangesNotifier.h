@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * ChangesNotifier.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CHANGESNOTIFIER_H
+#define CHANGESNOTIFIER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ICloudProvider.h"
+
+namespace cloudstorage {
+
+class CloudProvider;
+
+/**
+ * Follows provider's changes while there are listeners and passes them on.
+ * Changes are awaited with WatchChangesRequest one after another; failed
+ * requests are retried after the interval, starting from the last cursor.
+ */
+class ChangesNotifier : public std::enable_shared_from_this<ChangesNotifier> {
+ public:
+  using Pointer = std::shared_ptr<ChangesNotifier>;
+  using Listener = ICloudProvider::IChangesListener;
+
+  ChangesNotifier(std::weak_ptr<CloudProvider>,
+                  std::chrono::milliseconds interval);
+
+  void subscribe(Listener::Pointer);
+  void unsubscribe(const Listener::Pointer&);
+
+  /**
+   * Drops all listeners and cancels pending request.
+   */
+  void clear();
+
+ private:
+  void watch(uint64_t generation, const std::string& cursor);
+  void retry(uint64_t generation, const std::string& cursor, const Error&);
+  void notify(uint64_t generation, const std::vector<Change>&);
+
+  std::weak_ptr<CloudProvider> provider_;
+  std::chrono::milliseconds interval_;
+  std::mutex mutex_;
+  std::vector<Listener::Pointer> listeners_;
+  ICloudProvider::ChangesRequest::Pointer request_;
+  uint64_t generation_;
+  uint64_t watches_;
+  bool failed_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // CHANGESNOTIFIER_H
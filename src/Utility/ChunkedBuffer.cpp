@@ -0,0 +1,242 @@
+/*****************************************************************************
+ * ChunkedBuffer.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ChunkedBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+
+namespace cloudstorage {
+namespace util {
+
+namespace {
+
+const size_t MAX_POOLED_BLOCKS = 256;
+
+class BlockPool {
+ public:
+  char* acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (blocks_.empty()) return new char[ChunkedBuffer::BlockSize];
+    auto block = blocks_.back();
+    blocks_.pop_back();
+    return block;
+  }
+
+  void release(char* block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (blocks_.size() < MAX_POOLED_BLOCKS)
+      blocks_.push_back(block);
+    else
+      delete[] block;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<char*> blocks_;
+};
+
+BlockPool& pool() {
+  // Never destroyed, buffers may outlive static objects.
+  static auto pool = new BlockPool;
+  return *pool;
+}
+
+}  // namespace
+
+constexpr size_t ChunkedBuffer::BlockSize;
+
+ChunkedBuffer::ChunkedBuffer() : read_block_() {}
+
+ChunkedBuffer::~ChunkedBuffer() { release(); }
+
+size_t ChunkedBuffer::size() const {
+  size_t result = 0;
+  for (size_t i = 0; i < blocks_.size(); i++) result += filled(i);
+  return result;
+}
+
+std::vector<ChunkedBuffer::Segment> ChunkedBuffer::segments() const {
+  std::vector<Segment> result;
+  for (size_t i = 0; i < blocks_.size(); i++)
+    if (filled(i) > 0) result.push_back({blocks_[i].data_, filled(i)});
+  return result;
+}
+
+ChunkedBuffer::Segment ChunkedBuffer::contiguous() {
+  auto read = position();
+  auto total = size();
+  if (read == total) return {nullptr, 0};
+  if (read_block_ + 1 < blocks_.size() &&
+      read + filled(blocks_.size() - 1) != total) {
+    auto data = new char[total];
+    size_t offset = 0;
+    for (size_t i = 0; i < blocks_.size(); i++) {
+      memcpy(data + offset, blocks_[i].data_, filled(i));
+      offset += filled(i);
+    }
+    release();
+    blocks_ = {{data, total}};
+    setp(data + total, data + total);
+    read_block_ = 0;
+    setg(data, data + read, data + total);
+  } else if (read_block_ + 1 < blocks_.size()) {
+    // Everything what's left is in the last block.
+    read_block_ = blocks_.size() - 1;
+    setg(blocks_[read_block_].data_, blocks_[read_block_].data_,
+         blocks_[read_block_].data_ + filled(read_block_));
+  } else {
+    auto data = blocks_[read_block_].data_;
+    auto offset = eback() ? gptr() - eback() : 0;
+    setg(data, data + offset, data + filled(read_block_));
+  }
+  return {gptr(), static_cast<size_t>(egptr() - gptr())};
+}
+
+std::string ChunkedBuffer::str() const {
+  std::string result;
+  result.reserve(size());
+  for (auto&& segment : segments()) result.append(segment.data_, segment.size_);
+  return result;
+}
+
+ChunkedBuffer::int_type ChunkedBuffer::overflow(int_type c) {
+  if (traits_type::eq_int_type(c, traits_type::eof()))
+    return traits_type::not_eof(c);
+  if (pptr() == epptr()) append();
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+std::streamsize ChunkedBuffer::xsputn(const char* data, std::streamsize size) {
+  std::streamsize written = 0;
+  while (written < size) {
+    if (pptr() == epptr()) append();
+    auto count = std::min<std::streamsize>(size - written, epptr() - pptr());
+    memcpy(pptr(), data + written, count);
+    pbump(static_cast<int>(count));
+    written += count;
+  }
+  return written;
+}
+
+ChunkedBuffer::int_type ChunkedBuffer::underflow() {
+  if (blocks_.empty()) return traits_type::eof();
+  if (!eback()) setg(blocks_[0].data_, blocks_[0].data_, blocks_[0].data_);
+  while (true) {
+    auto end = blocks_[read_block_].data_ + filled(read_block_);
+    if (gptr() < end) {
+      setg(eback(), gptr(), end);
+      return traits_type::to_int_type(*gptr());
+    }
+    if (read_block_ + 1 == blocks_.size()) return traits_type::eof();
+    read_block_++;
+    auto data = blocks_[read_block_].data_;
+    setg(data, data, data);
+  }
+}
+
+ChunkedBuffer::pos_type ChunkedBuffer::seekoff(off_type offset,
+                                               std::ios_base::seekdir dir,
+                                               std::ios_base::openmode mode) {
+  if (!(mode & std::ios_base::in)) {
+    if (offset == 0 && dir != std::ios_base::beg)
+      return static_cast<off_type>(size());
+    return pos_type(off_type(-1));
+  }
+  off_type base = 0;
+  if (dir == std::ios_base::cur)
+    base = static_cast<off_type>(position());
+  else if (dir == std::ios_base::end)
+    base = static_cast<off_type>(size());
+  return seekpos(base + offset, mode);
+}
+
+ChunkedBuffer::pos_type ChunkedBuffer::seekpos(pos_type position,
+                                               std::ios_base::openmode mode) {
+  off_type target = position;
+  if (!(mode & std::ios_base::in) || target < 0 ||
+      static_cast<size_t>(target) > size())
+    return pos_type(off_type(-1));
+  if (blocks_.empty()) return position;
+  size_t offset = 0;
+  read_block_ = 0;
+  while (read_block_ + 1 < blocks_.size() &&
+         offset + filled(read_block_) <= static_cast<size_t>(target)) {
+    offset += filled(read_block_);
+    read_block_++;
+  }
+  auto data = blocks_[read_block_].data_;
+  setg(data, data + (target - offset), data + filled(read_block_));
+  return position;
+}
+
+size_t ChunkedBuffer::filled(size_t block) const {
+  if (block + 1 < blocks_.size()) return blocks_[block].capacity_;
+  return pptr() - blocks_[block].data_;
+}
+
+size_t ChunkedBuffer::position() const {
+  if (!eback()) return 0;
+  size_t result = 0;
+  for (size_t i = 0; i < read_block_; i++) result += filled(i);
+  return result + (gptr() - eback());
+}
+
+void ChunkedBuffer::release() {
+  for (auto&& block : blocks_)
+    if (block.capacity_ == BlockSize)
+      pool().release(block.data_);
+    else
+      delete[] block.data_;
+  blocks_.clear();
+}
+
+void ChunkedBuffer::append() {
+  auto data = pool().acquire();
+  blocks_.push_back({data, BlockSize});
+  setp(data, data + BlockSize);
+}
+
+ChunkedStream::ChunkedStream() : std::iostream(nullptr) { init(&buffer_); }
+
+ChunkedBuffer* ChunkedStream::rdbuf() { return &buffer_; }
+
+std::string ChunkedStream::str() const { return buffer_.str(); }
+
+ChunkedBuffer::Segment contents(std::istream& stream, std::string& storage) {
+  if (auto buffer = dynamic_cast<ChunkedBuffer*>(stream.rdbuf())) {
+    auto result = buffer->contiguous();
+    stream.seekg(0, std::ios_base::end);
+    return result;
+  }
+  storage.assign(std::istreambuf_iterator<char>(stream),
+                 std::istreambuf_iterator<char>());
+  return {storage.data(), storage.size()};
+}
+
+}  // namespace util
+}  // namespace cloudstorage
@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * ChunkedBuffer.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef CHUNKEDBUFFER_H
+#define CHUNKEDBUFFER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace cloudstorage {
+namespace util {
+
+/**
+ * Stream buffer which keeps data in fixed-size blocks taken from a shared
+ * pool, so that growing it never moves data which was already written. Http
+ * responses are written into it and parsers read the blocks in place.
+ */
+class ChunkedBuffer : public std::streambuf {
+ public:
+  static constexpr size_t BlockSize = 16 * 1024;
+
+  struct Segment {
+    const char* data_;
+    size_t size_;
+  };
+
+  ChunkedBuffer();
+  ~ChunkedBuffer() override;
+
+  ChunkedBuffer(const ChunkedBuffer&) = delete;
+  ChunkedBuffer& operator=(const ChunkedBuffer&) = delete;
+
+  /**
+   * @return count of bytes written
+   */
+  size_t size() const;
+
+  /**
+   * @return written data, block by block
+   */
+  std::vector<Segment> segments() const;
+
+  /**
+   * Blocks are merged into one if the data which wasn't read yet spans more
+   * than one of them.
+   *
+   * @return data which wasn't read yet, as contiguous memory
+   */
+  Segment contiguous();
+
+  std::string str() const;
+
+ protected:
+  int_type overflow(int_type) override;
+  std::streamsize xsputn(const char*, std::streamsize) override;
+  int_type underflow() override;
+  pos_type seekoff(off_type, std::ios_base::seekdir,
+                   std::ios_base::openmode) override;
+  pos_type seekpos(pos_type, std::ios_base::openmode) override;
+
+ private:
+  struct Block {
+    char* data_;
+    size_t capacity_;
+  };
+
+  size_t filled(size_t block) const;
+  size_t position() const;
+  void append();
+  void release();
+
+  std::vector<Block> blocks_;
+  size_t read_block_;
+};
+
+/**
+ * Stream writing into ChunkedBuffer.
+ */
+class ChunkedStream : public std::iostream {
+ public:
+  ChunkedStream();
+
+  ChunkedBuffer* rdbuf();
+  std::string str() const;
+
+ private:
+  ChunkedBuffer buffer_;
+};
+
+/**
+ * Gives data which wasn't read from the stream yet as contiguous memory and
+ * marks it as read. Streams backed by ChunkedBuffer are read in place, others
+ * are read into storage.
+ */
+ChunkedBuffer::Segment contents(std::istream& stream, std::string& storage);
+
+}  // namespace util
+}  // namespace cloudstorage
+
+#endif  // CHUNKEDBUFFER_H
@@ -96,6 +96,24 @@ struct DownloadCallback : public IDownloadFileCallback {
   std::shared_ptr<priv::LoopImpl> loop_;
 };
 
+struct ChangesListener : public ICloudProvider::IChangesListener {
+  ChangesListener(ICloudProvider::IChangesListener::Pointer listener,
+                  std::shared_ptr<priv::LoopImpl> loop)
+      : listener_(std::move(listener)), loop_(std::move(loop)) {}
+
+  void changed(const std::vector<Change>& changes) override {
+    loop_->invoke(
+        [listener = listener_, changes] { listener->changed(changes); });
+  }
+
+  void failed(const Error& e) override {
+    loop_->invoke([listener = listener_, e] { listener->failed(e); });
+  }
+
+  ICloudProvider::IChangesListener::Pointer listener_;
+  std::shared_ptr<priv::LoopImpl> loop_;
+};
+
 struct Uploader : public ICloudUploadCallback {
   Uploader(std::shared_ptr<std::istream> stream,
            ICloudAccess::ProgressCallback progress)
@@ -156,6 +174,11 @@ CloudAccess::CloudAccess(std::shared_ptr<priv::LoopImpl> loop,
                          ICloudProvider::Pointer&& provider)
     : loop_(std::move(loop)), provider_(std::move(provider)) {}
 
+CloudAccess::~CloudAccess() {
+  for (const auto& listener : changes_listeners_)
+    provider_->unsubscribeChanges(listener.second);
+}
+
 Promise<GeneralData> CloudAccess::generalData() {
   return wrap(&ICloudProvider::getGeneralDataAsync);
 }
@@ -322,6 +345,29 @@ Promise<> CloudAccess::generateThumbnail(
   return result;
 }
 
+void CloudAccess::subscribeChanges(
+    ICloudProvider::IChangesListener::Pointer listener) {
+  auto wrapper = std::make_shared<ChangesListener>(listener, loop_);
+  {
+    std::lock_guard<std::mutex> lock(changes_mutex_);
+    if (!changes_listeners_.emplace(listener.get(), wrapper).second) return;
+  }
+  provider_->subscribeChanges(wrapper);
+}
+
+void CloudAccess::unsubscribeChanges(
+    const ICloudProvider::IChangesListener::Pointer& listener) {
+  ICloudProvider::IChangesListener::Pointer wrapper;
+  {
+    std::lock_guard<std::mutex> lock(changes_mutex_);
+    auto it = changes_listeners_.find(listener.get());
+    if (it == changes_listeners_.end()) return;
+    wrapper = std::move(it->second);
+    changes_listeners_.erase(it);
+  }
+  provider_->unsubscribeChanges(wrapper);
+}
+
 std::string CloudAccess::name() const { return provider_->name(); }
 
 IItem::Pointer CloudAccess::root() const { return provider_->rootDirectory(); }
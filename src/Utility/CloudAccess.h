@@ -23,6 +23,9 @@
 #ifndef CLOUDACCESS_H
 #define CLOUDACCESS_H
 
+#include <mutex>
+#include <unordered_map>
+
 #include "CloudEventLoop.h"
 #include "ICloudAccess.h"
 #include "ICloudProvider.h"
@@ -86,6 +89,7 @@ class CloudAccess : public ICloudAccess {
 
   CloudAccess(std::shared_ptr<priv::LoopImpl> loop,
               ICloudProvider::Pointer&& provider);
+  ~CloudAccess() override;
 
   ICloudProvider* provider() const { return provider_.get(); }
   std::string name() const override;
@@ -120,6 +124,9 @@ class CloudAccess : public ICloudAccess {
   Promise<> generateThumbnail(
       IItem::Pointer file,
       const std::shared_ptr<ICloudDownloadCallback>&) override;
+  void subscribeChanges(ICloudProvider::IChangesListener::Pointer) override;
+  void unsubscribeChanges(
+      const ICloudProvider::IChangesListener::Pointer&) override;
 
  private:
   template <
@@ -144,6 +151,10 @@ class CloudAccess : public ICloudAccess {
 
   std::shared_ptr<priv::LoopImpl> loop_;
   std::shared_ptr<ICloudProvider> provider_;
+  std::mutex changes_mutex_;
+  std::unordered_map<ICloudProvider::IChangesListener*,
+                     ICloudProvider::IChangesListener::Pointer>
+      changes_listeners_;
 };
 
 }  // namespace cloudstorage
@@ -45,11 +45,12 @@ void CloudEventLoop::processEvents() { impl_->process_events(); }
 namespace priv {
 
 LoopImpl::LoopImpl(IThreadPoolFactory *factory, CloudEventLoop *loop)
-    : cancellation_thread_pool_(factory->create(1)),
-      interrupt_(std::make_shared<std::atomic_bool>(false)),
+    : interrupt_(std::make_shared<std::atomic_bool>(false)),
       event_loop_(loop) {
 #ifdef WITH_THUMBNAILER
   thumbnailer_thread_pool_ = factory->create(2);
+#else
+  (void)factory;
 #endif
 }
 
@@ -86,14 +87,8 @@ void LoopImpl::cancel(uintptr_t tag) {
   if (it != pending_.end()) {
     auto request = std::move(it->second);
     pending_.erase(it);
-    if (cancellation_thread_pool_) {
-      lock.unlock();
-      cancellation_thread_pool_->schedule(
-          [request = std::move(request)] { request->cancel(); });
-    } else {
-      lock.unlock();
-      request->cancel();
-    }
+    lock.unlock();
+    request->cancel();
   }
 }
 
@@ -135,7 +130,6 @@ void LoopImpl::clear() {
     thumbnailer_thread_pool_ = nullptr;
   }
 #endif
-  cancellation_thread_pool_ = nullptr;
   {
     std::unique_lock<std::mutex> lock(mutex_);
     while (!pending_.empty()) {
@@ -145,6 +139,7 @@ void LoopImpl::clear() {
       if (request) {
         lock.unlock();
         request->cancel();
+        request->finish();
         lock.lock();
       }
       lock.unlock();
@@ -77,7 +77,6 @@ class LoopImpl {
   std::mutex thumbnailer_mutex_;
   IThreadPool::Pointer thumbnailer_thread_pool_;
 #endif
-  IThreadPool::Pointer cancellation_thread_pool_;
   std::shared_ptr<std::atomic_bool> interrupt_;
   CloudEventLoop* event_loop_;
 };
@@ -217,12 +217,14 @@ CloudFactory::CloudFactory(CloudFactory::InitData&& d)
     : callback_(std::make_shared<FactoryCallbackWrapper>(this, d.callback_)),
       event_loop_(d.thread_pool_factory_.get(), callback_),
       base_url_(d.base_url_),
-      http_(std::move(d.http_)),
+      http_(d.http_ ? std::move(d.http_)
+                    : IHttp::create(d.http_options_)),
       http_server_factory_(util::make_unique<ServerWrapperFactory>(
           d.http_server_factory_.get())),
       crypto_(std::move(d.crypto_)),
       thread_pool_(d.thread_pool_factory_->create(1)),
       thread_pool_factory_(std::move(d.thread_pool_factory_)),
+      throttle_(IThrottle::create()),
       cloud_storage_(ICloudStorage::create()),
       loop_(event_loop_.impl()) {
   for (const auto& d : cloud_storage_->providers()) {
@@ -287,6 +289,7 @@ std::unique_ptr<CloudAccess> CloudFactory::createImpl(
   init_data.thread_pool_ =
       thread_pool_ ? util::make_unique<ThreadPoolWrapper>(thread_pool_)
                    : nullptr;
+  init_data.throttle_ = throttle_;
   init_data.callback_ =
       util::make_unique<AuthCallback>(const_cast<CloudFactory*>(this));
   auto auth_callback = static_cast<AuthCallback*>(init_data.callback_.get());
@@ -320,6 +323,8 @@ void CloudFactory::onEventsAdded() {
   empty_condition_.notify_one();
 }
 
+IThrottle::Pointer CloudFactory::throttle() const { return throttle_; }
+
 void CloudFactory::add(std::unique_ptr<IGenericRequest>&& request) {
   auto tag = reinterpret_cast<uintptr_t>(request.get());
   loop_->add(tag, std::move(request));
@@ -77,6 +77,8 @@ class CloudFactory : public ICloudFactory {
   int exec() override;
   void quit() override;
 
+  IThrottle::Pointer throttle() const override;
+
   std::vector<std::shared_ptr<ICloudAccess>> providers() const override;
   Promise<Token> exchangeAuthorizationCode(const std::string& provider,
                                            const ProviderInitData&,
@@ -96,6 +98,7 @@ class CloudFactory : public ICloudFactory {
   std::shared_ptr<ICrypto> crypto_;
   std::shared_ptr<IThreadPool> thread_pool_;
   std::unique_ptr<IThreadPoolFactory> thread_pool_factory_;
+  IThrottle::Pointer throttle_;
   ICloudStorage::Pointer cloud_storage_;
   std::vector<IHttpServer::Pointer> http_server_handles_;
   std::unordered_set<std::shared_ptr<CloudAccess>> cloud_access_;
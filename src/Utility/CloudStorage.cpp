@@ -40,6 +40,7 @@
 #include "CloudProvider/YandexDisk.h"
 #include "CloudProvider/YouTube.h"
 
+#include "Utility/CachedCloudProvider.h"
 #include "Utility/Utility.h"
 
 namespace cloudstorage {
@@ -70,18 +71,29 @@ class CloudProviderWrapper : public ICloudProvider {
 
   IItem::Pointer rootDirectory() const override { return p_->rootDirectory(); }
 
+  IThrottle::Pointer throttle() const override { return p_->throttle(); }
+
   ExchangeCodeRequest::Pointer exchangeCodeAsync(
       const std::string& code, ExchangeCodeCallback cb) override {
+    OperationScope scope("exchangeCode");
     return p_->exchangeCodeAsync(code, cb);
   }
 
   ListDirectoryRequest::Pointer listDirectoryAsync(
       IItem::Pointer directory, IListDirectoryCallback::Pointer cb) override {
+    OperationScope scope("listDirectory");
     return p_->listDirectoryAsync(directory, cb);
   }
 
+  StreamDirectoryRequest::Pointer streamDirectoryAsync(
+      IItem::Pointer directory, IStreamDirectoryCallback::Pointer cb) override {
+    OperationScope scope("streamDirectory");
+    return p_->streamDirectoryAsync(directory, cb);
+  }
+
   GetItemUrlRequest::Pointer getItemUrlAsync(IItem::Pointer item,
                                              GetItemUrlCallback cb) override {
+    OperationScope scope("getItemUrl");
     return p_->getItemUrlAsync(item, [=](EitherError<std::string> e) {
       if (e.left())
         cb(e.left());
@@ -94,93 +106,124 @@ class CloudProviderWrapper : public ICloudProvider {
 
   GetItemRequest::Pointer getItemAsync(const std::string& absolute_path,
                                        GetItemCallback callback) override {
+    OperationScope scope("getItem");
     return p_->getItemAsync(absolute_path, callback);
   }
 
   DownloadFileRequest::Pointer downloadFileAsync(
       IItem::Pointer item, IDownloadFileCallback::Pointer cb,
       Range range) override {
+    OperationScope scope("downloadFile");
     return p_->downloadFileAsync(item, cb, range);
   }
 
   UploadFileRequest::Pointer uploadFileAsync(
       IItem::Pointer parent, const std::string& filename,
       IUploadFileCallback::Pointer cb) override {
+    OperationScope scope("uploadFile");
     return p_->uploadFileAsync(parent, filename, cb);
   }
 
   GetItemDataRequest::Pointer getItemDataAsync(
       const std::string& id, GetItemDataCallback callback) override {
-    return p_->getItemDataAsync(id, callback);
+    OperationScope scope("getItemData");
+    return p_->getItemDataCoalescedAsync(id, callback);
   }
 
   DownloadFileRequest::Pointer getThumbnailAsync(
       IItem::Pointer item, IDownloadFileCallback::Pointer cb) override {
+    OperationScope scope("getThumbnail");
     return p_->getThumbnailAsync(item, cb);
   }
 
   DeleteItemRequest::Pointer deleteItemAsync(
       IItem::Pointer item, DeleteItemCallback callback) override {
+    OperationScope scope("deleteItem");
     return p_->deleteItemAsync(item, callback);
   }
 
   CreateDirectoryRequest::Pointer createDirectoryAsync(
       IItem::Pointer parent, const std::string& name,
       CreateDirectoryCallback callback) override {
+    OperationScope scope("createDirectory");
     return p_->createDirectoryAsync(parent, name, callback);
   }
 
   MoveItemRequest::Pointer moveItemAsync(IItem::Pointer source,
                                          IItem::Pointer destination,
                                          MoveItemCallback callback) override {
+    OperationScope scope("moveItem");
     return p_->moveItemAsync(source, destination, callback);
   }
 
   RenameItemRequest::Pointer renameItemAsync(
       IItem::Pointer item, const std::string& name,
       RenameItemCallback callback) override {
+    OperationScope scope("renameItem");
     return p_->renameItemAsync(item, name, callback);
   }
 
   ListDirectoryPageRequest::Pointer listDirectoryPageAsync(
       IItem::Pointer directory, const std::string& token,
       ListDirectoryPageCallback cb) override {
-    return p_->listDirectoryPageAsync(directory, token, cb);
+    OperationScope scope("listDirectoryPage");
+    return p_->listDirectoryPageCoalescedAsync(directory, token, nullptr,
+                                              cb);
   }
 
   ListDirectoryRequest::Pointer listDirectorySimpleAsync(
       IItem::Pointer item, ListDirectoryCallback callback) override {
+    OperationScope scope("listDirectorySimple");
     return p_->listDirectorySimpleAsync(item, callback);
   }
 
   DownloadFileRequest::Pointer downloadFileAsync(
       IItem::Pointer item, const std::string& filename,
       DownloadFileCallback callback) override {
+    OperationScope scope("downloadFile");
     return p_->downloadFileAsync(item, filename, callback);
   }
 
   DownloadFileRequest::Pointer getThumbnailAsync(
       IItem::Pointer item, const std::string& filename,
       GetThumbnailCallback callback) override {
+    OperationScope scope("getThumbnail");
     return p_->getThumbnailAsync(item, filename, callback);
   }
 
   UploadFileRequest::Pointer uploadFileAsync(
       IItem::Pointer parent, const std::string& path,
       const std::string& filename, UploadFileCallback callback) override {
+    OperationScope scope("uploadFile");
     return p_->uploadFileAsync(parent, path, filename, callback);
   }
 
   GeneralDataRequest::Pointer getGeneralDataAsync(
       GeneralDataCallback callback) override {
+    OperationScope scope("getGeneralData");
     return p_->getGeneralDataAsync(callback);
   }
 
   GetItemUrlRequest::Pointer getFileDaemonUrlAsync(
       IItem::Pointer item, GetItemUrlCallback callback) override {
+    OperationScope scope("getFileDaemonUrl");
     return p_->getFileDaemonUrlAsync(item, callback);
   }
 
+  ChangesRequest::Pointer changesAsync(const std::string& cursor,
+                                       ChangesCallback callback) override {
+    OperationScope scope("changes");
+    return p_->changesAsync(cursor, callback);
+  }
+
+  void subscribeChanges(IChangesListener::Pointer listener) override {
+    p_->subscribeChanges(std::move(listener));
+  }
+
+  void unsubscribeChanges(const IChangesListener::Pointer& listener) override {
+    p_->unsubscribeChanges(listener);
+  }
+
  private:
   std::shared_ptr<CloudProvider> p_;
 };
@@ -224,7 +267,11 @@ ICloudProvider::Pointer CloudStorage::provider(
   if (it == std::end(providers_)) return nullptr;
   auto ret = it->second();
   ret->initialize(std::move(init_data));
-  return util::make_unique<CloudProviderWrapper>(ret);
+  ICloudProvider::Pointer result = util::make_unique<CloudProviderWrapper>(ret);
+  if (ret->metadata_cache()->enabled())
+    result = util::make_unique<CachedCloudProvider>(std::move(result),
+                                                    ret->metadata_cache());
+  return result;
 }
 
 ICloudStorage::Pointer ICloudStorage::create() {
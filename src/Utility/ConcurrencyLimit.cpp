@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * ConcurrencyLimit.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "ConcurrencyLimit.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace cloudstorage {
+
+ConcurrencyLimit::ConcurrencyLimit(size_t maximum)
+    : maximum_(maximum),
+      limit_(maximum ? maximum : std::numeric_limits<double>::infinity()),
+      running_(),
+      queued_() {}
+
+void ConcurrencyLimit::set_maximum(size_t maximum) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  maximum_ = maximum;
+  limit_ = maximum ? std::min<double>(limit_, maximum)
+                   : std::numeric_limits<double>::infinity();
+  auto admitted = admit();
+  lock.unlock();
+  for (auto&& task : admitted) task();
+}
+
+void ConcurrencyLimit::acquire(IHttpRequest::Priority priority,
+                               const void* owner, Task task) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (running_ + 1 <= limit_) {
+    // Queues are drained whenever there is room, so none of them can hold a
+    // task which should go first.
+    running_++;
+    lock.unlock();
+    return task();
+  }
+  queue_[static_cast<size_t>(priority)].push_back(
+      {owner, queued_++, std::move(task)});
+  auto admitted = admit();
+  lock.unlock();
+  for (auto&& task : admitted) task();
+}
+
+void ConcurrencyLimit::cancel(const void* owner) {
+  std::vector<Task> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto&& queue : queue_)
+      for (auto it = queue.begin(); it != queue.end();)
+        if (it->owner_ == owner) {
+          running_++;
+          cancelled.push_back(std::move(it->task_));
+          it = queue.erase(it);
+        } else {
+          ++it;
+        }
+  }
+  for (auto&& task : cancelled) task();
+}
+
+void ConcurrencyLimit::prioritize(const void* owner,
+                                  IHttpRequest::Priority priority) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& target = queue_[static_cast<size_t>(priority)];
+  for (size_t i = static_cast<size_t>(priority) + 1; i < queue_.size(); i++)
+    for (auto it = queue_[i].begin(); it != queue_[i].end();)
+      if (it->owner_ == owner) {
+        auto position = std::upper_bound(
+            target.begin(), target.end(), it->order_,
+            [](uint64_t order, const Queued& q) { return order < q.order_; });
+        target.insert(position, std::move(*it));
+        it = queue_[i].erase(it);
+      } else {
+        ++it;
+      }
+}
+
+void ConcurrencyLimit::release(bool throttled) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  running_--;
+  if (throttled)
+    limit_ = std::max(1.0, std::min<double>(limit_, running_ + 1) / 2);
+  else
+    limit_ += 1 / limit_;
+  if (maximum_ != 0) limit_ = std::min<double>(limit_, maximum_);
+  auto admitted = admit();
+  lock.unlock();
+  for (auto&& task : admitted) task();
+}
+
+double ConcurrencyLimit::limit() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return limit_;
+}
+
+std::vector<ConcurrencyLimit::Task> ConcurrencyLimit::admit() {
+  std::vector<Task> result;
+  for (auto&& queue : queue_)
+    while (!queue.empty() && running_ + 1 <= limit_) {
+      running_++;
+      result.push_back(std::move(queue.front().task_));
+      queue.pop_front();
+    }
+  return result;
+}
+
+}  // namespace cloudstorage
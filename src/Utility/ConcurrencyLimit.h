@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * ConcurrencyLimit.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef CONCURRENCYLIMIT_H
+#define CONCURRENCYLIMIT_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "IHttp.h"
+#include "Utility/Function.h"
+
+namespace cloudstorage {
+
+/**
+ * Limits count of tasks running at once. The limit adapts to the server: it's
+ * halved every time a task ends up throttled and grows by 1 / limit with every
+ * other completion, so that it converges to what the server accepts instead of
+ * bouncing between flooding it and backing off. It's unbounded until the first
+ * throttled completion, unless maximum is set.
+ */
+class ConcurrencyLimit {
+ public:
+  using Task = util::Function<void(), 12 * sizeof(void*)>;
+
+  ConcurrencyLimit(size_t maximum = 0);
+
+  /**
+   * @param maximum upper bound of the limit, 0 means none
+   */
+  void set_maximum(size_t maximum);
+
+  /**
+   * Runs the task right away if the limit allows it, otherwise queues it;
+   * queued tasks are run highest priority first. Every task has to be matched
+   * by a call to release once it's done.
+   *
+   * @param owner identifies the tasks to run by cancel
+   */
+  void acquire(IHttpRequest::Priority, const void* owner, Task);
+
+  /**
+   * Runs queued tasks of the owner right away regardless of the limit, so
+   * that they can end as cancelled instead of waiting for their turn.
+   */
+  void cancel(const void* owner);
+
+  /**
+   * Moves queued tasks of the owner to the queue of given priority, if it's
+   * higher than theirs, ahead of the tasks queued after them.
+   */
+  void prioritize(const void* owner, IHttpRequest::Priority);
+
+  /**
+   * @param throttled whether the server asked to slow down
+   */
+  void release(bool throttled);
+
+  /**
+   * @return current limit, infinity if it's unbounded
+   */
+  double limit() const;
+
+ private:
+  struct Queued {
+    const void* owner_;
+    uint64_t order_;  // tasks queued earlier are run first
+    Task task_;
+  };
+
+  std::vector<Task> admit();
+
+  mutable std::mutex mutex_;
+  size_t maximum_;
+  double limit_;
+  size_t running_;
+  uint64_t queued_;
+  std::array<std::deque<Queued>, 3> queue_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // CONCURRENCYLIMIT_H
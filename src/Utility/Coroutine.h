@@ -0,0 +1,326 @@
+/*****************************************************************************
+ * Coroutine.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define UTIL_HAS_COROUTINES
+#endif
+#endif
+
+#ifdef UTIL_HAS_COROUTINES
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "Promise.h"
+
+namespace util {
+
+namespace v2 {
+namespace detail {
+
+template <class T = void>
+class Task;
+
+struct TaskPromiseBase {
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <class P>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<P> handle) noexcept {
+      return handle.promise().continuation_;
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  std::coroutine_handle<> continuation_ = std::noop_coroutine();
+  std::exception_ptr exception_;
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase {
+  Task<T> get_return_object();
+
+  template <class U>
+  void return_value(U&& value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T result() {
+    if (exception_) std::rethrow_exception(exception_);
+    return std::move(*value_);
+  }
+
+  std::optional<T> value_;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object();
+
+  void return_void() const noexcept {}
+
+  void result() {
+    if (exception_) std::rethrow_exception(exception_);
+  }
+};
+
+/**
+ * Lazily started coroutine returning T. Runs when awaited, and resumes the
+ * awaiting coroutine directly when it finishes, so a chain of nested tasks
+ * doesn't grow the stack. Use spawn to start it from regular code.
+ */
+template <class T>
+class Task {
+ public:
+  using promise_type = TaskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      bool await_ready() const noexcept { return handle_.done(); }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation_ = continuation;
+        return handle_;
+      }
+      T await_resume() { return handle_.promise().result(); }
+
+      Handle handle_;
+    };
+    return Awaiter{handle_};
+  }
+
+ private:
+  friend struct TaskPromise<T>;
+
+  explicit Task(Handle handle) : handle_(handle) {}
+
+  Handle handle_;
+};
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+template <class... Ts>
+struct AwaitedType {
+  using type = std::tuple<Ts...>;
+};
+
+template <>
+struct AwaitedType<> {
+  using type = void;
+};
+
+template <class T>
+struct AwaitedType<T> {
+  using type = T;
+};
+
+/**
+ * Stores the outcome of awaited promise in the coroutine frame. The callbacks
+ * handed to the promise only capture this, so they fit in the small buffer of
+ * std::function and awaiting doesn't allocate.
+ */
+template <class... Ts>
+class PromiseAwaiterBase {
+ public:
+  explicit PromiseAwaiterBase(Promise<Ts...>&& promise)
+      : promise_(std::move(promise)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  typename AwaitedType<Ts...>::type await_resume() {
+    if (exception_) std::rethrow_exception(exception_);
+    if constexpr (sizeof...(Ts) == 1)
+      return std::move(std::get<0>(*value_));
+    else if constexpr (sizeof...(Ts) > 1)
+      return std::move(*value_);
+  }
+
+ protected:
+  template <class Callback>
+  void subscribe(Callback callback) {
+    promise_.subscribe(
+        [this, callback](Ts&&... args) {
+          value_.emplace(std::forward<Ts>(args)...);
+          callback();
+        },
+        [this, callback](std::exception_ptr&& e) {
+          exception_ = std::move(e);
+          callback();
+        });
+  }
+
+  std::coroutine_handle<> handle_;
+
+ private:
+  Promise<Ts...> promise_;
+  std::optional<std::tuple<Ts...>> value_;
+  std::exception_ptr exception_;
+};
+
+template <class... Ts>
+class PromiseAwaiter : public PromiseAwaiterBase<Ts...> {
+ public:
+  using PromiseAwaiterBase<Ts...>::PromiseAwaiterBase;
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    this->handle_ = handle;
+    this->subscribe([this] {
+      if (settled_.exchange(true, std::memory_order_acq_rel))
+        this->handle_.resume();
+    });
+    return !settled_.exchange(true, std::memory_order_acq_rel);
+  }
+
+ private:
+  std::atomic_bool settled_ = false;
+};
+
+template <class Executor, class... Ts>
+class ExecutorAwaiter : public PromiseAwaiterBase<Ts...> {
+ public:
+  ExecutorAwaiter(Executor executor, Promise<Ts...>&& promise)
+      : PromiseAwaiterBase<Ts...>(std::move(promise)),
+        executor_(std::move(executor)) {}
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    this->handle_ = handle;
+    this->subscribe([this] {
+      executor_([handle = this->handle_] { handle.resume(); });
+    });
+  }
+
+ private:
+  Executor executor_;
+};
+
+/**
+ * Awaiting a promise resumes the coroutine on the thread which settled it;
+ * for promises of ICloudAccess that is the thread of its event loop. Rejected
+ * promise rethrows its exception in the coroutine.
+ */
+template <class... Ts>
+PromiseAwaiter<Ts...> operator co_await(Promise<Ts...> promise) {
+  return PromiseAwaiter<Ts...>(std::move(promise));
+}
+
+/**
+ * Awaits the promise and resumes the coroutine by handing a nullary callable
+ * to executor, e.g. to continue on a thread pool or a ui thread.
+ */
+template <class Executor, class... Ts>
+ExecutorAwaiter<Executor, Ts...> resume_on(Executor executor,
+                                           Promise<Ts...> promise) {
+  return ExecutorAwaiter<Executor, Ts...>(std::move(executor),
+                                          std::move(promise));
+}
+
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+template <class T>
+Detached run(Task<T> task, Promise<T> promise) {
+  try {
+    promise.fulfill(co_await std::move(task));
+  } catch (...) {
+    promise.reject(std::current_exception());
+  }
+}
+
+inline Detached run(Task<void> task, Promise<> promise) {
+  try {
+    co_await std::move(task);
+    promise.fulfill();
+  } catch (...) {
+    promise.reject(std::current_exception());
+  }
+}
+
+template <class T>
+struct TaskResult {
+  using type = Promise<T>;
+};
+
+template <>
+struct TaskResult<void> {
+  using type = Promise<>;
+};
+
+/**
+ * Starts the task; returned promise is settled with its result.
+ */
+template <class T>
+typename TaskResult<T>::type spawn(Task<T> task) {
+  typename TaskResult<T>::type promise;
+  run(std::move(task), promise);
+  return promise;
+}
+
+}  // namespace detail
+}  // namespace v2
+
+using v2::detail::resume_on;
+using v2::detail::spawn;
+using v2::detail::Task;
+}  // namespace util
+
+#endif  // UTIL_HAS_COROUTINES
+
+#endif  // COROUTINE_H
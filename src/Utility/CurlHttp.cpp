@@ -26,6 +26,7 @@
 #include "CurlHttp.h"
 
 #include <json/json.h>
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include <sstream>
@@ -37,25 +38,121 @@
 #include <jni.h>
 #endif
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 const uint32_t MAX_URL_LENGTH = 1024;
-const uint32_t POLL_TIMEOUT = 100;
+const int STATUS_POLL_INTERVAL = 100;
+const size_t MAX_POOLED_HANDLES = 64;
+
+#ifdef __linux__
+const int MAX_EVENTS = 32;
+#else
+const int IDLE_POLL_TIMEOUT = 60 * 1000;
+#endif
 
 namespace cloudstorage {
 
 IHttp::Pointer IHttp::create() { return util::make_unique<curl::CurlHttp>(); }
 
+IHttp::Pointer IHttp::create(const Options& options) {
+  return util::make_unique<curl::CurlHttp>(options);
+}
+
 namespace curl {
 
 namespace {
 
+bool throttled(RequestData* data, IThrottle::Direction direction) {
+  auto& throttled = data->throttled_[static_cast<size_t>(direction)];
+  throttled = false;
+  for (auto&& t : data->throttles_)
+    if (!t->available(direction)) return throttled = true;
+  return false;
+}
+
+// Time until throttles of the transfer, paused because of them, let it go on.
+std::chrono::milliseconds throttle_delay(RequestData* data) {
+  std::chrono::milliseconds result{};
+  for (auto direction :
+       {IThrottle::Direction::Download, IThrottle::Direction::Upload})
+    if (data->throttled_[static_cast<size_t>(direction)])
+      for (auto&& t : data->throttles_)
+        result = std::max(result, t->delay(direction));
+  return result;
+}
+
+bool throttled(RequestData* data) {
+  for (auto direction :
+       {IThrottle::Direction::Download, IThrottle::Direction::Upload})
+    if (data->throttled_[static_cast<size_t>(direction)] &&
+        throttled(data, direction))
+      return true;
+  return false;
+}
+
+void consume(RequestData* data, IThrottle::Direction direction,
+             size_t bytes) {
+  for (auto&& t : data->throttles_) t->consume(direction, bytes);
+}
+
+#if LIBCURL_VERSION_NUM >= 0x073d00
+#define CURLINFO_TIME(phase) CURLINFO_##phase##_TIME_T
+#define CURLINFO_SIZE(direction) CURLINFO_SIZE_##direction##_T
+
+uint64_t info(CURL* handle, CURLINFO info) {
+  curl_off_t value = 0;
+  curl_easy_getinfo(handle, info, &value);
+  return static_cast<uint64_t>(value);
+}
+#else
+#define CURLINFO_TIME(phase) CURLINFO_##phase##_TIME
+#define CURLINFO_SIZE(direction) CURLINFO_SIZE_##direction
+
+uint64_t info(CURL* handle, CURLINFO info) {
+  double value = 0;
+  curl_easy_getinfo(handle, info, &value);
+  // times are reported in seconds
+  if ((info & CURLINFO_TYPEMASK) == CURLINFO_DOUBLE &&
+      info != CURLINFO_SIZE_DOWNLOAD && info != CURLINFO_SIZE_UPLOAD)
+    value *= 1000000;
+  return static_cast<uint64_t>(value);
+}
+#endif
+
+IHttpRequest::Metrics metrics(CURL* handle) {
+  IHttpRequest::Metrics result;
+  result.name_lookup_time_ = info(handle, CURLINFO_TIME(NAMELOOKUP));
+  result.connect_time_ = info(handle, CURLINFO_TIME(CONNECT));
+  result.tls_handshake_time_ = info(handle, CURLINFO_TIME(APPCONNECT));
+  result.pretransfer_time_ = info(handle, CURLINFO_TIME(PRETRANSFER));
+  result.start_transfer_time_ = info(handle, CURLINFO_TIME(STARTTRANSFER));
+  result.redirect_time_ = info(handle, CURLINFO_TIME(REDIRECT));
+  result.total_time_ = info(handle, CURLINFO_TIME(TOTAL));
+  result.downloaded_bytes_ = info(handle, CURLINFO_SIZE(DOWNLOAD));
+  result.uploaded_bytes_ = info(handle, CURLINFO_SIZE(UPLOAD));
+  long connects = 0;
+  curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects);
+  result.connection_reused_ = connects == 0 && result.total_time_ > 0;
+  return result;
+}
+
 size_t write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
   auto data = static_cast<RequestData*>(userdata);
+  if (throttled(data, IThrottle::Direction::Download))
+    return CURL_WRITEFUNC_PAUSE;
+  consume(data, IThrottle::Direction::Download, size * nmemb);
   if (!data->http_code_)
     curl_easy_getinfo(data->handle_.get(), CURLINFO_RESPONSE_CODE,
                       &data->http_code_);
+  auto code = static_cast<int>(data->http_code_);
   if (!data->error_stream_ ||
-      data->callback_->isSuccess(static_cast<int>(data->http_code_),
-                                 data->response_headers_)) {
+      (data->callback_
+           ? data->callback_->isSuccess(code, data->response_headers_)
+           : IHttpRequest::isSuccess(code))) {
     auto range_it = data->query_headers_.find("Range");
     if (range_it != data->query_headers_.end() &&
         data->http_code_ != IHttpRequest::Partial) {
@@ -76,8 +173,11 @@ size_t write_callback(char* ptr, size_t size, size_t nmemb, void* userdata) {
 
 size_t read_callback(char* buffer, size_t size, size_t nmemb, void* userdata) {
   auto data = static_cast<RequestData*>(userdata);
+  if (throttled(data, IThrottle::Direction::Upload))
+    return CURL_READFUNC_PAUSE;
   auto stream = data->data_.get();
   stream->read(buffer, size * nmemb);
+  consume(data, IThrottle::Direction::Upload, stream->gcount());
   return stream->gcount();
 }
 
@@ -102,6 +202,12 @@ size_t header_callback(char* buffer, size_t size, size_t nitems,
   return size * nitems;
 }
 
+void set_paused(RequestData* data, bool paused) {
+  if (data->paused_ == paused) return;
+  data->paused_ = paused;
+  curl_easy_pause(data->handle_.get(), paused ? CURLPAUSE_ALL : CURLPAUSE_CONT);
+}
+
 int progress_callback(void* clientp, curl_off_t dltotal, curl_off_t dlnow,
                       curl_off_t ultotal, curl_off_t ulnow) {
   auto data = static_cast<RequestData*>(clientp);
@@ -113,10 +219,7 @@ int progress_callback(void* clientp, curl_off_t dltotal, curl_off_t dlnow,
     if (dltotal != 0)
       callback->progressDownload(static_cast<uint64_t>(dltotal),
                                  static_cast<uint64_t>(dlnow));
-    if (callback->pause())
-      curl_easy_pause(data->handle_.get(), CURLPAUSE_ALL);
-    else
-      curl_easy_pause(data->handle_.get(), CURLPAUSE_CONT);
+    set_paused(data, callback->pause());
     if (callback->abort()) return 1;
   }
   return 0;
@@ -131,58 +234,368 @@ std::ios::pos_type stream_length(std::istream& data) {
 
 }  // namespace
 
-CurlHttp::Worker::Worker() : done_(), thread_(std::bind(&Worker::work, this)) {}
+Share::Share()
+    : handle_(curl_share_init()),
+      requests_(),
+      handles_reused_(),
+      connections_reused_() {
+  curl_share_setopt(handle_, CURLSHOPT_LOCKFUNC, lock);
+  curl_share_setopt(handle_, CURLSHOPT_UNLOCKFUNC, unlock);
+  curl_share_setopt(handle_, CURLSHOPT_USERDATA, this);
+  curl_share_setopt(handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(handle_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+Share::~Share() {
+  pool_.clear();
+  curl_share_cleanup(handle_);
+}
+
+Share::Handle Share::acquire() {
+  requests_++;
+  Handle handle;
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (!pool_.empty()) {
+      handle = std::move(pool_.back());
+      pool_.pop_back();
+    }
+  }
+  if (handle)
+    handles_reused_++;
+  else
+    handle = Handle(curl_easy_init());
+  curl_easy_setopt(handle.get(), CURLOPT_SHARE, handle_);
+  return handle;
+}
+
+void Share::release(Handle handle) {
+  curl_easy_reset(handle.get());
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+  if (pool_.size() < MAX_POOLED_HANDLES) pool_.push_back(std::move(handle));
+}
+
+void Share::completed(CURL* handle) {
+  long connects = 0;
+  if (curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &connects) == CURLE_OK &&
+      connects == 0)
+    connections_reused_++;
+}
+
+Share::Statistics Share::statistics() const {
+  return {requests_, handles_reused_, connections_reused_};
+}
+
+void Share::lock(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+  static_cast<Share*>(userp)->locks_[data].lock();
+}
+
+void Share::unlock(CURL*, curl_lock_data data, void* userp) {
+  static_cast<Share*>(userp)->locks_[data].unlock();
+}
+
+CurlHttp::Worker::Worker(std::shared_ptr<Share> share,
+                         std::shared_ptr<Scheduler> scheduler,
+                         const Options& options)
+    : share_(std::move(share)),
+      scheduler_(std::move(scheduler)),
+      connect_timeout_(options.connect_timeout_),
+      first_byte_timeout_(options.first_byte_timeout_),
+      stall_timeout_(options.stall_timeout_),
+      done_(),
+      load_(),
+      handle_(curl_multi_init()),
+      next_check_(std::chrono::steady_clock::time_point::max()),
+#ifdef __linux__
+      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      event_(std::make_shared<Event>()),
+      timer_active_(),
+#endif
+      thread_() {
+  if (options.version_ != IHttp::Version::Http1)
+    curl_multi_setopt(handle_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+  curl_multi_setopt(handle_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                    static_cast<long>(options.max_host_connections_));
+#if LIBCURL_VERSION_NUM >= 0x074300
+  curl_multi_setopt(handle_, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                    static_cast<long>(options.max_concurrent_streams_));
+#endif
+#ifdef __linux__
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = event_->fd_;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_->fd_, &event);
+  curl_multi_setopt(handle_, CURLMOPT_SOCKETFUNCTION, socket_callback);
+  curl_multi_setopt(handle_, CURLMOPT_SOCKETDATA, this);
+  curl_multi_setopt(handle_, CURLMOPT_TIMERFUNCTION, timer_callback);
+  curl_multi_setopt(handle_, CURLMOPT_TIMERDATA, this);
+#endif
+  thread_ = std::thread(std::bind(&Worker::work, this));
+}
 
 CurlHttp::Worker::~Worker() {
   done_ = true;
-  nonempty_.notify_one();
+  wakeup();
   thread_.join();
+  curl_multi_cleanup(handle_);
+#ifdef __linux__
+  close(epoll_fd_);
+#endif
 }
 
 void CurlHttp::Worker::work() {
   util::set_thread_name("cs-curl");
   util::attach_thread();
-  auto handle = curl_multi_init();
   while (!done_ || !pending_.empty()) {
     std::unique_lock<std::mutex> lock(lock_);
-    nonempty_.wait(lock, [=]() {
-      return done_ || !requests_.empty() || !pending_.empty();
-    });
     auto requests = util::exchange(requests_, {});
     lock.unlock();
     for (auto&& r : requests) {
-      curl_multi_add_handle(handle, r->handle_.get());
+      auto now = std::chrono::steady_clock::now();
+      if (first_byte_timeout_.count() > 0 && !r->long_poll_) {
+        r->first_byte_deadline_ = now + first_byte_timeout_;
+        next_check_ = std::min(next_check_, r->first_byte_deadline_);
+      }
+#ifdef __linux__
+      std::shared_ptr<Event> event = event_;
+      r->polled_ = r->callback_ &&
+                   !r->callback_->setWakeup([event] { event->signal(); });
+#else
+      r->polled_ = static_cast<bool>(r->callback_);
+#endif
+      if (r->polled_)
+        next_check_ = std::min(
+            next_check_, now + std::chrono::milliseconds(STATUS_POLL_INTERVAL));
+      curl_multi_add_handle(handle_, r->handle_.get());
       pending_[r->handle_.get()] = std::move(r);
     }
-    int rc;
-    curl_multi_wait(handle, nullptr, 0, POLL_TIMEOUT, &rc);
-    if (rc == 0)
-      std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT));
-    int running_handles = 0;
-    curl_multi_perform(handle, &running_handles);
-    CURLMsg* msg;
-    do {
-      int message_count;
-      msg = curl_multi_info_read(handle, &message_count);
-      if (msg && msg->msg == CURLMSG_DONE) {
-        auto easy_handle = msg->easy_handle;
-        curl_multi_remove_handle(handle, easy_handle);
-        auto it = pending_.find(easy_handle);
-        it->second->done(msg->data.result);
-        pending_.erase(it);
-      }
-    } while (msg);
+    poll();
+    update_status();
+    process_messages();
   }
-  curl_multi_cleanup(handle);
   util::detach_thread();
 }
 
 void CurlHttp::Worker::add(RequestData::Pointer r) {
+  load_++;
   {
     std::lock_guard<std::mutex> lock(lock_);
     requests_.push_back(std::move(r));
   }
-  nonempty_.notify_all();
+  wakeup();
+}
+
+#ifdef __linux__
+
+CurlHttp::Worker::Event::Event()
+    : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+CurlHttp::Worker::Event::~Event() { close(fd_); }
+
+void CurlHttp::Worker::Event::signal() const {
+  uint64_t value = 1;
+  if (write(fd_, &value, sizeof(value)) != sizeof(value))
+    util::log("couldn't signal curl worker");
+}
+
+void CurlHttp::Worker::wakeup() { event_->signal(); }
+
+void CurlHttp::Worker::poll() {
+  auto deadline = next_check_;
+  if (timer_active_) deadline = std::min(deadline, timer_);
+  int timeout = -1;
+  if (deadline != std::chrono::steady_clock::time_point::max()) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         deadline - std::chrono::steady_clock::now())
+                         .count();
+    // Rounded up, so that the deadline has passed once epoll_wait returns.
+    timeout = static_cast<int>(std::max<decltype(remaining)>(remaining + 1, 0));
+  }
+  std::array<epoll_event, MAX_EVENTS> events;
+  int count = epoll_wait(epoll_fd_, events.data(), MAX_EVENTS, timeout);
+  int running_handles = 0;
+  for (int i = 0; i < count; i++) {
+    if (events[i].data.fd == event_->fd_) {
+      uint64_t value;
+      while (read(event_->fd_, &value, sizeof(value)) > 0) {
+      }
+    } else {
+      int flags = 0;
+      if (events[i].events & EPOLLIN) flags |= CURL_CSELECT_IN;
+      if (events[i].events & EPOLLOUT) flags |= CURL_CSELECT_OUT;
+      if (events[i].events & (EPOLLERR | EPOLLHUP)) flags |= CURL_CSELECT_ERR;
+      curl_multi_socket_action(handle_, events[i].data.fd, flags,
+                               &running_handles);
+    }
+  }
+  if (timer_active_ && timer_ <= std::chrono::steady_clock::now()) {
+    timer_active_ = false;
+    curl_multi_socket_action(handle_, CURL_SOCKET_TIMEOUT, 0, &running_handles);
+  }
+}
+
+int CurlHttp::Worker::socket_callback(CURL*, curl_socket_t socket, int what,
+                                      void* userp, void* socketp) {
+  auto worker = static_cast<Worker*>(userp);
+  if (what == CURL_POLL_REMOVE) {
+    epoll_ctl(worker->epoll_fd_, EPOLL_CTL_DEL, socket, nullptr);
+    return 0;
+  }
+  epoll_event event = {};
+  event.data.fd = socket;
+  if (what & CURL_POLL_IN) event.events |= EPOLLIN;
+  if (what & CURL_POLL_OUT) event.events |= EPOLLOUT;
+  if (!socketp) {
+    curl_multi_assign(worker->handle_, socket, worker);
+    if (epoll_ctl(worker->epoll_fd_, EPOLL_CTL_ADD, socket, &event) == 0)
+      return 0;
+  }
+  epoll_ctl(worker->epoll_fd_, EPOLL_CTL_MOD, socket, &event);
+  return 0;
+}
+
+int CurlHttp::Worker::timer_callback(CURLM*, long timeout_ms, void* userp) {
+  auto worker = static_cast<Worker*>(userp);
+  worker->timer_active_ = timeout_ms >= 0;
+  if (worker->timer_active_)
+    worker->timer_ = std::chrono::steady_clock::now() +
+                     std::chrono::milliseconds(timeout_ms);
+  return 0;
+}
+
+#else
+
+void CurlHttp::Worker::wakeup() { curl_multi_wakeup(handle_); }
+
+void CurlHttp::Worker::poll() {
+  curl_multi_poll(handle_, nullptr, 0,
+                  pending_.empty() ? IDLE_POLL_TIMEOUT : STATUS_POLL_INTERVAL,
+                  nullptr);
+  int running_handles = 0;
+  curl_multi_perform(handle_, &running_handles);
+}
+
+#endif  // __linux__
+
+void CurlHttp::Worker::update_status() {
+  std::vector<CURL*> aborted, timed_out;
+  auto now = std::chrono::steady_clock::now();
+  next_check_ = std::chrono::steady_clock::time_point::max();
+  for (auto&& r : pending_) {
+    auto data = r.second.get();
+    if (data->first_byte_deadline_ <= now) {
+      double start_transfer = 0;
+      curl_easy_getinfo(r.first, CURLINFO_STARTTRANSFER_TIME, &start_transfer);
+      if (start_transfer == 0) {
+        timed_out.push_back(r.first);
+        continue;
+      }
+      data->first_byte_deadline_ = std::chrono::steady_clock::time_point::max();
+    }
+    next_check_ = std::min(next_check_, data->first_byte_deadline_);
+    if (auto callback = data->callback_.get()) {
+      if (callback->abort()) {
+        aborted.push_back(r.first);
+        continue;
+      }
+      set_paused(data, callback->pause());
+      if (data->polled_)
+        next_check_ = std::min(
+            next_check_, now + std::chrono::milliseconds(STATUS_POLL_INTERVAL));
+    }
+    if (!data->paused_ && (data->throttled_[0] || data->throttled_[1])) {
+      if (!throttled(data))
+        curl_easy_pause(r.first, CURLPAUSE_CONT);
+      else
+        next_check_ = std::min(next_check_, now + throttle_delay(data));
+    }
+  }
+  for (auto handle : aborted) finish(handle, CURLE_ABORTED_BY_CALLBACK);
+  for (auto handle : timed_out) finish(handle, CURLE_OPERATION_TIMEDOUT);
+}
+
+void CurlHttp::Worker::process_messages() {
+  CURLMsg* msg;
+  do {
+    int message_count;
+    msg = curl_multi_info_read(handle_, &message_count);
+    if (msg && msg->msg == CURLMSG_DONE) {
+      share_->completed(msg->easy_handle);
+      finish(msg->easy_handle, msg->data.result);
+    }
+  } while (msg);
+}
+
+void CurlHttp::Worker::finish(CURL* handle, CURLcode result) {
+  curl_multi_remove_handle(handle_, handle);
+  auto it = pending_.find(handle);
+  auto data = std::move(it->second);
+  pending_.erase(it);
+  load_--;
+  scheduler_->finished(*data);
+  data->done(result);
+  share_->release(std::move(data->handle_));
+}
+
+CurlHttp::Scheduler::Scheduler(const Options& options)
+    : max_requests_(options.max_requests_),
+      max_host_requests_(options.max_host_requests_),
+      running_(),
+      closed_() {}
+
+void CurlHttp::Scheduler::add(RequestData::Pointer data, Worker* worker) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  queue_[static_cast<size_t>(data->priority_)].push_back(
+      {std::move(data), worker});
+  auto admitted = dispatch();
+  lock.unlock();
+  for (auto&& e : admitted) e.worker_->add(std::move(e.data_));
+}
+
+void CurlHttp::Scheduler::finished(const RequestData& data) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  running_--;
+  if (max_host_requests_ != 0) {
+    auto it = host_running_.find(data.host_);
+    if (--it->second == 0) host_running_.erase(it);
+  }
+  auto admitted = dispatch();
+  lock.unlock();
+  for (auto&& e : admitted) e.worker_->add(std::move(e.data_));
+}
+
+void CurlHttp::Scheduler::close() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  closed_ = true;
+  auto admitted = dispatch();
+  lock.unlock();
+  for (auto&& e : admitted) e.worker_->add(std::move(e.data_));
+}
+
+bool CurlHttp::Scheduler::admissible(const RequestData& data) const {
+  if (closed_) return true;
+  if (max_host_requests_ == 0) return true;
+  auto it = host_running_.find(data.host_);
+  return it == host_running_.end() || it->second < max_host_requests_;
+}
+
+std::vector<CurlHttp::Scheduler::Entry> CurlHttp::Scheduler::dispatch() {
+  std::vector<Entry> result;
+  for (auto&& queue : queue_) {
+    for (auto it = queue.begin(); it != queue.end();) {
+      if (!closed_ && max_requests_ != 0 && running_ >= max_requests_)
+        return result;
+      if (admissible(*it->data_)) {
+        running_++;
+        if (max_host_requests_ != 0) host_running_[it->data_->host_]++;
+        result.push_back(std::move(*it));
+        it = queue.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+  return result;
 }
 
 void RequestData::done(int code) {
@@ -199,21 +612,31 @@ void RequestData::done(int code) {
     }
   } else {
     *error_stream_ << curl_easy_strerror(static_cast<CURLcode>(code));
-    ret = (code == CURLE_ABORTED_BY_CALLBACK) ? IHttpRequest::Aborted : -code;
+    if (code == CURLE_ABORTED_BY_CALLBACK)
+      ret = IHttpRequest::Aborted;
+    else if (code == CURLE_OPERATION_TIMEDOUT)
+      ret = IHttpRequest::Timeout;
+    else
+      ret = -code;
   }
-  complete_({ret, response_headers_, stream_, error_stream_});
+  complete_({ret, response_headers_, stream_, error_stream_,
+             metrics(handle_.get())});
 }
 
 CurlHttpRequest::CurlHttpRequest(std::string url, std::string method,
-                                 bool follow_redirect,
+                                 bool follow_redirect, IHttp::Version version,
                                  std::shared_ptr<CurlHttp::Worker> worker)
     : url_(std::move(url)),
       method_(std::move(method)),
       follow_redirect_(follow_redirect),
+      version_(version),
+      priority_(Priority::Interactive),
+      deadline_(std::chrono::steady_clock::time_point::max()),
+      long_poll_(false),
       worker_(std::move(worker)) {}
 
-std::unique_ptr<CURL, CurlDeleter> CurlHttpRequest::init() const {
-  std::unique_ptr<CURL, CurlDeleter> handle(curl_easy_init());
+Share::Handle CurlHttpRequest::init() const {
+  auto handle = worker_->share_->acquire();
   curl_easy_setopt(handle.get(), CURLOPT_WRITEFUNCTION, write_callback);
   curl_easy_setopt(handle.get(), CURLOPT_READFUNCTION, read_callback);
   curl_easy_setopt(handle.get(), CURLOPT_HEADERFUNCTION, header_callback);
@@ -223,6 +646,34 @@ std::unique_ptr<CURL, CurlDeleter> CurlHttpRequest::init() const {
                    static_cast<long>(follow_redirect_));
   curl_easy_setopt(handle.get(), CURLOPT_XFERINFOFUNCTION, progress_callback);
   curl_easy_setopt(handle.get(), CURLOPT_NOPROGRESS, static_cast<long>(false));
+  if (worker_->connect_timeout_.count() > 0)
+    curl_easy_setopt(handle.get(), CURLOPT_CONNECTTIMEOUT_MS,
+                     static_cast<long>(worker_->connect_timeout_.count()));
+  if (worker_->stall_timeout_.count() > 0 && !long_poll_) {
+    curl_easy_setopt(handle.get(), CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(
+        handle.get(), CURLOPT_LOW_SPEED_TIME,
+        static_cast<long>((worker_->stall_timeout_.count() + 999) / 1000));
+  }
+  if (deadline_ != std::chrono::steady_clock::time_point::max()) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         deadline_ - std::chrono::steady_clock::now())
+                         .count();
+    curl_easy_setopt(handle.get(), CURLOPT_TIMEOUT_MS,
+                     static_cast<long>(std::max<int64_t>(remaining, 1)));
+  }
+  if (version_ != IHttp::Version::Http1) {
+    curl_easy_setopt(handle.get(), CURLOPT_HTTP_VERSION,
+                     version_ == IHttp::Version::Http2
+                         ? CURL_HTTP_VERSION_2TLS
+                         : CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+    curl_easy_setopt(handle.get(), CURLOPT_PIPEWAIT, 1L);
+#if LIBCURL_VERSION_NUM >= 0x072e00
+    const long weight[] = {256, 64, 8};
+    curl_easy_setopt(handle.get(), CURLOPT_STREAM_WEIGHT,
+                     weight[static_cast<size_t>(priority_)]);
+#endif
+  }
   std::string parameters = parametersToString();
   std::string url = url_ + (!parameters.empty() ? ("?" + parameters) : "");
   curl_easy_setopt(handle.get(), CURLOPT_URL, url.c_str());
@@ -250,6 +701,26 @@ const IHttpRequest::HeaderParameters& CurlHttpRequest::headerParameters()
 
 bool CurlHttpRequest::follow_redirect() const { return follow_redirect_; }
 
+void CurlHttpRequest::setPriority(Priority priority) { priority_ = priority; }
+
+IHttpRequest::Priority CurlHttpRequest::priority() const { return priority_; }
+
+void CurlHttpRequest::addThrottle(IThrottle::Pointer throttle) {
+  throttles_.push_back(std::move(throttle));
+}
+
+void CurlHttpRequest::setDeadline(std::chrono::steady_clock::time_point d) {
+  deadline_ = d;
+}
+
+std::chrono::steady_clock::time_point CurlHttpRequest::deadline() const {
+  return deadline_;
+}
+
+void CurlHttpRequest::setLongPoll(bool long_poll) { long_poll_ = long_poll; }
+
+bool CurlHttpRequest::longPoll() const { return long_poll_; }
+
 const std::string& CurlHttpRequest::url() const { return url_; }
 
 const std::string& CurlHttpRequest::method() const { return method_; }
@@ -271,7 +742,14 @@ RequestData::Pointer CurlHttpRequest::prepare(
                                                  complete,
                                                  follow_redirect(),
                                                  0,
-                                                 0});
+                                                 0,
+                                                 false,
+                                                 priority_,
+                                                 util::Url(url_).host(),
+                                                 throttles_,
+                                                 {}});
+  cb_data->first_byte_deadline_ = std::chrono::steady_clock::time_point::max();
+  cb_data->long_poll_ = long_poll_;
   auto handle = cb_data->handle_.get();
   curl_easy_setopt(handle, CURLOPT_WRITEDATA, cb_data.get());
   curl_easy_setopt(handle, CURLOPT_XFERINFODATA, cb_data.get());
@@ -304,7 +782,8 @@ void CurlHttpRequest::send(CompleteCallback c,
                            std::shared_ptr<std::ostream> response,
                            std::shared_ptr<std::ostream> error_stream,
                            ICallback::Pointer cb) const {
-  worker_->add(prepare(c, data, response, error_stream, cb));
+  worker_->scheduler_->add(prepare(c, data, response, error_stream, cb),
+                           worker_.get());
 }
 
 std::string CurlHttpRequest::parametersToString() const {
@@ -334,13 +813,40 @@ void CurlListDeleter::operator()(curl_slist* lst) const {
   curl_slist_free_all(lst);
 }
 
-CurlHttp::CurlHttp() : worker_(std::make_shared<Worker>()) {}
+CurlHttp::CurlHttp(const Options& options)
+    : options_(options),
+      share_(std::make_shared<Share>()),
+      scheduler_(std::make_shared<Scheduler>(options)) {
+  auto count = options.worker_count_;
+  if (count == 0) count = std::max(std::thread::hardware_concurrency(), 1u);
+  for (uint32_t i = 0; i < count; i++)
+    workers_.push_back(std::make_shared<Worker>(share_, scheduler_, options));
+}
+
+CurlHttp::~CurlHttp() { scheduler_->close(); }
+
+std::shared_ptr<CurlHttp::Worker> CurlHttp::worker(
+    const std::string& url) const {
+  if (workers_.size() == 1) return workers_.front();
+  if (options_.version_ != Version::Http1 ||
+      options_.max_host_connections_ != 0) {
+    auto hash = std::hash<std::string>()(util::Url(url).host());
+    return workers_[hash % workers_.size()];
+  }
+  return *std::min_element(
+      workers_.begin(), workers_.end(),
+      [](const std::shared_ptr<Worker>& a, const std::shared_ptr<Worker>& b) {
+        return a->load() < b->load();
+      });
+}
+
+Share::Statistics CurlHttp::statistics() const { return share_->statistics(); }
 
 IHttpRequest::Pointer CurlHttp::create(const std::string& url,
                                        const std::string& method,
                                        bool follow_redirect) const {
   return util::make_unique<CurlHttpRequest>(url, method, follow_redirect,
-                                            worker_);
+                                            options_.version_, worker(url));
 }
 
 }  // namespace curl
@@ -353,6 +859,7 @@ IHttpRequest::Pointer CurlHttp::create(const std::string& url,
 
 namespace cloudstorage {
 IHttp::Pointer IHttp::create() { return nullptr; }
+IHttp::Pointer IHttp::create(const Options&) { return nullptr; }
 }  // namespace cloudstorage
 
 #endif  // WITH_CURL
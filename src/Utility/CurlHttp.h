@@ -27,10 +27,13 @@
 #ifdef WITH_CURL
 
 #include <curl/curl.h>
+#include <array>
 #include <atomic>
 #include <cctype>
-#include <condition_variable>
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -50,6 +53,50 @@ struct CurlListDeleter {
   void operator()(curl_slist*) const;
 };
 
+/**
+ * State shared by all transfers of a CurlHttp instance: a CURLSH object
+ * sharing the DNS cache and TLS sessions, and a pool of easy handles which are
+ * reset and reused instead of being recreated for every request. Connections
+ * are not shared, libcurl doesn't support using a connection from multi
+ * handles driven by different threads; every worker's multi handle keeps its
+ * own connection cache instead.
+ */
+class Share {
+ public:
+  using Handle = std::unique_ptr<CURL, CurlDeleter>;
+
+  struct Statistics {
+    uint64_t requests_;
+    uint64_t handles_reused_;
+    uint64_t connections_reused_;
+  };
+
+  Share();
+  ~Share();
+
+  Handle acquire();
+  void release(Handle);
+
+  /**
+   * Updates statistics with information about finished transfer.
+   */
+  void completed(CURL*);
+
+  Statistics statistics() const;
+
+ private:
+  static void lock(CURL*, curl_lock_data, curl_lock_access, void*);
+  static void unlock(CURL*, curl_lock_data, void*);
+
+  CURLSH* handle_;
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> locks_;
+  std::mutex pool_mutex_;
+  std::vector<Handle> pool_;
+  std::atomic<uint64_t> requests_;
+  std::atomic<uint64_t> handles_reused_;
+  std::atomic<uint64_t> connections_reused_;
+};
+
 struct RequestData {
   using Pointer = std::unique_ptr<RequestData>;
 
@@ -65,44 +112,177 @@ struct RequestData {
   bool follow_redirect_;
   long http_code_;
   uint64_t received_bytes_;
+  bool paused_;
+  IHttpRequest::Priority priority_;
+  std::string host_;
+  std::vector<IThrottle::Pointer> throttles_;
+  std::array<bool, 2> throttled_;  // indexed by IThrottle::Direction
+  // time by which the response has to start, max if it already did
+  std::chrono::steady_clock::time_point first_byte_deadline_;
+  bool long_poll_;
+  // whether abort and pause of the callback have to be polled, as it doesn't
+  // wake the worker when they change
+  bool polled_;
 
   void done(int result);
 };
 
 class CurlHttp : public IHttp {
  public:
-  CurlHttp();
+  CurlHttp(const Options& = Options());
+  ~CurlHttp() override;
 
   IHttpRequest::Pointer create(const std::string&, const std::string&,
                                bool) const override;
 
+  Share::Statistics statistics() const;
+
  private:
   friend class CurlHttpRequest;
 
+  class Scheduler;
+
   struct Worker {
-    Worker();
+    Worker(std::shared_ptr<Share>, std::shared_ptr<Scheduler>,
+           const Options&);
     ~Worker();
 
     void work();
     void add(RequestData::Pointer r);
 
+    size_t load() const { return load_; }
+
+    /**
+     * Removes the transfer from the multi handle, reports its result and
+     * returns its easy handle to the pool.
+     */
+    void finish(CURL*, CURLcode);
+
+    /**
+     * Interrupts poll() so that the worker notices new requests or the
+     * destruction request right away.
+     */
+    void wakeup();
+
+    /**
+     * Blocks until there is activity on one of curl's sockets, curl's timer
+     * expires, wakeup() is called or it's time to check the transfers again,
+     * see next_check_.
+     */
+    void poll();
+
+    /**
+     * Pauses, resumes and aborts transfers according to their callbacks and
+     * throttles, and sets the time of the next check.
+     */
+    void update_status();
+
+    void process_messages();
+
+#ifdef __linux__
+    static int socket_callback(CURL*, curl_socket_t, int what, void* userp,
+                               void* socketp);
+    static int timer_callback(CURLM*, long timeout_ms, void* userp);
+#endif
+
+    std::shared_ptr<Share> share_;
+    std::shared_ptr<Scheduler> scheduler_;
+    const std::chrono::milliseconds connect_timeout_;
+    const std::chrono::milliseconds first_byte_timeout_;
+    const std::chrono::milliseconds stall_timeout_;
     std::atomic_bool done_;
-    std::condition_variable nonempty_;
+    std::atomic<size_t> load_;
     std::vector<RequestData::Pointer> requests_;
     std::unordered_map<CURL*, RequestData::Pointer> pending_;
     std::mutex lock_;
+    CURLM* handle_;
+    // nearest first byte deadline or end of a throttle wait, every
+    // STATUS_POLL_INTERVAL while there are polled transfers
+    std::chrono::steady_clock::time_point next_check_;
+#ifdef __linux__
+    /**
+     * Eventfd interrupting poll(); callbacks of the transfers share it, as
+     * they may signal it after the worker is gone.
+     */
+    struct Event {
+      Event();
+      ~Event();
+
+      void signal() const;
+
+      int fd_;
+    };
+
+    int epoll_fd_;
+    std::shared_ptr<Event> event_;
+    bool timer_active_;
+    std::chrono::steady_clock::time_point timer_;
+#endif
     std::thread thread_;
   };
 
-  std::shared_ptr<Worker> worker_;
+  /**
+   * Admits transfers to the workers. Transfers over the global or per-host
+   * in-flight limit wait in queues, one per priority class, and are admitted
+   * highest priority first as the running ones finish.
+   */
+  class Scheduler {
+   public:
+    Scheduler(const Options&);
+
+    void add(RequestData::Pointer, Worker*);
+
+    /**
+     * Frees the slot taken by finished transfer and admits waiting ones.
+     */
+    void finished(const RequestData&);
+
+    /**
+     * Admits all waiting transfers regardless of the limits, so that none is
+     * lost when the workers are destroyed.
+     */
+    void close();
+
+   private:
+    struct Entry {
+      RequestData::Pointer data_;
+      Worker* worker_;
+    };
+
+    bool admissible(const RequestData&) const;
+    std::vector<Entry> dispatch();
+
+    const uint32_t max_requests_;
+    const uint32_t max_host_requests_;
+    std::mutex mutex_;
+    std::array<std::deque<Entry>, 3> queue_;
+    uint32_t running_;
+    std::unordered_map<std::string, uint32_t> host_running_;
+    bool closed_;
+  };
+
+  /**
+   * Picks the worker which will run the transfer. Transfers which should
+   * share connections, i.e. when HTTP/2 or a per-host connection limit is
+   * used, go to the worker chosen by hash of the host, so that they meet in
+   * one connection cache and the limit holds. The rest go to the worker with
+   * the least transfers in flight.
+   */
+  std::shared_ptr<Worker> worker(const std::string& url) const;
+
+  Options options_;
+  std::shared_ptr<Share> share_;
+  std::shared_ptr<Scheduler> scheduler_;
+  std::vector<std::shared_ptr<Worker>> workers_;
 };
 
 class CurlHttpRequest : public IHttpRequest,
                         public std::enable_shared_from_this<CurlHttpRequest> {
  public:
   CurlHttpRequest(std::string url, std::string method, bool follow_redirect,
+                  IHttp::Version version,
                   std::shared_ptr<CurlHttp::Worker> worker);
-  std::unique_ptr<CURL, CurlDeleter> init() const;
+  Share::Handle init() const;
 
   void setParameter(const std::string& parameter,
                     const std::string& value) override;
@@ -112,6 +292,17 @@ class CurlHttpRequest : public IHttpRequest,
   const GetParameters& parameters() const override;
   const HeaderParameters& headerParameters() const override;
 
+  void setPriority(Priority) override;
+  Priority priority() const override;
+
+  void addThrottle(IThrottle::Pointer) override;
+
+  void setDeadline(std::chrono::steady_clock::time_point) override;
+  std::chrono::steady_clock::time_point deadline() const override;
+
+  void setLongPoll(bool) override;
+  bool longPoll() const override;
+
   const std::string& url() const override;
   const std::string& method() const override;
   bool follow_redirect() const override;
@@ -137,6 +328,11 @@ class CurlHttpRequest : public IHttpRequest,
   HeaderParameters header_parameters_;
   std::string method_;
   bool follow_redirect_;
+  IHttp::Version version_;
+  Priority priority_;
+  std::vector<IThrottle::Pointer> throttles_;
+  std::chrono::steady_clock::time_point deadline_;
+  bool long_poll_;
   std::shared_ptr<CurlHttp::Worker> worker_;
 };
 
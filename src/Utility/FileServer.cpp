@@ -32,12 +32,10 @@
 namespace cloudstorage {
 
 const int CHUNK_SIZE = 8 * 1024 * 1024;
-const int CACHE_SIZE = 128;
 
 namespace {
 
 struct Buffer;
-using Cache = util::LRUCache<std::string, IItem>;
 
 class HttpServerCallback : public IHttpServer::ICallback {
  public:
@@ -45,7 +43,6 @@ class HttpServerCallback : public IHttpServer::ICallback {
   IHttpServer::IResponse::Pointer handle(const IHttpServer::IRequest&) override;
 
  private:
-  std::shared_ptr<Cache> item_cache_;
   std::shared_ptr<CloudProvider> provider_;
 };
 
@@ -93,9 +90,17 @@ class StreamRequest : public Request<EitherError<void>> {
   std::mutex mutex_;
 };
 
+/**
+ * State shared by the response and the request which fills it; callbacks of
+ * the request keep it alive, the response may be gone by then.
+ */
 struct Buffer : public std::enable_shared_from_this<Buffer> {
   using Pointer = std::shared_ptr<Buffer>;
 
+  static constexpr int InProgress = 0;
+  static constexpr int Success = 1;
+  static constexpr int Failed = 2;
+
   int read(char* buf, uint32_t max) {
     if (2 * size() < CHUNK_SIZE) {
       std::unique_lock<std::mutex> lock(delayed_mutex_);
@@ -164,6 +169,7 @@ struct Buffer : public std::enable_shared_from_this<Buffer> {
         util::make_unique<HttpDataCallback>(shared_from_this()));
   }
 
+  std::atomic_int status_{InProgress};
   std::mutex mutex_;
   std::queue<char> data_;
   std::mutex response_mutex_;
@@ -189,89 +195,82 @@ void HttpDataCallback::done(EitherError<void> e) {
 
 class HttpData : public IHttpServer::IResponse::ICallback {
  public:
-  static constexpr int InProgress = 0;
-  static constexpr int Success = 1;
-  static constexpr int Failed = 2;
-
   HttpData(Buffer::Pointer d, const std::shared_ptr<CloudProvider>& p,
-           const std::string& file, Range range,
-           const std::shared_ptr<Cache>& cache)
-      : status_(InProgress),
-        buffer_(std::move(d)),
+           const std::string& file, Range range)
+      : buffer_(std::move(d)),
         provider_(p),
-        request_(request(p, file, range, cache)) {}
+        request_(request(buffer_, p, file, range)) {}
 
   ~HttpData() override {
     buffer_->done(Error{IHttpRequest::Aborted, util::Error::ABORTED});
     provider_->removeStreamRequest(request_);
   }
 
-  std::shared_ptr<ICloudProvider::DownloadFileRequest> request(
-      std::shared_ptr<CloudProvider> provider, const std::string& file,
-      Range range, const std::shared_ptr<Cache>& cache) {
+  static std::shared_ptr<ICloudProvider::DownloadFileRequest> request(
+      const Buffer::Pointer& buffer, std::shared_ptr<CloudProvider> provider,
+      const std::string& file, Range range) {
+    auto cache = provider->metadata_cache();
     auto resolver = [=](Request<EitherError<void>>::Pointer r) {
-      buffer_->request_ = std::static_pointer_cast<StreamRequest>(r);
+      buffer->request_ = std::static_pointer_cast<StreamRequest>(r);
       auto item_received = [=](EitherError<IItem> e) {
         if (e.left()) {
-          status_ = Failed;
+          buffer->status_ = Buffer::Failed;
           util::log("[HTTP SERVER] couldn't get item", e.left()->code_,
                     e.left()->description_);
-          buffer_->done(Error{IHttpRequest::Bad, util::Error::INVALID_NODE});
+          buffer->done(Error{IHttpRequest::Bad, util::Error::INVALID_NODE});
         } else {
           if (range.start_ + range.size_ > uint64_t(e.right()->size())) {
-            status_ = Failed;
+            buffer->status_ = Buffer::Failed;
             util::log("[HTTP SERVER] invalid range", range.start_, range.size_);
-            buffer_->done(Error{IHttpRequest::Bad, util::Error::INVALID_RANGE});
+            buffer->done(Error{IHttpRequest::Bad, util::Error::INVALID_RANGE});
           } else {
-            status_ = Success;
-            buffer_->item_ = e.right();
-            buffer_->range_ = range;
-            cache->put(file, e.right());
+            buffer->status_ = Buffer::Success;
+            buffer->item_ = e.right();
+            buffer->range_ = range;
+            cache->put_item(e.right());
             r->make_subrequest(
                 &CloudProvider::downloadFileRangeAsync, e.right(),
                 Range{range.start_,
                       std::min<uint64_t>(range.size_, CHUNK_SIZE)},
-                util::make_unique<HttpDataCallback>(buffer_));
+                util::make_unique<HttpDataCallback>(buffer));
           }
         }
-        buffer_->resume();
+        buffer->resume();
       };
-      auto cached_item = cache->get(file);
+      auto cached_item = cache->item(file);
       if (cached_item == nullptr)
-        r->make_subrequest(&CloudProvider::getItemDataAsync, file,
+        r->make_subrequest(&CloudProvider::getItemDataCoalescedAsync, file,
                            item_received);
       else
         item_received(cached_item);
     };
-    auto result = std::make_shared<StreamRequest>(provider,
-                                                  [=](EitherError<void> e) {
-                                                    if (e.left())
-                                                      status_ = Failed;
-                                                    buffer_->resume();
-                                                  },
-                                                  resolver);
+    auto result = std::make_shared<StreamRequest>(
+        provider,
+        [=](EitherError<void> e) {
+          if (e.left()) buffer->status_ = Buffer::Failed;
+          buffer->resume();
+        },
+        resolver, IHttpRequest::Priority::Streaming);
     provider->addStreamRequest(result);
     return result->run();
   }
 
   int putData(char* buf, size_t max) override {
-    if (status_ == Failed)
+    if (buffer_->status_ == Buffer::Failed)
       return Abort;
-    else if (status_ == InProgress)
+    else if (buffer_->status_ == Buffer::InProgress)
       return Suspend;
     else
       return buffer_->read(buf, static_cast<uint32_t>(max));
   }
 
-  std::atomic_int status_;
   Buffer::Pointer buffer_;
   std::shared_ptr<CloudProvider> provider_;
   std::shared_ptr<ICloudProvider::DownloadFileRequest> request_;
 };
 
 HttpServerCallback::HttpServerCallback(std::shared_ptr<CloudProvider> p)
-    : item_cache_(util::make_unique<Cache>(CACHE_SIZE)),
-      provider_(std::move(p)) {}
+    : provider_(std::move(p)) {}
 
 IHttpServer::IResponse::Pointer HttpServerCallback::handle(
     const IHttpServer::IRequest& request) {
@@ -311,8 +310,7 @@ IHttpServer::IResponse::Pointer HttpServerCallback::handle(
       code = IHttpRequest::Partial;
     }
     auto buffer = std::make_shared<Buffer>();
-    auto data =
-        util::make_unique<HttpData>(buffer, provider_, id, range, item_cache_);
+    auto data = util::make_unique<HttpData>(buffer, provider_, id, range);
     auto response =
         request.response(code, headers, range.size_, std::move(data));
     buffer->response_ = response.get();
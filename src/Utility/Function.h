@@ -0,0 +1,224 @@
+/*****************************************************************************
+ * Function.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef FUNCTION_H
+#define FUNCTION_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cloudstorage {
+namespace util {
+
+template <class Signature, size_t Size = 6 * sizeof(void*)>
+class Function;
+
+/**
+ * Copyable type-erased callable, same as std::function, but callables of up
+ * to Size bytes are kept inline instead of on the heap. That's enough for
+ * lambdas capturing a few shared pointers, which is what requests pass
+ * around; std::function would allocate for each of them.
+ */
+template <class R, class... Args, size_t Size>
+class Function<R(Args...), Size> {
+  template <class...>
+  struct Void {
+    using type = void;
+  };
+
+  template <class F, class = void>
+  struct Callable : std::false_type {};
+
+  template <class F>
+  struct Callable<F, typename Void<decltype(std::declval<F&>()(
+                         std::declval<Args>()...))>::type>
+      : std::integral_constant<
+            bool, std::is_void<R>::value ||
+                      std::is_convertible<decltype(std::declval<F&>()(
+                                              std::declval<Args>()...)),
+                                          R>::value> {};
+
+  template <class F>
+  using EnableIfCallable = typename std::enable_if<
+      !std::is_same<typename std::decay<F>::type, Function>::value &&
+      Callable<typename std::decay<F>::type>::value>::type;
+
+ public:
+  Function() noexcept : ops_() {}
+  Function(std::nullptr_t) noexcept : ops_() {}
+
+  template <class F, class = EnableIfCallable<F>>
+  Function(F&& f) : ops_() {
+    if (!null(f))
+      construct(std::forward<F>(f), Inline<typename std::decay<F>::type>());
+  }
+
+  Function(const Function& f) : ops_() {
+    if (f.ops_) f.ops_->copy(&f.storage_, &storage_);
+    ops_ = f.ops_;
+  }
+
+  Function(Function&& f) noexcept : ops_(f.ops_) {
+    if (ops_) ops_->move(&f.storage_, &storage_);
+    f.ops_ = nullptr;
+  }
+
+  ~Function() { reset(); }
+
+  Function& operator=(const Function& f) {
+    if (this != &f) *this = Function(f);
+    return *this;
+  }
+
+  Function& operator=(Function&& f) noexcept {
+    if (this != &f) {
+      reset();
+      if (f.ops_) f.ops_->move(&f.storage_, &storage_);
+      ops_ = f.ops_;
+      f.ops_ = nullptr;
+    }
+    return *this;
+  }
+
+  Function& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  R operator()(Args... args) const {
+    if (!ops_) throw std::bad_function_call();
+    return ops_->call(&storage_, std::forward<Args>(args)...);
+  }
+
+ private:
+  using Storage =
+      typename std::aligned_storage<Size, alignof(std::max_align_t)>::type;
+
+  struct Ops {
+    R (*call)(const Storage*, Args&&...);
+    void (*copy)(const Storage*, Storage*);
+    void (*move)(Storage*, Storage*);
+    void (*destroy)(Storage*);
+  };
+
+  template <class F>
+  using Inline = std::integral_constant<
+      bool, sizeof(F) <= Size && alignof(F) <= alignof(Storage) &&
+                std::is_nothrow_move_constructible<F>::value>;
+
+  template <class F>
+  struct InlineOps {
+    static F* get(const Storage* s) {
+      return const_cast<F*>(reinterpret_cast<const F*>(s));
+    }
+    static R call(const Storage* s, Args&&... args) {
+      return (*get(s))(std::forward<Args>(args)...);
+    }
+    static void copy(const Storage* s, Storage* d) { new (d) F(*get(s)); }
+    static void move(Storage* s, Storage* d) {
+      new (d) F(std::move(*get(s)));
+      get(s)->~F();
+    }
+    static void destroy(Storage* s) { get(s)->~F(); }
+    static constexpr Ops ops = {call, copy, move, destroy};
+  };
+
+  template <class F>
+  struct HeapOps {
+    static F* get(const Storage* s) {
+      return *reinterpret_cast<F* const*>(s);
+    }
+    static R call(const Storage* s, Args&&... args) {
+      return (*get(s))(std::forward<Args>(args)...);
+    }
+    static void copy(const Storage* s, Storage* d) {
+      *reinterpret_cast<F**>(d) = new F(*get(s));
+    }
+    static void move(Storage* s, Storage* d) {
+      *reinterpret_cast<F**>(d) = get(s);
+    }
+    static void destroy(Storage* s) { delete get(s); }
+    static constexpr Ops ops = {call, copy, move, destroy};
+  };
+
+  template <class F>
+  static bool null(const F&) {
+    return false;
+  }
+
+  template <class Signature>
+  static bool null(const std::function<Signature>& f) {
+    return !f;
+  }
+
+  template <class Signature, size_t OtherSize>
+  static bool null(const Function<Signature, OtherSize>& f) {
+    return !f;
+  }
+
+  template <class T>
+  static bool null(T* f) {
+    return !f;
+  }
+
+  template <class F>
+  void construct(F&& f, std::true_type) {
+    using Type = typename std::decay<F>::type;
+    new (&storage_) Type(std::forward<F>(f));
+    ops_ = &InlineOps<Type>::ops;
+  }
+
+  template <class F>
+  void construct(F&& f, std::false_type) {
+    using Type = typename std::decay<F>::type;
+    *reinterpret_cast<Type**>(&storage_) = new Type(std::forward<F>(f));
+    ops_ = &HeapOps<Type>::ops;
+  }
+
+  void reset() noexcept {
+    if (ops_) ops_->destroy(&storage_);
+    ops_ = nullptr;
+  }
+
+  Storage storage_;
+  const Ops* ops_;
+};
+
+template <class R, class... Args, size_t Size>
+template <class F>
+constexpr typename Function<R(Args...), Size>::Ops
+    Function<R(Args...), Size>::template InlineOps<F>::ops;
+
+template <class R, class... Args, size_t Size>
+template <class F>
+constexpr typename Function<R(Args...), Size>::Ops
+    Function<R(Args...), Size>::template HeapOps<F>::ops;
+
+}  // namespace util
+}  // namespace cloudstorage
+
+#endif  // FUNCTION_H
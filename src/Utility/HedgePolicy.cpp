@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * HedgePolicy.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "HedgePolicy.h"
+
+#include <algorithm>
+
+const size_t MAX_SAMPLES = 256;
+const size_t MIN_SAMPLES = 16;
+const double DEFAULT_BUDGET = 0.05;
+const double MAX_TOKENS = 10;
+
+namespace cloudstorage {
+
+HedgePolicy::HedgePolicy()
+    : percentile_(), budget_(DEFAULT_BUDGET), tokens_(), next_sample_() {}
+
+void HedgePolicy::set_percentile(double percentile) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  percentile_ = std::min(std::max(percentile, 0.0), 100.0);
+}
+
+void HedgePolicy::set_budget(double budget) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  budget_ = std::min(std::max(budget, 0.0), 1.0);
+}
+
+bool HedgePolicy::enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return percentile_ > 0 && budget_ > 0;
+}
+
+std::chrono::microseconds HedgePolicy::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tokens_ = std::min(tokens_ + budget_, MAX_TOKENS);
+  if (samples_.size() < MIN_SAMPLES) return std::chrono::microseconds::max();
+  auto samples = samples_;
+  auto nth = samples.begin() +
+             std::min<size_t>(samples.size() * percentile_ / 100,
+                              samples.size() - 1);
+  std::nth_element(samples.begin(), nth, samples.end());
+  return std::chrono::microseconds(*nth);
+}
+
+bool HedgePolicy::hedge() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tokens_ < 1) return false;
+  tokens_ -= 1;
+  return true;
+}
+
+void HedgePolicy::record(std::chrono::microseconds latency) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (samples_.size() < MAX_SAMPLES) {
+    samples_.push_back(latency.count());
+  } else {
+    samples_[next_sample_] = latency.count();
+    next_sample_ = (next_sample_ + 1) % MAX_SAMPLES;
+  }
+}
+
+}  // namespace cloudstorage
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * HedgePolicy.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HEDGEPOLICY_H
+#define HEDGEPOLICY_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace cloudstorage {
+
+/**
+ * Decides when an idempotent request which didn't answer yet should be sent
+ * once more: after given percentile of recently observed latency. Hedges are
+ * paid from a budget which grows by a fixed share of every request, so they
+ * can't exceed that share of the traffic. Disabled until percentile is set.
+ */
+class HedgePolicy {
+ public:
+  HedgePolicy();
+
+  /**
+   * @param percentile from 0 to 100, 0 disables hedging
+   */
+  void set_percentile(double percentile);
+
+  /**
+   * @param budget share of requests which may be hedged, from 0 to 1
+   */
+  void set_budget(double budget);
+
+  bool enabled() const;
+
+  /**
+   * Called for every request which may be hedged.
+   *
+   * @return how long to wait for the response before hedging, duration::max
+   * if there isn't enough samples yet
+   */
+  std::chrono::microseconds start();
+
+  /**
+   * @return whether the budget allows sending a hedge now; if it does, the
+   * hedge is taken from it
+   */
+  bool hedge();
+
+  /**
+   * Adds latency of a request which got a response to the samples.
+   */
+  void record(std::chrono::microseconds latency);
+
+ private:
+  mutable std::mutex mutex_;
+  double percentile_;
+  double budget_;
+  double tokens_;
+  std::vector<int64_t> samples_;
+  size_t next_sample_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // HEDGEPOLICY_H
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * ItemOperations.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef ITEMOPERATIONS_H
+#define ITEMOPERATIONS_H
+
+#include "Coroutine.h"
+
+#ifdef UTIL_HAS_COROUTINES
+
+#include <sstream>
+
+#include "ICloudAccess.h"
+
+namespace cloudstorage {
+
+/**
+ * Copies item into parent directory of destination, which may be a different
+ * cloud. Directories are copied recursively, files are buffered in memory.
+ *
+ * @return copied item
+ */
+inline util::Task<IItem::Pointer> copyItem(ICloudAccess& source,
+                                           IItem::Pointer item,
+                                           ICloudAccess& destination,
+                                           IItem::Pointer parent) {
+  if (item->type() == IItem::FileType::Directory) {
+    auto directory =
+        co_await destination.createDirectory(parent, item->filename());
+    for (const auto& child : co_await source.listDirectory(item))
+      co_await copyItem(source, child, destination, directory);
+    co_return directory;
+  }
+  auto buffer = std::make_shared<std::stringstream>();
+  co_await source.downloadFile(item, FullRange,
+                               ICloudAccess::streamDownloader(buffer));
+  co_return co_await destination.uploadFile(
+      parent, item->filename(), ICloudAccess::streamUploader(buffer));
+}
+
+/**
+ * Moves item into parent directory of destination; across clouds it's copied
+ * and then removed from source.
+ *
+ * @return moved item
+ */
+inline util::Task<IItem::Pointer> moveItem(ICloudAccess& source,
+                                           IItem::Pointer item,
+                                           ICloudAccess& destination,
+                                           IItem::Pointer parent) {
+  if (&source == &destination)
+    co_return co_await source.moveItem(item, parent);
+  auto result = co_await copyItem(source, item, destination, parent);
+  co_await source.deleteItem(item);
+  co_return result;
+}
+
+}  // namespace cloudstorage
+
+#endif  // UTIL_HAS_COROUTINES
+
+#endif  // ITEMOPERATIONS_H
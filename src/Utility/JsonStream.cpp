@@ -0,0 +1,177 @@
+/*****************************************************************************
+ * JsonStream.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "JsonStream.h"
+
+#include <cctype>
+#include <stdexcept>
+
+#include "Utility.h"
+
+namespace cloudstorage {
+namespace util {
+
+JsonBuffer::JsonBuffer(std::vector<std::string> path, ElementCallback callback)
+    : path_(std::move(path)),
+      callback_(std::move(callback)),
+      reader_(Json::CharReaderBuilder().newCharReader()),
+      target_(0),
+      done_(false),
+      in_string_(false),
+      in_key_(false),
+      escape_(false) {}
+
+void JsonBuffer::write(const char* data, size_t size) {
+  size_t i = 0;
+  while (i < size && error_.empty()) {
+    if (in_string_ && !in_key_ && !escape_) {
+      size_t end = i;
+      while (end < size && data[end] != '"' && data[end] != '\\') end++;
+      destination().append(data + i, end - i);
+      if ((i = end) == size) break;
+    }
+    consume(data[i++]);
+  }
+}
+
+Json::Value JsonBuffer::finish() {
+  if (!error_.empty()) throw std::logic_error(error_);
+  if (in_string_ || !stack_.empty())
+    throw std::logic_error(Error::INVALID_JSON);
+  return json::from_string(rest_);
+}
+
+JsonBuffer::int_type JsonBuffer::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+    consume(traits_type::to_char_type(c));
+  return traits_type::not_eof(c);
+}
+
+std::streamsize JsonBuffer::xsputn(const char* data, std::streamsize size) {
+  write(data, static_cast<size_t>(size));
+  return size;
+}
+
+void JsonBuffer::consume(char c) {
+  if (in_string_) {
+    if (escape_)
+      escape_ = false;
+    else if (c == '\\')
+      escape_ = true;
+    else if (c == '"')
+      in_string_ = false;
+    if (in_string_ && in_key_) stack_.back().key_ += c;
+    return sink(c);
+  }
+  switch (c) {
+    case '"':
+      in_string_ = true;
+      in_key_ = !stack_.empty() && stack_.back().expect_key_;
+      if (in_key_) stack_.back().key_.clear();
+      break;
+    case '{':
+      stack_.push_back({false, true, {}});
+      break;
+    case '[':
+      if (target_ == 0 && !done_ && matches()) {
+        stack_.push_back({true, false, {}});
+        target_ = stack_.size();
+        rest_ += c;
+        return;
+      }
+      stack_.push_back({true, false, {}});
+      break;
+    case '}':
+    case ']':
+      if (stack_.empty() || stack_.back().array_ != (c == ']')) {
+        error_ = Error::INVALID_JSON;
+        return;
+      }
+      if (target_ == stack_.size()) {
+        flush();
+        stack_.pop_back();
+        target_ = 0;
+        done_ = true;
+        rest_ += c;
+        return;
+      }
+      stack_.pop_back();
+      break;
+    case ',':
+      if (target_ != 0 && target_ == stack_.size()) return flush();
+      if (!stack_.empty() && !stack_.back().array_)
+        stack_.back().expect_key_ = true;
+      break;
+    case ':':
+      if (!stack_.empty()) stack_.back().expect_key_ = false;
+      break;
+  }
+  sink(c);
+}
+
+void JsonBuffer::sink(char c) { destination() += c; }
+
+std::string& JsonBuffer::destination() {
+  return target_ != 0 && stack_.size() >= target_ ? element_ : rest_;
+}
+
+bool JsonBuffer::matches() const {
+  if (stack_.size() != path_.size()) return false;
+  for (size_t i = 0; i < path_.size(); i++)
+    if (stack_[i].array_ || stack_[i].key_ != path_[i]) return false;
+  return true;
+}
+
+void JsonBuffer::flush() {
+  bool empty = true;
+  for (char c : element_)
+    if (!std::isspace(static_cast<unsigned char>(c))) {
+      empty = false;
+      break;
+    }
+  if (!empty) {
+    Json::Value json;
+    std::string error;
+    if (!reader_->parse(element_.data(), element_.data() + element_.size(),
+                        &json, &error))
+      error_ = error;
+    else
+      try {
+        callback_(json);
+      } catch (const std::exception& e) {
+        error_ = e.what();
+      }
+  }
+  element_.clear();
+}
+
+JsonStream::JsonStream(std::vector<std::string> path,
+                       JsonBuffer::ElementCallback callback)
+    : std::ostream(nullptr), buffer_(std::move(path), std::move(callback)) {
+  init(&buffer_);
+}
+
+JsonBuffer* JsonStream::rdbuf() { return &buffer_; }
+
+}  // namespace util
+}  // namespace cloudstorage
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * JsonStream.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef JSONSTREAM_H
+#define JSONSTREAM_H
+
+#include <json/json.h>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace cloudstorage {
+namespace util {
+
+/**
+ * Incremental json parser meant to be written to while the response is being
+ * received. Elements of the array found under given key path are parsed one
+ * at a time and handed to the callback as soon as they are complete; the rest
+ * of the document is kept, with that array left empty, and parsed by finish.
+ */
+class JsonBuffer : public std::streambuf {
+ public:
+  using ElementCallback = std::function<void(const Json::Value&)>;
+
+  /**
+   * @param path keys of the objects leading to the array, e.g. {"_embedded",
+   * "items"}; empty path means that the document itself is the array
+   *
+   * @param callback called for each element of the array
+   */
+  JsonBuffer(std::vector<std::string> path, ElementCallback callback);
+
+  JsonBuffer(const JsonBuffer&) = delete;
+  JsonBuffer& operator=(const JsonBuffer&) = delete;
+
+  void write(const char* data, size_t size);
+
+  /**
+   * Throws if the document was malformed or the callback threw.
+   *
+   * @return document without elements of the array
+   */
+  Json::Value finish();
+
+ protected:
+  int_type overflow(int_type) override;
+  std::streamsize xsputn(const char*, std::streamsize) override;
+
+ private:
+  struct Frame {
+    bool array_;
+    bool expect_key_;
+    std::string key_;
+  };
+
+  void consume(char);
+  void sink(char);
+  std::string& destination();
+  bool matches() const;
+  void flush();
+
+  std::vector<std::string> path_;
+  ElementCallback callback_;
+  std::unique_ptr<Json::CharReader> reader_;
+  std::vector<Frame> stack_;
+  size_t target_;
+  bool done_;
+  bool in_string_;
+  bool in_key_;
+  bool escape_;
+  std::string element_;
+  std::string rest_;
+  std::string error_;
+};
+
+/**
+ * Stream writing into JsonBuffer.
+ */
+class JsonStream : public std::ostream {
+ public:
+  JsonStream(std::vector<std::string> path,
+             JsonBuffer::ElementCallback callback);
+
+  JsonBuffer* rdbuf();
+
+ private:
+  JsonBuffer buffer_;
+};
+
+}  // namespace util
+}  // namespace cloudstorage
+
+#endif  // JSONSTREAM_H
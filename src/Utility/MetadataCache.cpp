@@ -0,0 +1,359 @@
+/*****************************************************************************
+ * MetadataCache.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "MetadataCache.h"
+
+#include "Utility/Item.h"
+
+namespace cloudstorage {
+
+namespace {
+
+// Rough count of bytes taken by an item, strings are counted by length.
+size_t item_size(const IItem& item) {
+  return sizeof(Item) + item.filename().size() + item.id().size();
+}
+
+std::string item_key(const std::string& id) { return "i" + id; }
+
+std::string directory_prefix(const std::string& id) {
+  return "d" + std::to_string(id.size()) + ":" + id;
+}
+
+std::string page_key(const std::string& id, const std::string& token) {
+  return directory_prefix(id) + "p" + token;
+}
+
+std::string listing_key(const std::string& id) {
+  return directory_prefix(id) + "l";
+}
+
+std::string children_key(const std::string& id) {
+  return directory_prefix(id) + "c";
+}
+
+std::string url_key(const std::string& id) { return "u" + id; }
+
+std::string path_key(const std::string& path) { return "p" + path; }
+
+}  // namespace
+
+MetadataCache::MetadataCache(Options options, MetadataStore::Pointer store)
+    : options_(options), store_(std::move(store)), memory_usage_() {}
+
+bool MetadataCache::enabled() const {
+  return store_ || options_.item_ttl_ != Clock::duration::zero() ||
+         options_.directory_ttl_ != Clock::duration::zero() ||
+         options_.url_ttl_ != Clock::duration::zero() ||
+         options_.path_ttl_ != Clock::duration::zero() ||
+         options_.path_index_ttl_ != Clock::duration::zero();
+}
+
+size_t MetadataCache::memory_usage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return memory_usage_;
+}
+
+IItem::Pointer MetadataCache::item(const std::string& id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = find(item_key(id));
+  return entry ? entry->item_ : nullptr;
+}
+
+void MetadataCache::put_item(const IItem::Pointer& item) {
+  Entry entry = {};
+  entry.kind_ = Kind::Item;
+  entry.size_ = item_size(*item);
+  entry.item_ = item;
+  if (store_) store_->put_item(*item);
+  std::lock_guard<std::mutex> lock(mutex_);
+  put(item_key(item->id()), std::move(entry));
+}
+
+bool MetadataCache::page(const IItem& directory, const std::string& token,
+                         PageData& result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = find(page_key(directory.id(), token));
+  if (!entry) return false;
+  result = {entry->items_, entry->text_};
+  return true;
+}
+
+void MetadataCache::put_page(const IItem& directory, const std::string& token,
+                             const PageData& page) {
+  Entry entry = {};
+  entry.kind_ = Kind::Directory;
+  entry.size_ = page.next_token_.size();
+  for (const auto& item : page.items_)
+    entry.size_ += item_size(*item);
+  entry.items_ = page.items_;
+  entry.text_ = page.next_token_;
+  entry.directory_ = directory.id();
+  if (store_)
+    for (const auto& item : page.items_)
+      store_->put_item(*item, directory.id());
+  std::lock_guard<std::mutex> lock(mutex_);
+  put(page_key(directory.id(), token), std::move(entry));
+}
+
+bool MetadataCache::listing(const IItem& directory, IItem::List& result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = find(listing_key(directory.id()));
+  if (!entry) return false;
+  result = entry->items_;
+  return true;
+}
+
+void MetadataCache::put_listing(const IItem::Pointer& directory,
+                                const IItem::List& items) {
+  Entry entry = {};
+  entry.kind_ = Kind::Directory;
+  entry.size_ = item_size(*directory);
+  for (const auto& item : items)
+    entry.size_ += item_size(*item);
+  entry.item_ = directory;
+  entry.items_ = items;
+  entry.directory_ = directory->id();
+  auto children = this->children(*directory, items);
+  if (store_) store_->put_listing(directory->id(), items);
+  std::lock_guard<std::mutex> lock(mutex_);
+  put(listing_key(directory->id()), std::move(entry));
+  put(children_key(directory->id()), std::move(children));
+}
+
+std::vector<std::pair<IItem::Pointer, IItem::List>> MetadataCache::listings() {
+  std::vector<std::pair<IItem::Pointer, IItem::List>> result;
+  auto now = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& d : entries_) {
+    const auto& entry = d.second;
+    if (entry.kind_ == Kind::Directory && entry.item_ && entry.expires_ > now)
+      result.push_back({entry.item_, entry.items_});
+  }
+  return result;
+}
+
+std::unordered_set<std::string> MetadataCache::directories(
+    const std::string& id) {
+  std::unordered_set<std::string> result;
+  auto now = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = parents_.find(id);
+  if (it == parents_.end()) return result;
+  for (const auto& directory : it->second) {
+    auto entry = entries_.find(listing_key(directory));
+    if (entry != entries_.end() && entry->second.expires_ > now)
+      result.insert(directory);
+  }
+  return result;
+}
+
+bool MetadataCache::child(const IItem& directory, const std::string& name,
+                          IItem::Pointer& result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = find(children_key(directory.id()));
+  if (!entry) return false;
+  auto it = entry->children_.find(name);
+  result = it == entry->children_.end() ? nullptr : it->second;
+  return true;
+}
+
+void MetadataCache::put_children(const IItem& directory,
+                                 const IItem::List& items) {
+  auto entry = children(directory, items);
+  std::lock_guard<std::mutex> lock(mutex_);
+  put(children_key(directory.id()), std::move(entry));
+}
+
+bool MetadataCache::url(const IItem& item, std::string& result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = find(url_key(item.id()));
+  if (!entry) return false;
+  result = entry->text_;
+  return true;
+}
+
+void MetadataCache::put_url(const IItem& item, const std::string& url) {
+  Entry entry = {};
+  entry.kind_ = Kind::Url;
+  entry.size_ = url.size();
+  entry.text_ = url;
+  std::lock_guard<std::mutex> lock(mutex_);
+  put(url_key(item.id()), std::move(entry));
+}
+
+IItem::Pointer MetadataCache::path(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = find(path_key(path));
+  return entry ? entry->item_ : nullptr;
+}
+
+void MetadataCache::put_path(const std::string& path,
+                             const IItem::Pointer& item) {
+  Entry entry = {};
+  entry.kind_ = Kind::Path;
+  entry.size_ = item_size(*item);
+  entry.item_ = item;
+  std::lock_guard<std::mutex> lock(mutex_);
+  put(path_key(path), std::move(entry));
+}
+
+IItem::Pointer MetadataCache::stored_item(const std::string& id) {
+  return store_ ? store_->item(id) : nullptr;
+}
+
+bool MetadataCache::stored_listing(const IItem& directory,
+                                   IItem::List& result) {
+  return store_ && store_->listing(directory.id(), result);
+}
+
+void MetadataCache::invalidate_directory(const std::string& id) {
+  if (store_) store_->remove_listing(id);
+  std::lock_guard<std::mutex> lock(mutex_);
+  invalidate(id);
+}
+
+void MetadataCache::remove(const IItem& item) {
+  auto id = item.id();
+  auto i = dynamic_cast<const Item*>(&item);
+  if (store_) {
+    store_->remove_item(id);
+    if (i)
+      for (const auto& directory : i->parents())
+        store_->remove_listing(directory);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& key : {item_key(id), url_key(id)}) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) erase(it);
+  }
+  invalidate(id);
+  auto parents = parents_.find(id);
+  if (parents != parents_.end()) {
+    auto directories = parents->second;
+    for (const auto& directory : directories) invalidate(directory);
+  }
+  if (i)
+    for (const auto& directory : i->parents()) invalidate(directory);
+  auto it = entries_.lower_bound(path_key(""));
+  while (it != entries_.end() && it->second.kind_ == Kind::Path)
+    erase(it++);
+}
+
+void MetadataCache::apply(const Change& change) {
+  remove(*change.item_);
+  if (change.type_ == Change::Type::Delete)
+    invalidate_directory(change.item_->id());
+  for (const auto& directory : change.parents_)
+    invalidate_directory(directory);
+  if (change.type_ != Change::Type::Delete) put_item(change.item_);
+}
+
+void MetadataCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  usage_.clear();
+  parents_.clear();
+  memory_usage_ = 0;
+}
+
+MetadataCache::Clock::duration MetadataCache::ttl(Kind kind) const {
+  switch (kind) {
+    case Kind::Item:
+      return options_.item_ttl_;
+    case Kind::Directory:
+      return options_.directory_ttl_;
+    case Kind::Children:
+      return options_.path_index_ttl_;
+    case Kind::Url:
+      return options_.url_ttl_;
+    default:
+      return options_.path_ttl_;
+  }
+}
+
+MetadataCache::Entry MetadataCache::children(const IItem& directory,
+                                             const IItem::List& items) const {
+  Entry entry = {};
+  entry.kind_ = Kind::Children;
+  if (ttl(Kind::Children) == Clock::duration::zero()) return entry;
+  for (const auto& item : items) {
+    auto name = item->filename();
+    entry.size_ += item_size(*item) + name.size() + 4 * sizeof(void*);
+    entry.children_.emplace(std::move(name), item);
+  }
+  entry.items_ = items;
+  entry.directory_ = directory.id();
+  return entry;
+}
+
+MetadataCache::Entry* MetadataCache::find(const std::string& key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return nullptr;
+  if (it->second.expires_ <= Clock::now()) {
+    erase(it);
+    return nullptr;
+  }
+  usage_.splice(usage_.begin(), usage_, it->second.usage_);
+  return &it->second;
+}
+
+void MetadataCache::put(const std::string& key, Entry&& entry) {
+  auto ttl = this->ttl(entry.kind_);
+  if (ttl == Clock::duration::zero()) return;
+  auto it = entries_.find(key);
+  if (it != entries_.end()) erase(it);
+  entry.expires_ = Clock::now() + ttl;
+  entry.size_ += sizeof(Entry) + 2 * key.size();
+  if (entry.size_ > options_.memory_budget_) return;
+  for (const auto& item : entry.items_)
+    parents_[item->id()].insert(entry.directory_);
+  usage_.push_front(key);
+  entry.usage_ = usage_.begin();
+  memory_usage_ += entry.size_;
+  entries_.emplace(key, std::move(entry));
+  while (memory_usage_ > options_.memory_budget_)
+    erase(entries_.find(usage_.back()));
+}
+
+void MetadataCache::erase(std::map<std::string, Entry>::iterator it) {
+  const auto& entry = it->second;
+  for (const auto& item : entry.items_) {
+    auto parents = parents_.find(item->id());
+    if (parents == parents_.end()) continue;
+    parents->second.erase(entry.directory_);
+    if (parents->second.empty()) parents_.erase(parents);
+  }
+  memory_usage_ -= entry.size_;
+  usage_.erase(entry.usage_);
+  entries_.erase(it);
+}
+
+void MetadataCache::invalidate(const std::string& directory) {
+  auto prefix = directory_prefix(directory);
+  auto it = entries_.lower_bound(prefix);
+  while (it != entries_.end() &&
+         it->first.compare(0, prefix.size(), prefix) == 0)
+    erase(it++);
+}
+
+}  // namespace cloudstorage
@@ -0,0 +1,177 @@
+/*****************************************************************************
+ * MetadataCache.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "IItem.h"
+#include "IRequest.h"
+#include "Utility/MetadataStore.h"
+
+namespace cloudstorage {
+
+/**
+ * Metadata shared by everything using a provider: items by id, pages and whole
+ * listings of directories, children of directories by name, item urls and
+ * items by path. Each kind of entry
+ * expires after its own ttl, zero ttl disables caching it; least recently used
+ * entries are evicted when all of them take more memory than the budget.
+ *
+ * Directory listings remember which items they contain, so that mutations can
+ * drop every listing they affect.
+ *
+ * Items and listings are also written to the store, if there is one; they
+ * outlive the process and don't expire, stored_item and stored_listing return
+ * them as last seen.
+ */
+class MetadataCache {
+ public:
+  using Pointer = std::shared_ptr<MetadataCache>;
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    Clock::duration item_ttl_ = Clock::duration::zero();
+    Clock::duration directory_ttl_ = Clock::duration::zero();
+    Clock::duration url_ttl_ = Clock::duration::zero();
+    Clock::duration path_ttl_ = Clock::duration::zero();
+    Clock::duration path_index_ttl_ = Clock::duration::zero();
+    size_t memory_budget_ = 4 << 20;
+  };
+
+  MetadataCache(Options, MetadataStore::Pointer = nullptr);
+
+  /**
+   * @return whether any kind of entry is cached or there is a store
+   */
+  bool enabled() const;
+
+  /**
+   * @return approximate amount of memory taken by the entries, in bytes
+   */
+  size_t memory_usage() const;
+
+  IItem::Pointer item(const std::string& id);
+  void put_item(const IItem::Pointer&);
+
+  bool page(const IItem& directory, const std::string& token, PageData&);
+  void put_page(const IItem& directory, const std::string& token,
+                const PageData&);
+
+  bool listing(const IItem& directory, IItem::List&);
+  void put_listing(const IItem::Pointer& directory, const IItem::List&);
+
+  /**
+   * @return directories with listings in memory, together with the listings
+   */
+  std::vector<std::pair<IItem::Pointer, IItem::List>> listings();
+
+  /**
+   * @return ids of directories with listings in memory which contain the item
+   */
+  std::unordered_set<std::string> directories(const std::string& id);
+
+  /**
+   * Looks up a child of the directory by name, used to resolve paths.
+   *
+   * @return whether children of the directory are known; if they are, result
+   * is the first child with that name or nullptr if there is none
+   */
+  bool child(const IItem& directory, const std::string& name,
+             IItem::Pointer& result);
+  void put_children(const IItem& directory, const IItem::List&);
+
+  bool url(const IItem&, std::string&);
+  void put_url(const IItem&, const std::string&);
+
+  IItem::Pointer path(const std::string& path);
+  void put_path(const std::string& path, const IItem::Pointer&);
+
+  IItem::Pointer stored_item(const std::string& id);
+  bool stored_listing(const IItem& directory, IItem::List&);
+
+  /**
+   * Drops pages and listing of the directory.
+   */
+  void invalidate_directory(const std::string& id);
+
+  /**
+   * Drops everything known about the item: its entries, listings of
+   * directories containing it and, as paths of its descendants may change
+   * too, all paths.
+   */
+  void remove(const IItem&);
+
+  /**
+   * Drops what the change made stale: entries of the item, listings which
+   * contained it or will contain it; then remembers item's new state.
+   */
+  void apply(const Change&);
+
+  /**
+   * Drops entries kept in memory, the store is left intact.
+   */
+  void clear();
+
+ private:
+  enum class Kind { Item, Directory, Children, Url, Path };
+
+  struct Entry {
+    Kind kind_;
+    Clock::time_point expires_;
+    size_t size_;
+    IItem::Pointer item_;
+    IItem::List items_;
+    std::unordered_map<std::string, IItem::Pointer> children_;
+    std::string text_;
+    std::string directory_;
+    std::list<std::string>::iterator usage_;
+  };
+
+  Clock::duration ttl(Kind) const;
+  Entry children(const IItem& directory, const IItem::List&) const;
+  Entry* find(const std::string& key);
+  void put(const std::string& key, Entry&&);
+  void erase(std::map<std::string, Entry>::iterator);
+  void invalidate(const std::string& directory);
+
+  Options options_;
+  MetadataStore::Pointer store_;
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> entries_;
+  std::list<std::string> usage_;
+  std::unordered_map<std::string, std::unordered_set<std::string>> parents_;
+  size_t memory_usage_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // METADATACACHE_H
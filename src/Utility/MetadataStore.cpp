@@ -0,0 +1,569 @@
+/*****************************************************************************
+ * MetadataStore.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "MetadataStore.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Utility/Item.h"
+
+namespace cloudstorage {
+
+namespace {
+
+const char LOG_MAGIC[8] = {'C', 'S', 'M', 'D', 'L', 'O', 'G', '1'};
+const char INDEX_MAGIC[8] = {'C', 'S', 'M', 'D', 'I', 'D', 'X', '1'};
+const size_t INDEX_HEADER_SIZE = sizeof(INDEX_MAGIC) + 2 * sizeof(uint64_t);
+const size_t INDEX_ENTRY_SIZE = 2 * sizeof(uint64_t);
+const size_t PENDING_LIMIT = 1 << 16;
+const size_t MIN_COMPACTED_SIZE = 1 << 10;
+
+uint64_t hash(const std::string& key) {
+  uint64_t result = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    result ^= c;
+    result *= 1099511628211ULL;
+  }
+  return result;
+}
+
+std::string item_key(const std::string& id) { return "i" + id; }
+
+std::string listing_key(const std::string& id) { return "l" + id; }
+
+template <class T>
+void put(std::string& output, T value) {
+  output.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put(std::string& output, const std::string& value) {
+  put(output, static_cast<uint32_t>(value.size()));
+  output += value;
+}
+
+class Reader {
+ public:
+  Reader(const char* data, size_t size) : data_(data), end_(data + size) {}
+
+  template <class T>
+  bool get(T& value) {
+    if (static_cast<size_t>(end_ - data_) < sizeof(T)) return false;
+    memcpy(&value, data_, sizeof(T));
+    data_ += sizeof(T);
+    return true;
+  }
+
+  bool get(std::string& value) {
+    uint32_t size;
+    if (!get(size) || static_cast<size_t>(end_ - data_) < size) return false;
+    value.assign(data_, size);
+    data_ += size;
+    return true;
+  }
+
+ private:
+  const char* data_;
+  const char* end_;
+};
+
+std::string encode_item(const IItem& item, const std::string& directory) {
+  auto i = dynamic_cast<const Item*>(&item);
+  std::string result;
+  put(result, item.filename());
+  put(result, item.id());
+  put(result, static_cast<uint64_t>(item.size()));
+  put(result, static_cast<int64_t>(
+                  std::chrono::duration_cast<std::chrono::milliseconds>(
+                      item.timestamp().time_since_epoch())
+                      .count()));
+  put(result, static_cast<uint8_t>(item.type()));
+  put(result, static_cast<uint8_t>(item.is_hidden()));
+  put(result, i ? i->mime_type() : std::string());
+  put(result, i ? i->url() : std::string());
+  put(result, i ? i->thumbnail_url() : std::string());
+  put(result, directory);
+  auto parents = i ? i->parents() : std::vector<std::string>();
+  put(result, static_cast<uint32_t>(parents.size()));
+  for (const auto& parent : parents) put(result, parent);
+  return result;
+}
+
+IItem::Pointer decode_item(const std::string& value,
+                           std::string* directory = nullptr) {
+  Reader reader(value.data(), value.size());
+  std::string filename, id, mime_type, url, thumbnail_url, parent_directory;
+  uint64_t size;
+  int64_t timestamp;
+  uint8_t type, hidden;
+  uint32_t parent_count;
+  if (!reader.get(filename) || !reader.get(id) || !reader.get(size) ||
+      !reader.get(timestamp) || !reader.get(type) || !reader.get(hidden) ||
+      !reader.get(mime_type) || !reader.get(url) ||
+      !reader.get(thumbnail_url) || !reader.get(parent_directory) ||
+      !reader.get(parent_count) ||
+      type > static_cast<uint8_t>(IItem::FileType::Unknown))
+    return nullptr;
+  std::vector<std::string> parents(parent_count);
+  for (auto& parent : parents)
+    if (!reader.get(parent)) return nullptr;
+  auto item = std::make_shared<Item>(
+      filename, id, size,
+      IItem::TimeStamp(std::chrono::milliseconds(timestamp)),
+      static_cast<IItem::FileType>(type));
+  item->set_hidden(hidden);
+  item->set_mime_type(mime_type);
+  item->set_url(url);
+  item->set_thumbnail_url(thumbnail_url);
+  item->set_parents(parents);
+  if (directory) *directory = parent_directory;
+  return item;
+}
+
+bool rename_file(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+  std::remove(to.c_str());
+#endif
+  return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+}  // namespace
+
+MetadataStore::Mapping::~Mapping() { close(); }
+
+bool MetadataStore::Mapping::open(const std::string& path) {
+  close();
+#ifdef _WIN32
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  buffer_.assign(std::istreambuf_iterator<char>(file),
+                 std::istreambuf_iterator<char>());
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  return true;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  struct stat st;
+  bool result = fstat(fd, &st) == 0;
+  if (result && st.st_size > 0) {
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<const char*>(data);
+      size_ = st.st_size;
+    } else {
+      result = false;
+    }
+  }
+  ::close(fd);
+  return result;
+#endif
+}
+
+void MetadataStore::Mapping::close() {
+#ifdef _WIN32
+  buffer_.clear();
+#else
+  if (data_) munmap(const_cast<char*>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+MetadataStore::Pointer MetadataStore::open(const std::string& path) {
+  auto store = Pointer(new MetadataStore(path));
+  if (!store->load()) return nullptr;
+  return store;
+}
+
+std::string MetadataStore::path(const std::string& directory,
+                                const std::string& provider,
+                                const std::string& account) {
+  char account_hash[17];
+  snprintf(account_hash, sizeof(account_hash), "%016llx",
+           static_cast<unsigned long long>(hash(account)));
+  return directory + "/" + provider + "-" + account_hash;
+}
+
+MetadataStore::MetadataStore(const std::string& path)
+    : path_(path), output_(), log_size_(), size_(), superseded_() {}
+
+MetadataStore::~MetadataStore() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!pending_.empty()) flush_unlocked();
+  if (output_) fclose(output_);
+}
+
+IItem::Pointer MetadataStore::item(const std::string& id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record record;
+  if (!find(item_key(id), record)) return nullptr;
+  return decode_item(record.value_);
+}
+
+void MetadataStore::put_item(const IItem& item, const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  write_item(item, directory);
+  if (output_) fflush(output_);
+}
+
+bool MetadataStore::listing(const std::string& directory,
+                            IItem::List& result) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record record;
+  if (!find(listing_key(directory), record)) return false;
+  Reader reader(record.value_.data(), record.value_.size());
+  uint32_t count;
+  if (!reader.get(count)) return false;
+  IItem::List items;
+  for (uint32_t i = 0; i < count; i++) {
+    std::string id;
+    Record item;
+    if (!reader.get(id) || !find(item_key(id), item)) return false;
+    if (auto decoded = decode_item(item.value_))
+      items.push_back(decoded);
+    else
+      return false;
+  }
+  result = std::move(items);
+  return true;
+}
+
+void MetadataStore::put_listing(const std::string& directory,
+                                const IItem::List& items) {
+  std::string value;
+  put(value, static_cast<uint32_t>(items.size()));
+  for (const auto& item : items) put(value, item->id());
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& item : items) write_item(*item, directory);
+  write(listing_key(directory), Kind::Listing, std::move(value));
+  if (output_) fflush(output_);
+}
+
+void MetadataStore::remove_item(const std::string& id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record record;
+  std::string directory;
+  if (find(item_key(id), record)) decode_item(record.value_, &directory);
+  write(item_key(id), Kind::Erased, "");
+  write(listing_key(id), Kind::Erased, "");
+  if (!directory.empty()) write(listing_key(directory), Kind::Erased, "");
+  if (output_) fflush(output_);
+}
+
+void MetadataStore::remove_listing(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  write(listing_key(directory), Kind::Erased, "");
+  if (output_) fflush(output_);
+}
+
+size_t MetadataStore::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+void MetadataStore::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  flush_unlocked();
+}
+
+bool MetadataStore::load() {
+  std::string log_path = path_ + ".log";
+  if (!log_.open(log_path) || log_.size() < sizeof(LOG_MAGIC) ||
+      memcmp(log_.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+    log_.close();
+    auto file = fopen(log_path.c_str(), "wb");
+    if (!file) return false;
+    bool written = fwrite(LOG_MAGIC, sizeof(LOG_MAGIC), 1, file) == 1;
+    fclose(file);
+    if (!written || !log_.open(log_path)) return false;
+    std::remove((path_ + ".index").c_str());
+  }
+  uint64_t indexed = sizeof(LOG_MAGIC), count = 0;
+  if (index_.open(path_ + ".index")) {
+    bool valid = index_.size() >= INDEX_HEADER_SIZE &&
+                 memcmp(index_.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+    if (valid) {
+      Reader reader(index_.data() + sizeof(INDEX_MAGIC),
+                    INDEX_HEADER_SIZE - sizeof(INDEX_MAGIC));
+      valid = reader.get(indexed) && reader.get(count) &&
+              index_.size() == INDEX_HEADER_SIZE + count * INDEX_ENTRY_SIZE &&
+              indexed <= log_.size() && indexed >= sizeof(LOG_MAGIC);
+    }
+    if (!valid) {
+      index_.close();
+      indexed = sizeof(LOG_MAGIC);
+      count = 0;
+    }
+  }
+  size_ = count;
+  log_size_ = indexed;
+  while (log_size_ < log_.size()) {
+    std::string key;
+    Record record;
+    if (!read(log_size_, &key, &record)) break;
+    uint64_t offset = log_size_;
+    uint32_t length;
+    memcpy(&length, log_.data() + offset, sizeof(length));
+    log_size_ += sizeof(length) + length;
+    Record previous;
+    bool existed = find(key, previous);
+    if (existed) superseded_++;
+    if (record.kind_ == Kind::Erased) {
+      if (existed) size_--;
+      superseded_++;
+    } else if (!existed) {
+      size_++;
+    }
+    pending_[key] = {std::move(record), offset};
+  }
+  bool torn = log_size_ < log_.size();
+  output_ = fopen(log_path.c_str(), "ab");
+  if (!output_) return false;
+  if (torn) {
+    // Unfinished write of the last run, records appended after it would be
+    // unreachable.
+    auto entries = this->entries();
+    return compact(entries) && write_index(entries);
+  }
+  return true;
+}
+
+bool MetadataStore::find(const std::string& key, Record& result) const {
+  auto it = pending_.find(key);
+  if (it != pending_.end()) {
+    if (it->second.record_.kind_ == Kind::Erased) return false;
+    result = it->second.record_;
+    return true;
+  }
+  return find_indexed(key, result);
+}
+
+bool MetadataStore::find_indexed(const std::string& key,
+                                 Record& result) const {
+  size_t count = index_size();
+  auto hash = cloudstorage::hash(key);
+  size_t begin = 0, end = count;
+  while (begin < end) {
+    auto middle = begin + (end - begin) / 2;
+    if (index_entry(middle).hash_ < hash)
+      begin = middle + 1;
+    else
+      end = middle;
+  }
+  for (; begin < count; begin++) {
+    auto entry = index_entry(begin);
+    if (entry.hash_ != hash) break;
+    std::string current;
+    if (read(entry.offset_, &current, &result) && current == key) return true;
+  }
+  return false;
+}
+
+bool MetadataStore::read(uint64_t offset, std::string* key,
+                         Record* record) const {
+  if (offset > log_.size()) return false;
+  Reader reader(log_.data() + offset, log_.size() - offset);
+  uint32_t length;
+  if (!reader.get(length) || log_.size() - offset - sizeof(length) < length)
+    return false;
+  Reader body(log_.data() + offset + sizeof(length), length);
+  uint8_t kind;
+  std::string current;
+  if (!body.get(kind) || !body.get(current) ||
+      kind > static_cast<uint8_t>(Kind::Listing))
+    return false;
+  auto value_size = length - sizeof(kind) - sizeof(uint32_t) - current.size();
+  if (key) *key = std::move(current);
+  if (record) {
+    record->kind_ = static_cast<Kind>(kind);
+    record->value_.assign(log_.data() + offset + sizeof(length) + length -
+                              value_size,
+                          value_size);
+  }
+  return true;
+}
+
+size_t MetadataStore::index_size() const {
+  return index_.data() ? (index_.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE
+                       : 0;
+}
+
+MetadataStore::IndexEntry MetadataStore::index_entry(size_t position) const {
+  IndexEntry result;
+  auto data = index_.data() + INDEX_HEADER_SIZE + position * INDEX_ENTRY_SIZE;
+  memcpy(&result.hash_, data, sizeof(uint64_t));
+  memcpy(&result.offset_, data + sizeof(uint64_t), sizeof(uint64_t));
+  return result;
+}
+
+std::vector<MetadataStore::IndexEntry> MetadataStore::entries() const {
+  std::unordered_set<uint64_t> pending_hashes;
+  std::vector<IndexEntry> pending;
+  for (const auto& p : pending_) {
+    auto hash = cloudstorage::hash(p.first);
+    pending_hashes.insert(hash);
+    if (p.second.record_.kind_ != Kind::Erased)
+      pending.push_back({hash, p.second.offset_});
+  }
+  auto by_hash = [](const IndexEntry& e1, const IndexEntry& e2) {
+    return e1.hash_ < e2.hash_;
+  };
+  std::sort(pending.begin(), pending.end(), by_hash);
+  std::vector<IndexEntry> indexed;
+  indexed.reserve(index_size());
+  for (size_t i = 0; i < index_size(); i++) {
+    auto entry = index_entry(i);
+    std::string key;
+    if (pending_hashes.find(entry.hash_) != pending_hashes.end() &&
+        read(entry.offset_, &key, nullptr) &&
+        pending_.find(key) != pending_.end())
+      continue;
+    indexed.push_back(entry);
+  }
+  std::vector<IndexEntry> result(indexed.size() + pending.size());
+  std::merge(indexed.begin(), indexed.end(), pending.begin(), pending.end(),
+             result.begin(), by_hash);
+  return result;
+}
+
+void MetadataStore::write(const std::string& key, Kind kind,
+                          std::string value) {
+  if (!output_) return;
+  Record previous;
+  bool existed = find(key, previous);
+  if (kind == Kind::Erased && !existed) return;
+  std::string body;
+  put(body, static_cast<uint8_t>(kind));
+  put(body, key);
+  body += value;
+  std::string record;
+  put(record, static_cast<uint32_t>(body.size()));
+  record += body;
+  if (fwrite(record.data(), record.size(), 1, output_) != 1) return;
+  if (kind == Kind::Erased) {
+    size_--;
+    superseded_ += 2;
+  } else if (existed) {
+    superseded_++;
+  } else {
+    size_++;
+  }
+  pending_[key] = {{kind, std::move(value)}, log_size_};
+  log_size_ += record.size();
+  if (pending_.size() >= PENDING_LIMIT) flush_unlocked();
+}
+
+void MetadataStore::write_item(const IItem& item,
+                               const std::string& directory) {
+  auto parent = directory;
+  Record record;
+  if (parent.empty() && find(item_key(item.id()), record))
+    decode_item(record.value_, &parent);
+  if (parent.empty())
+    if (auto i = dynamic_cast<const Item*>(&item))
+      if (!i->parents().empty()) parent = i->parents().front();
+  write(item_key(item.id()), Kind::Item, encode_item(item, parent));
+}
+
+bool MetadataStore::write_index(const std::vector<IndexEntry>& entries) {
+  std::string temporary = path_ + ".index.tmp";
+  auto file = fopen(temporary.c_str(), "wb");
+  if (!file) return false;
+  std::string header(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  put(header, log_size_);
+  put(header, static_cast<uint64_t>(entries.size()));
+  bool written = fwrite(header.data(), header.size(), 1, file) == 1;
+  for (const auto& entry : entries) {
+    uint64_t data[] = {entry.hash_, entry.offset_};
+    written = written && fwrite(data, sizeof(data), 1, file) == 1;
+  }
+  written = fclose(file) == 0 && written;
+  if (!written || !rename_file(temporary, path_ + ".index")) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  pending_.clear();
+  if (!index_.open(path_ + ".index")) index_.close();
+  return true;
+}
+
+bool MetadataStore::compact(std::vector<IndexEntry>& entries) {
+  std::string temporary = path_ + ".log.tmp";
+  auto file = fopen(temporary.c_str(), "wb");
+  if (!file) return false;
+  bool written = fwrite(LOG_MAGIC, sizeof(LOG_MAGIC), 1, file) == 1;
+  uint64_t size = sizeof(LOG_MAGIC);
+  std::vector<IndexEntry> copied;
+  copied.reserve(entries.size());
+  for (const auto& entry : entries) {
+    if (!read(entry.offset_, nullptr, nullptr)) continue;
+    uint32_t length;
+    memcpy(&length, log_.data() + entry.offset_, sizeof(length));
+    written = written && fwrite(log_.data() + entry.offset_,
+                                sizeof(length) + length, 1, file) == 1;
+    copied.push_back({entry.hash_, size});
+    size += sizeof(length) + length;
+  }
+  written = fclose(file) == 0 && written;
+  if (!written) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  fclose(output_);
+  log_.close();
+  std::string log_path = path_ + ".log";
+  bool renamed = rename_file(temporary, log_path);
+  output_ = fopen(log_path.c_str(), "ab");
+  index_.close();
+  std::remove((path_ + ".index").c_str());
+  pending_.clear();
+  if (!renamed || !output_ || !log_.open(log_path)) return false;
+  entries = std::move(copied);
+  log_size_ = size;
+  size_ = entries.size();
+  superseded_ = 0;
+  return true;
+}
+
+void MetadataStore::flush_unlocked() {
+  if (!output_) return;
+  fflush(output_);
+  if (!log_.open(path_ + ".log")) return;
+  auto entries = this->entries();
+  if (superseded_ > size_ && superseded_ >= MIN_COMPACTED_SIZE &&
+      !compact(entries))
+    return;
+  write_index(entries);
+}
+
+}  // namespace cloudstorage
@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * MetadataStore.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef METADATASTORE_H
+#define METADATASTORE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IItem.h"
+
+namespace cloudstorage {
+
+/**
+ * Items and directory listings of a single account, kept on disk between
+ * runs.
+ *
+ * Records are appended to a log, "<path>.log"; every record holds a key, its
+ * kind and a binary value. "<path>.index" holds entries (64-bit hash of the
+ * key, offset of the newest record with that key) sorted by hash, it's mapped
+ * into memory and binary searched, so opening a store doesn't depend on its
+ * size. Records appended after the index was written are kept in memory until
+ * the next flush, which rewrites the index, and when most of the log is
+ * superseded, the log too.
+ *
+ * Integers are stored in host byte order, files written on one architecture
+ * aren't portable to another.
+ */
+class MetadataStore {
+ public:
+  using Pointer = std::shared_ptr<MetadataStore>;
+
+  /**
+   * @return store at path, created if it doesn't exist; nullptr if the files
+   * can't be opened
+   */
+  static Pointer open(const std::string& path);
+
+  /**
+   * @return path of the store of provider's account in directory
+   */
+  static std::string path(const std::string& directory,
+                          const std::string& provider,
+                          const std::string& account);
+
+  ~MetadataStore();
+
+  /**
+   * @return item stored with id, nullptr if there is none
+   */
+  IItem::Pointer item(const std::string& id) const;
+
+  /**
+   * Stores the item. Directory is the id of the directory it was listed in,
+   * if empty the one recorded previously is kept.
+   */
+  void put_item(const IItem&, const std::string& directory = "");
+
+  bool listing(const std::string& directory, IItem::List&) const;
+
+  /**
+   * Stores the listing and every item in it.
+   */
+  void put_listing(const std::string& directory, const IItem::List&);
+
+  /**
+   * Drops the item, its listing and listing of the directory it was stored
+   * in.
+   */
+  void remove_item(const std::string& id);
+
+  void remove_listing(const std::string& directory);
+
+  /**
+   * @return number of keys with a value
+   */
+  size_t size() const;
+
+  /**
+   * Writes the index, compacting the log first if most of it is superseded.
+   */
+  void flush();
+
+ private:
+  enum class Kind : uint8_t { Erased, Item, Listing };
+
+  class Mapping {
+   public:
+    Mapping() = default;
+    Mapping(const Mapping&) = delete;
+    ~Mapping();
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+   private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    std::vector<char> buffer_;
+#endif
+  };
+
+  struct Record {
+    Kind kind_;
+    std::string value_;
+  };
+
+  struct Pending {
+    Record record_;
+    uint64_t offset_;
+  };
+
+  struct IndexEntry {
+    uint64_t hash_;
+    uint64_t offset_;
+  };
+
+  MetadataStore(const std::string& path);
+
+  bool load();
+  bool find(const std::string& key, Record&) const;
+  bool find_indexed(const std::string& key, Record&) const;
+  bool read(uint64_t offset, std::string* key, Record*) const;
+  size_t index_size() const;
+  IndexEntry index_entry(size_t position) const;
+  std::vector<IndexEntry> entries() const;
+  void write(const std::string& key, Kind, std::string value);
+  void write_item(const IItem&, const std::string& directory);
+  bool write_index(const std::vector<IndexEntry>&);
+  bool compact(std::vector<IndexEntry>&);
+  void flush_unlocked();
+
+  std::string path_;
+  mutable std::mutex mutex_;
+  Mapping log_;
+  Mapping index_;
+  FILE* output_;
+  uint64_t log_size_;
+  std::unordered_map<std::string, Pending> pending_;
+  size_t size_;
+  size_t superseded_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // METADATASTORE_H
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * Metrics.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Metrics.h"
+
+namespace cloudstorage {
+
+IMetrics& IMetrics::instance() {
+  static Metrics metrics;
+  return metrics;
+}
+
+IMetrics::Key Metrics::key(const std::string& provider,
+                           const std::string& operation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = keys_.find({provider, operation});
+  if (it != keys_.end()) return it->second;
+  series_.emplace_back();
+  auto& series = series_.back();
+  clear(series);
+  series.provider_ = provider;
+  series.operation_ = operation;
+  keys_.insert({{provider, operation}, &series});
+  return &series;
+}
+
+void Metrics::record(Key key, int http_code,
+                     const IHttpRequest::Metrics& metrics) {
+  const auto order = std::memory_order_relaxed;
+  key->count_.fetch_add(1, order);
+  if (!IHttpRequest::isSuccess(http_code)) key->errors_.fetch_add(1, order);
+  if (metrics.connection_reused_) key->reused_connections_.fetch_add(1, order);
+  key->downloaded_bytes_.fetch_add(metrics.downloaded_bytes_, order);
+  key->uploaded_bytes_.fetch_add(metrics.uploaded_bytes_, order);
+  // Aborted transfers end whenever the client gave up and the ones which
+  // never ran have zeroed times; neither says anything about the latency.
+  if (http_code == IHttpRequest::Aborted || metrics.total_time_ == 0) return;
+  if (metrics.start_transfer_time_ != 0)
+    add(key->first_byte_time_, metrics.start_transfer_time_);
+  add(key->total_time_, metrics.total_time_);
+}
+
+std::vector<IMetrics::Entry> Metrics::entries() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Entry> result;
+  for (auto&& k : keys_) {
+    const auto& series = *k.second;
+    if (series.count_ == 0) continue;
+    Entry entry = {};
+    entry.provider_ = series.provider_;
+    entry.operation_ = series.operation_;
+    entry.count_ = series.count_;
+    entry.errors_ = series.errors_;
+    entry.reused_connections_ = series.reused_connections_;
+    entry.downloaded_bytes_ = series.downloaded_bytes_;
+    entry.uploaded_bytes_ = series.uploaded_bytes_;
+    entry.first_byte_time_ = snapshot(series.first_byte_time_);
+    entry.total_time_ = snapshot(series.total_time_);
+    result.push_back(entry);
+  }
+  return result;
+}
+
+void Metrics::reset() {
+  // Keys stay valid, only their counters start over.
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto&& series : series_) clear(series);
+}
+
+void Metrics::add(Series::Histogram& histogram, uint64_t value) {
+  const auto order = std::memory_order_relaxed;
+  size_t bucket = 0;
+  while (bucket + 1 < Histogram::BucketCount && (value >> bucket) != 0)
+    bucket++;
+  histogram.buckets_[bucket].fetch_add(1, order);
+  histogram.sum_.fetch_add(value, order);
+  auto max = histogram.max_.load(order);
+  while (max < value &&
+         !histogram.max_.compare_exchange_weak(max, value, order))
+    ;
+  histogram.count_.fetch_add(1, order);
+}
+
+void Metrics::clear(Series::Histogram& histogram) {
+  for (auto& b : histogram.buckets_) b = 0;
+  histogram.count_ = 0;
+  histogram.sum_ = 0;
+  histogram.max_ = 0;
+}
+
+void Metrics::clear(Series& series) {
+  series.count_ = 0;
+  series.errors_ = 0;
+  series.reused_connections_ = 0;
+  series.downloaded_bytes_ = 0;
+  series.uploaded_bytes_ = 0;
+  clear(series.first_byte_time_);
+  clear(series.total_time_);
+}
+
+IMetrics::Histogram Metrics::snapshot(const Series::Histogram& histogram) {
+  Histogram result = {};
+  for (size_t i = 0; i < Histogram::BucketCount; i++)
+    result.buckets_[i] = histogram.buckets_[i];
+  result.count_ = histogram.count_;
+  result.sum_ = histogram.sum_;
+  result.max_ = histogram.max_;
+  return result;
+}
+
+}  // namespace cloudstorage
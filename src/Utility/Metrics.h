@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * Metrics.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "IMetrics.h"
+
+namespace cloudstorage {
+
+struct IMetrics::Series {
+  struct Histogram {
+    std::array<std::atomic<uint64_t>, IMetrics::Histogram::BucketCount>
+        buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+  };
+
+  std::string provider_;
+  std::string operation_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> errors_;
+  std::atomic<uint64_t> reused_connections_;
+  std::atomic<uint64_t> downloaded_bytes_;
+  std::atomic<uint64_t> uploaded_bytes_;
+  Histogram first_byte_time_;
+  Histogram total_time_;
+};
+
+class Metrics : public IMetrics {
+ public:
+  using IMetrics::record;
+
+  Key key(const std::string& provider, const std::string& operation) override;
+  void record(Key, int http_code, const IHttpRequest::Metrics&) override;
+  std::vector<Entry> entries() const override;
+  void reset() override;
+
+ private:
+  static void add(Series::Histogram&, uint64_t value);
+  static void clear(Series::Histogram&);
+  static void clear(Series&);
+  static Histogram snapshot(const Series::Histogram&);
+
+  mutable std::mutex mutex_;
+  std::deque<Series> series_;
+  std::map<std::pair<std::string, std::string>, Series*> keys_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // METRICS_H
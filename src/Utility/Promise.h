@@ -316,6 +316,27 @@ class Promise {
     return promise;
   }
 
+  /**
+   * Calls one of the callbacks once the promise is settled, right away if it
+   * already is. Unlike then, doesn't create a promise for the continuation;
+   * meant for awaiters of the coroutine layer.
+   */
+  template <typename OnFulfill, typename OnReject>
+  void subscribe(OnFulfill&& on_fulfill, OnReject&& on_reject) {
+    std::unique_lock<std::mutex> lock(data_->mutex_);
+    if (data_->error_ready_) {
+      lock.unlock();
+      on_reject(std::move(data_->exception_));
+    } else if (data_->ready_) {
+      lock.unlock();
+      SequenceGenerator<std::tuple_size<std::tuple<Ts...>>::value>::type::call(
+          on_fulfill, data_->value_);
+    } else {
+      data_->on_fulfill_ = std::forward<OnFulfill>(on_fulfill);
+      data_->on_reject_ = std::forward<OnReject>(on_reject);
+    }
+  }
+
   void fulfill(Ts&&... value) const {
     std::unique_lock<std::mutex> lock(data_->mutex_);
     data_->ready_ = true;
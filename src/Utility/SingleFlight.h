@@ -0,0 +1,273 @@
+/*****************************************************************************
+ * SingleFlight.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SINGLEFLIGHT_H
+#define SINGLEFLIGHT_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "IHttp.h"
+#include "IRequest.h"
+#include "Request/Request.h"
+#include "Utility/Utility.h"
+
+namespace cloudstorage {
+
+/**
+ * Coalesces identical requests: while a request with given key is in flight,
+ * callers asking for the same key are attached to it instead of starting a
+ * new one, and they all get its result. Every caller gets its own IRequest;
+ * cancelling it detaches only that caller, the shared request is cancelled
+ * when there is nobody left waiting for it. The shared request runs with the
+ * highest priority and the latest deadline of its callers.
+ */
+template <class Result>
+class SingleFlight : public std::enable_shared_from_this<SingleFlight<Result>> {
+ public:
+  using Pointer = std::shared_ptr<SingleFlight>;
+  using Callback = GenericCallback<Result>;
+  using Starter =
+      std::function<typename IRequest<Result>::Pointer(const Callback&)>;
+
+  static Pointer create() { return Pointer(new SingleFlight); }
+
+  /**
+   * @param key identifies the request, has to cover all its parameters
+   * @param priority priority the caller would run the request with
+   * @param deadline deadline the caller would run the request with
+   * @param callback called with the result
+   * @param start starts the request if there is none in flight with the key;
+   * it's called with the caller's priority and deadline in effect
+   * @return request of the caller
+   */
+  typename IRequest<Result>::Pointer run(
+      const std::string& key, IHttpRequest::Priority priority,
+      DeadlineScope::Clock::time_point deadline, const Callback& callback,
+      const Starter& start) {
+    auto caller = std::make_shared<Caller>(callback);
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = flights_.find(key);
+    if (it != flights_.end()) {
+      auto flight = it->second;
+      {
+        std::lock_guard<std::mutex> flight_lock(flight->mutex_);
+        flight->callers_.push_back(caller);
+        flight->followers_++;
+      }
+      lock.unlock();
+      adjust(flight, priority, deadline);
+      return util::make_unique<Follower>(this->shared_from_this(), flight,
+                                         caller);
+    }
+    auto flight = std::make_shared<Flight>(key, priority, deadline);
+    flight->callers_.push_back(caller);
+    flights_[key] = flight;
+    lock.unlock();
+    auto self = this->shared_from_this();
+    auto request = start(
+        [=](Result result) { self->complete(flight, std::move(result)); });
+    std::unique_lock<std::mutex> flight_lock(flight->mutex_);
+    flight->request_ = std::move(request);
+    flight->followers_++;
+    if (flight->cancelled_) {
+      flight_lock.unlock();
+      flight->request_->cancel();
+    } else if (flight->priority_ != priority || flight->deadline_ != deadline) {
+      // Callers which joined while the request was being started.
+      auto adjustable = dynamic_cast<IAdjustable*>(flight->request_.get());
+      priority = flight->priority_;
+      deadline = flight->deadline_;
+      flight_lock.unlock();
+      if (adjustable) adjustable->adjust(priority, deadline);
+    }
+    return util::make_unique<Follower>(self, flight, caller);
+  }
+
+ private:
+  SingleFlight() = default;
+
+  struct Caller {
+    Caller(const Callback& callback) : callback_(callback), finished_() {}
+
+    void done(const Result& result) {
+      util::exchange(callback_, nullptr)(result);
+      std::lock_guard<std::mutex> lock(mutex_);
+      result_ = result;
+      finished_ = true;
+      ready_.notify_all();
+    }
+
+    const Result& wait() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [this] { return finished_; });
+      return result_;
+    }
+
+    bool finished() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return finished_;
+    }
+
+    Callback callback_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    Result result_;
+    bool finished_;
+  };
+
+  struct Flight {
+    Flight(std::string key, IHttpRequest::Priority priority,
+           DeadlineScope::Clock::time_point deadline)
+        : key_(std::move(key)),
+          priority_(priority),
+          deadline_(deadline),
+          cancelled_(),
+          followers_() {}
+
+    std::string key_;
+    IHttpRequest::Priority priority_;
+    DeadlineScope::Clock::time_point deadline_;
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Caller>> callers_;
+    typename IRequest<Result>::Pointer request_;
+    bool cancelled_;
+    size_t followers_;
+  };
+
+  class Follower : public IRequest<Result>,
+                   public IFinishable,
+                   public IAdjustable {
+   public:
+    Follower(Pointer owner, std::shared_ptr<Flight> flight,
+             std::shared_ptr<Caller> caller)
+        : owner_(std::move(owner)),
+          flight_(std::move(flight)),
+          caller_(std::move(caller)) {}
+
+    ~Follower() override {
+      Follower::cancel();
+      // The shared request is released by the last follower; the flight may
+      // be destroyed from the request's own callback, which can't wait for
+      // the request to finish.
+      typename IRequest<Result>::Pointer request;
+      {
+        std::lock_guard<std::mutex> lock(flight_->mutex_);
+        if (--flight_->followers_ == 0) request = std::move(flight_->request_);
+      }
+    }
+
+    void finish() override { caller_->wait(); }
+
+    void cancel() override {
+      std::unique_lock<std::mutex> lock(flight_->mutex_);
+      auto it = std::find(flight_->callers_.begin(), flight_->callers_.end(),
+                          caller_);
+      if (it == flight_->callers_.end()) return;
+      flight_->callers_.erase(it);
+      bool last = flight_->callers_.empty();
+      if (last) flight_->cancelled_ = true;
+      lock.unlock();
+      if (last) {
+        owner_->remove(flight_);
+        lock.lock();
+        if (flight_->request_) {
+          lock.unlock();
+          flight_->request_->cancel();
+        }
+      }
+      caller_->done(Error{IHttpRequest::Aborted, util::Error::ABORTED});
+    }
+
+    Result result() override { return caller_->wait(); }
+
+    void pause() override {}
+
+    void resume() override {}
+
+    bool is_finished() const override {
+      if (!caller_->finished()) return false;
+      // Releasing the last follower releases the shared request too, which
+      // has to be finished as well then.
+      std::lock_guard<std::mutex> lock(flight_->mutex_);
+      if (!flight_->request_ || flight_->followers_ > 1) return true;
+      auto request = dynamic_cast<const IFinishable*>(flight_->request_.get());
+      return request && request->is_finished();
+    }
+
+    void adjust(IHttpRequest::Priority priority,
+                DeadlineScope::Clock::time_point deadline) override {
+      owner_->adjust(flight_, priority, deadline);
+    }
+
+   private:
+    Pointer owner_;
+    std::shared_ptr<Flight> flight_;
+    std::shared_ptr<Caller> caller_;
+  };
+
+  /**
+   * Raises priority and extends deadline of the flight for its new caller;
+   * the caller has to be counted among followers, so that the shared request
+   * isn't released meanwhile.
+   */
+  void adjust(const std::shared_ptr<Flight>& flight,
+              IHttpRequest::Priority priority,
+              DeadlineScope::Clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(flight->mutex_);
+    if (priority >= flight->priority_ && deadline <= flight->deadline_) return;
+    flight->priority_ = std::min(flight->priority_, priority);
+    flight->deadline_ = std::max(flight->deadline_, deadline);
+    // Not started yet, run() adjusts it once it is.
+    auto request = dynamic_cast<IAdjustable*>(flight->request_.get());
+    priority = flight->priority_;
+    deadline = flight->deadline_;
+    lock.unlock();
+    if (request) request->adjust(priority, deadline);
+  }
+
+  void remove(const std::shared_ptr<Flight>& flight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = flights_.find(flight->key_);
+    if (it != flights_.end() && it->second == flight) flights_.erase(it);
+  }
+
+  void complete(const std::shared_ptr<Flight>& flight, const Result& result) {
+    remove(flight);
+    std::vector<std::shared_ptr<Caller>> callers;
+    {
+      std::lock_guard<std::mutex> lock(flight->mutex_);
+      callers.swap(flight->callers_);
+    }
+    for (auto&& caller : callers) caller->done(result);
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // SINGLEFLIGHT_H
@@ -103,6 +103,8 @@ void ThreadPool::handleDelayedTasks() {
         lock.unlock();
         task.second();
         lock.lock();
+      } else {
+        worker_cv_.wait_until(lock, delayed_tasks_.begin()->first);
       }
     }
   }
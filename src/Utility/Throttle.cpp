@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * Throttle.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "Throttle.h"
+
+#include <algorithm>
+
+namespace cloudstorage {
+
+IThrottle::Pointer IThrottle::create(uint64_t download_limit,
+                                     uint64_t upload_limit) {
+  return std::make_shared<Throttle>(download_limit, upload_limit);
+}
+
+Throttle::Throttle(uint64_t download_limit, uint64_t upload_limit) {
+  auto now = std::chrono::steady_clock::now();
+  bucket_[static_cast<size_t>(Direction::Download)] = {
+      download_limit, static_cast<double>(download_limit), now};
+  bucket_[static_cast<size_t>(Direction::Upload)] = {
+      upload_limit, static_cast<double>(upload_limit), now};
+}
+
+void Throttle::setLimit(Direction direction, uint64_t limit) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& bucket = bucket_[static_cast<size_t>(direction)];
+  bucket.refill();
+  bucket.limit_ = limit;
+  bucket.tokens_ = std::min(bucket.tokens_, static_cast<double>(limit));
+}
+
+uint64_t Throttle::limit(Direction direction) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bucket_[static_cast<size_t>(direction)].limit_;
+}
+
+bool Throttle::available(Direction direction) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& bucket = bucket_[static_cast<size_t>(direction)];
+  if (bucket.limit_ == 0) return true;
+  bucket.refill();
+  return bucket.tokens_ > 0;
+}
+
+void Throttle::consume(Direction direction, uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& bucket = bucket_[static_cast<size_t>(direction)];
+  if (bucket.limit_ == 0) return;
+  bucket.refill();
+  bucket.tokens_ -= bytes;
+}
+
+std::chrono::milliseconds Throttle::delay(Direction direction) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& bucket = bucket_[static_cast<size_t>(direction)];
+  if (bucket.limit_ == 0) return std::chrono::milliseconds();
+  bucket.refill();
+  if (bucket.tokens_ > 0) return std::chrono::milliseconds();
+  // Rounded up, so that the bucket is not empty once the delay passes.
+  return std::chrono::milliseconds(
+      static_cast<int64_t>(-bucket.tokens_ * 1000 / bucket.limit_) + 1);
+}
+
+void Throttle::Bucket::refill() {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = now - update_;
+  update_ = now;
+  tokens_ = std::min(tokens_ + elapsed.count() * limit_,
+                     static_cast<double>(limit_));
+}
+
+}  // namespace cloudstorage
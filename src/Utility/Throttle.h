@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * Throttle.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <array>
+#include <chrono>
+#include <mutex>
+
+#include "IThrottle.h"
+
+namespace cloudstorage {
+
+class Throttle : public IThrottle {
+ public:
+  Throttle(uint64_t download_limit, uint64_t upload_limit);
+
+  void setLimit(Direction, uint64_t) override;
+  uint64_t limit(Direction) const override;
+  bool available(Direction) override;
+  void consume(Direction, uint64_t) override;
+  std::chrono::milliseconds delay(Direction) override;
+
+ private:
+  /**
+   * Holds at most one second worth of tokens, so that an idle transfer can't
+   * burst over the limit for long.
+   */
+  struct Bucket {
+    void refill();
+
+    uint64_t limit_;
+    double tokens_;
+    std::chrono::steady_clock::time_point update_;
+  };
+
+  mutable std::mutex mutex_;
+  std::array<Bucket, 2> bucket_;
+};
+
+}  // namespace cloudstorage
+
+#endif  // THROTTLE_H
@@ -45,6 +45,7 @@
 #include <pthread.h>
 #endif
 
+#include "ChunkedBuffer.h"
 #include "LoginPage.h"
 
 namespace cloudstorage {
@@ -242,6 +243,18 @@ IItem::TimeStamp parse_time(const std::string& str) {
   return IItem::UnknownTimeStamp;
 }
 
+IItem::TimeStamp parse_http_time(const std::string& str) {
+  std::stringstream stream(str);
+  std::tm time = {};
+  stream >> std::get_time(&time, "%a, %d %b %Y %T GMT");
+  if (!stream.fail()) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::seconds(timegm(time)));
+  } else {
+    return IItem::UnknownTimeStamp;
+  }
+}
+
 std::string to_base64(const std::string& in) {
   const char* base64_chars =
       "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -344,6 +357,21 @@ std::string Url::escape(const std::string& value) {
   return escaped.str();
 }
 
+std::string Url::escapePath(const std::string& str) {
+  std::string data = escape(str);
+  std::string slash = escape("/");
+  std::string result;
+  for (size_t i = 0; i < data.size();)
+    if (data.substr(i, slash.length()) == slash) {
+      result += "/";
+      i += slash.length();
+    } else {
+      result += data[i];
+      i++;
+    }
+  return result;
+}
+
 std::string Url::escapeHeader(const std::string& header) {
   return Json::valueToQuotedString(header.c_str());
 }
@@ -474,11 +502,15 @@ std::string json::to_string(const Json::Value& json) {
 }
 
 Json::Value json::from_string(const std::string& str) {
+  return from_data(str.data(), str.size());
+}
+
+Json::Value json::from_data(const char* data, size_t size) {
   Json::CharReaderBuilder factory;
   std::unique_ptr<Json::CharReader> reader(factory.newCharReader());
   Json::Value json;
   std::string error;
-  if (!reader->parse(str.data(), str.data() + str.size(), &json, &error))
+  if (!reader->parse(data, data + size, &json, &error))
     throw Json::Exception(error);
   return json;
 }
@@ -488,9 +520,9 @@ Json::Value json::from_stream(std::istream&& stream) {
 }
 
 Json::Value json::from_stream(std::istream& stream) {
-  std::stringstream sstream;
-  sstream << stream.rdbuf();
-  return from_string(sstream.str());
+  std::string storage;
+  auto data = contents(stream, storage);
+  return from_data(data.data_, data.size_);
 }
 
 void set_thread_name(const std::string& name) {
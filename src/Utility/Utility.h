@@ -103,6 +103,7 @@ CLOUDSTORAGE_API std::unordered_map<std::string, std::string> parse_cookie(
 CLOUDSTORAGE_API std::string range_to_string(Range);
 CLOUDSTORAGE_API std::string to_mime_type(const std::string& extension);
 CLOUDSTORAGE_API IItem::TimeStamp parse_time(const std::string& time);
+CLOUDSTORAGE_API IItem::TimeStamp parse_http_time(const std::string& time);
 CLOUDSTORAGE_API std::string login_page(const std::string& provider);
 CLOUDSTORAGE_API std::string success_page(const std::string& provider);
 CLOUDSTORAGE_API std::string error_page(const std::string& provider);
@@ -110,6 +111,7 @@ CLOUDSTORAGE_API const char* libcloudstorage_ascii_art();
 namespace json {
 CLOUDSTORAGE_API std::string to_string(const Json::Value&);
 CLOUDSTORAGE_API Json::Value from_string(const std::string&);
+CLOUDSTORAGE_API Json::Value from_data(const char* data, size_t size);
 CLOUDSTORAGE_API Json::Value from_stream(std::istream&&);
 CLOUDSTORAGE_API Json::Value from_stream(std::istream&);
 }  // namespace json
@@ -120,6 +122,7 @@ class CLOUDSTORAGE_API Url {
 
   static std::string unescape(const std::string&);
   static std::string escape(const std::string&);
+  static std::string escapePath(const std::string&);
   static std::string escapeHeader(const std::string&);
 
   std::string protocol() const;
@@ -158,6 +161,7 @@ void detach_thread();
 namespace Error {
 
 constexpr auto INVALID_XML = "invalid xml";
+constexpr auto INVALID_JSON = "invalid json";
 constexpr auto FAILED_TO_PARSE_XML = "failed to parse xml";
 constexpr auto INVALID_CREDENTIALS = "invalid credentials";
 constexpr auto INVALID_AUTHORIZATION_CODE = "invalid authorization code";
@@ -181,6 +185,7 @@ constexpr auto INVALID_REQUEST = "invalid request";
 constexpr auto INVALID_KIND = "invalid kind";
 constexpr auto INVALID_STATE = "invalid state argument";
 constexpr auto ABORTED = "aborted";
+constexpr auto DEADLINE_EXCEEDED = "deadline exceeded";
 constexpr auto NODE_NOT_FOUND = "node not found";
 constexpr auto COULD_NOT_FIND_DESCRAMBLER_NAME =
     "couldn't find descrambler name";
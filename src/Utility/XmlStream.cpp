@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * XmlStream.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "XmlStream.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "Utility.h"
+
+namespace cloudstorage {
+namespace util {
+
+namespace {
+
+bool ends_with(const std::string& str, const char* suffix) {
+  auto length = strlen(suffix);
+  return str.length() >= length &&
+         str.compare(str.length() - length, length, suffix) == 0;
+}
+
+}  // namespace
+
+XmlBuffer::XmlBuffer(std::vector<std::string> names, ElementCallback callback)
+    : names_(std::move(names)),
+      callback_(std::move(callback)),
+      state_(State::Text),
+      quote_(0),
+      depth_(0),
+      capturing_(false) {}
+
+void XmlBuffer::write(const char* data, size_t size) {
+  size_t i = 0;
+  while (i < size && error_.empty()) {
+    if (state_ == State::Text) {
+      size_t end = i;
+      while (end < size && data[end] != '<') end++;
+      destination().append(data + i, end - i);
+      if ((i = end) == size) break;
+    }
+    consume(data[i++]);
+  }
+}
+
+void XmlBuffer::finish(tinyxml2::XMLDocument& document) {
+  if (!error_.empty()) throw std::logic_error(error_);
+  if (state_ != State::Text || depth_ != 0)
+    throw std::logic_error(Error::FAILED_TO_PARSE_XML);
+  if (document.Parse(rest_.data(), rest_.size()) != tinyxml2::XML_SUCCESS)
+    throw std::logic_error(Error::FAILED_TO_PARSE_XML);
+}
+
+XmlBuffer::int_type XmlBuffer::overflow(int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    char data = traits_type::to_char_type(c);
+    write(&data, 1);
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize XmlBuffer::xsputn(const char* data, std::streamsize size) {
+  write(data, static_cast<size_t>(size));
+  return size;
+}
+
+void XmlBuffer::consume(char c) {
+  switch (state_) {
+    case State::Text:
+      tag_ = c;
+      state_ = State::Tag;
+      break;
+    case State::Tag:
+      tag_ += c;
+      if (quote_) {
+        if (c == quote_) quote_ = 0;
+      } else if (tag_ == "<!--") {
+        state_ = State::Comment;
+      } else if (tag_ == "<![CDATA[") {
+        state_ = State::CData;
+      } else if (c == '"' || c == '\'') {
+        quote_ = c;
+      } else if (c == '>') {
+        tag();
+      }
+      break;
+    case State::Comment:
+      tag_ += c;
+      if (c == '>' && ends_with(tag_, "-->")) {
+        destination() += tag_;
+        state_ = State::Text;
+      }
+      break;
+    case State::CData:
+      tag_ += c;
+      if (c == '>' && ends_with(tag_, "]]>")) {
+        destination() += tag_;
+        state_ = State::Text;
+      }
+      break;
+  }
+}
+
+void XmlBuffer::tag() {
+  state_ = State::Text;
+  if (tag_[1] == '?' || tag_[1] == '!') {
+    destination() += tag_;
+  } else if (tag_[1] == '/') {
+    if (--depth_ < 0) {
+      error_ = Error::FAILED_TO_PARSE_XML;
+      return;
+    }
+    destination() += tag_;
+    if (capturing_ && depth_ == 1) flush();
+  } else {
+    bool closed = tag_[tag_.length() - 2] == '/';
+    if (!capturing_ && depth_ == 1 && matches()) capturing_ = true;
+    destination() += tag_;
+    if (!closed)
+      depth_++;
+    else if (capturing_ && depth_ == 1)
+      flush();
+  }
+}
+
+bool XmlBuffer::matches() const {
+  auto end = tag_.find_first_of(" \t\r\n/>", 1);
+  auto name = tag_.substr(1, end - 1);
+  auto colon = name.find(':');
+  if (colon != std::string::npos) name = name.substr(colon + 1);
+  for (const auto& n : names_)
+    if (n == name) return true;
+  return false;
+}
+
+void XmlBuffer::flush() {
+  capturing_ = false;
+  if (element_document_.Parse(element_.data(), element_.size()) !=
+      tinyxml2::XML_SUCCESS)
+    error_ = Error::FAILED_TO_PARSE_XML;
+  else
+    try {
+      callback_(*element_document_.RootElement());
+    } catch (const std::exception& e) {
+      error_ = e.what();
+    }
+  element_.clear();
+}
+
+std::string& XmlBuffer::destination() {
+  return capturing_ ? element_ : rest_;
+}
+
+XmlStream::XmlStream(std::vector<std::string> names,
+                     XmlBuffer::ElementCallback callback)
+    : std::ostream(nullptr), buffer_(std::move(names), std::move(callback)) {
+  init(&buffer_);
+}
+
+XmlBuffer* XmlStream::rdbuf() { return &buffer_; }
+
+}  // namespace util
+}  // namespace cloudstorage
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * XmlStream.h
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef XMLSTREAM_H
+#define XMLSTREAM_H
+
+#include <tinyxml2.h>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace cloudstorage {
+namespace util {
+
+/**
+ * Incremental xml parser meant to be written to while the response is being
+ * received. Children of the root element with one of the given names are
+ * parsed one at a time and handed to the callback as soon as they are
+ * complete; the rest of the document is kept, without those children, and
+ * parsed by finish. Only one child is held in memory at a time.
+ */
+class XmlBuffer : public std::streambuf {
+ public:
+  using ElementCallback = std::function<void(const tinyxml2::XMLElement&)>;
+
+  /**
+   * @param names names of the children of the root element, compared without
+   * namespace prefix
+   *
+   * @param callback called for each matching child
+   */
+  XmlBuffer(std::vector<std::string> names, ElementCallback callback);
+
+  XmlBuffer(const XmlBuffer&) = delete;
+  XmlBuffer& operator=(const XmlBuffer&) = delete;
+
+  void write(const char* data, size_t size);
+
+  /**
+   * Throws if the document was malformed or the callback threw.
+   *
+   * @param document set to the document without matching children
+   */
+  void finish(tinyxml2::XMLDocument& document);
+
+ protected:
+  int_type overflow(int_type) override;
+  std::streamsize xsputn(const char*, std::streamsize) override;
+
+ private:
+  enum class State { Text, Tag, Comment, CData };
+
+  void consume(char);
+  void tag();
+  bool matches() const;
+  void flush();
+  std::string& destination();
+
+  std::vector<std::string> names_;
+  ElementCallback callback_;
+  tinyxml2::XMLDocument element_document_;
+  State state_;
+  char quote_;
+  int depth_;
+  bool capturing_;
+  std::string tag_;
+  std::string element_;
+  std::string rest_;
+  std::string error_;
+};
+
+/**
+ * Stream writing into XmlBuffer.
+ */
+class XmlStream : public std::ostream {
+ public:
+  XmlStream(std::vector<std::string> names,
+            XmlBuffer::ElementCallback callback);
+
+  XmlBuffer* rdbuf();
+
+ private:
+  XmlBuffer buffer_;
+};
+
+}  // namespace util
+}  // namespace cloudstorage
+
+#endif  // XMLSTREAM_H
@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * DropboxTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "CloudProvider/Dropbox.h"
+#include "Utility/HttpServerMock.h"
+#include "Utility/Utility.h"
+#include "gtest/gtest.h"
+
+#ifdef __unix__
+
+#include <arpa/inet.h>
+#include <json/json.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace cloudstorage;
+using ::testing::_;
+
+namespace {
+
+const std::chrono::seconds TIMEOUT(10);
+
+// Stand-in for Dropbox's api and notify servers, following the fixture: a list
+// of entries, with cursor "cN" pointing after the first N of them.
+// list_folder/continue returns entries after the cursor, list_folder/longpoll
+// answers once there are some.
+class DropboxServer {
+ public:
+  DropboxServer() : stopped_(), socket_(socket(AF_INET, SOCK_STREAM, 0)) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(socket_, reinterpret_cast<sockaddr*>(&address), length);
+    listen(socket_, 8);
+    getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([=] {
+      int fd;
+      while ((fd = accept(socket_, nullptr, nullptr)) != -1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.push_back(fd);
+        workers_.emplace_back([=] { serve(fd); });
+      }
+    });
+  }
+
+  ~DropboxServer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+      condition_.notify_all();
+    }
+    shutdown(socket_, SHUT_RDWR);
+    thread_.join();
+    for (int fd : clients_) shutdown(fd, SHUT_RDWR);
+    for (auto& t : workers_) t.join();
+    for (int fd : clients_) close(fd);
+    close(socket_);
+  }
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+  }
+
+  void add(const Json::Value& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(entry);
+    condition_.notify_all();
+  }
+
+  bool wait_for_long_poll(const std::string& cursor) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return condition_.wait_for(lock, TIMEOUT, [=] {
+      return std::find(long_polls_.begin(), long_polls_.end(), cursor) !=
+             long_polls_.end();
+    });
+  }
+
+  int count(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_[path];
+  }
+
+  bool authorized(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return authorized_[path];
+  }
+
+ private:
+  void serve(int fd) {
+    std::string buffer;
+    char data[1024];
+    ssize_t length;
+    while ((length = recv(fd, data, sizeof(data), 0)) > 0) {
+      buffer.append(data, length);
+      size_t end;
+      while ((end = buffer.find("\r\n\r\n")) != std::string::npos) {
+        auto header = buffer.substr(0, end);
+        auto it = header.find("Content-Length: ");
+        size_t size = it == std::string::npos
+                          ? 0
+                          : std::stoul(header.substr(it + 16));
+        if (buffer.size() < end + 4 + size) break;
+        auto body = buffer.substr(end + 4, size);
+        buffer.erase(0, end + 4 + size);
+        auto path = header.substr(header.find(' ') + 1);
+        path = path.substr(0, path.find(' '));
+        auto content = util::json::to_string(
+            respond(path, header, util::json::from_string(body)));
+        auto response =
+            "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+            "Content-Length: " +
+            std::to_string(content.size()) + "\r\n\r\n" + content;
+        send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+      }
+    }
+  }
+
+  Json::Value respond(const std::string& path, const std::string& header,
+                      const Json::Value& request) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    requests_[path]++;
+    authorized_[path] = header.find("Authorization") != std::string::npos;
+    auto cursor = request["cursor"].asString();
+    size_t position =
+        cursor.empty() ? entries_.size() : std::stoul(cursor.substr(1));
+    Json::Value response;
+    if (path == "/notify/2/files/list_folder/longpoll") {
+      long_polls_.push_back(cursor);
+      condition_.notify_all();
+      condition_.wait(lock,
+                      [=] { return stopped_ || entries_.size() > position; });
+      response["changes"] = true;
+    } else {
+      response["entries"] = Json::arrayValue;
+      for (size_t i = position; i < entries_.size(); i++)
+        response["entries"].append(entries_[i]);
+      response["cursor"] = "c" + std::to_string(entries_.size());
+      response["has_more"] = false;
+    }
+    return response;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopped_;
+  std::vector<Json::Value> entries_;
+  std::vector<std::string> long_polls_;
+  std::unordered_map<std::string, int> requests_;
+  std::unordered_map<std::string, bool> authorized_;
+  int socket_;
+  uint16_t port_;
+  std::vector<int> clients_;
+  std::vector<std::thread> workers_;
+  std::thread thread_;
+};
+
+class LocalDropbox : public Dropbox {
+ public:
+  LocalDropbox(std::string url) : url_(std::move(url)) {}
+
+  std::string endpoint() const override { return url_ + "/api"; }
+
+  std::string notifyEndpoint() const override { return url_ + "/notify"; }
+
+ private:
+  std::string url_;
+};
+
+class ChangesListener : public ICloudProvider::IChangesListener {
+ public:
+  void changed(const std::vector<Change>& changes) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_.insert(changes_.end(), changes.begin(), changes.end());
+    condition_.notify_all();
+  }
+
+  std::vector<Change> wait(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait_for(lock, TIMEOUT,
+                        [=] { return changes_.size() >= count; });
+    return changes_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<Change> changes_;
+};
+
+}  // namespace
+
+TEST(DropboxTest, PushesChangesFromLongPollTest) {
+  DropboxServer server;
+  ICloudProvider::InitData data;
+  data.http_engine_ = IHttp::create(IHttp::Options());
+  if (!data.http_engine_) return;
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.hints_["access_token"] = "access_token";
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(::testing::Invoke([](IHttpServer::ICallback::Pointer,
+                                     const std::string&, IHttpServer::Type) {
+        return util::make_unique<HttpServerMock>();
+      }));
+  auto provider = std::make_shared<LocalDropbox>(server.url());
+  provider->initialize(std::move(data));
+  auto listener = std::make_shared<ChangesListener>();
+  provider->subscribeChanges(listener);
+  ASSERT_TRUE(server.wait_for_long_poll("c0"));
+  EXPECT_FALSE(server.authorized("/notify/2/files/list_folder/longpoll"));
+  EXPECT_TRUE(server.authorized("/api/2/files/list_folder/get_latest_cursor"));
+  Json::Value entry;
+  entry[".tag"] = "file";
+  entry["name"] = "a";
+  entry["path_display"] = "/a";
+  entry["size"] = 1;
+  server.add(entry);
+  auto changes = listener->wait(1);
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type_, Change::Type::Add);
+  EXPECT_EQ(changes[0].item_->filename(), "a");
+  EXPECT_TRUE(server.wait_for_long_poll("c1"));
+  // Changes were queried only once the long poll reported them.
+  EXPECT_EQ(server.count("/api/2/files/list_folder/continue"), 1);
+  provider->unsubscribeChanges(listener);
+  provider->destroy();
+}
+
+#endif  // __unix__
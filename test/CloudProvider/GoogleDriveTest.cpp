@@ -21,16 +21,30 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 #include <json/json.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <thread>
+#include "CloudProvider/GoogleDrive.h"
 #include "ICloudStorage.h"
+#include "Request/DownloadFileRequest.h"
+#include "Utility/AllocationCounter.h"
 #include "Utility/HttpMock.h"
 #include "Utility/HttpServerMock.h"
+#include "Utility/Item.h"
+#include "Utility/MetadataStore.h"
 #include "Utility/Utility.h"
 #include "gtest/gtest.h"
 
 using namespace cloudstorage;
 using ::testing::_;
 using ::testing::AtLeast;
+using ::testing::InSequence;
 using ::testing::Return;
+using ::testing::ReturnRefOfCopy;
 
 class AuthCallback : public ICloudProvider::IAuthCallback {
   Status userConsentRequired(const ICloudProvider&) override {
@@ -40,6 +54,117 @@ class AuthCallback : public ICloudProvider::IAuthCallback {
   void done(const ICloudProvider&, EitherError<void>) override {}
 };
 
+class TokenRefreshCallback : public ICloudProvider::IAuthCallback {
+ public:
+  Status userConsentRequired(const ICloudProvider&) override {
+    return Status::None;
+  }
+
+  void done(const ICloudProvider&, EitherError<void> e) override {
+    if (++count_ == 2) refreshed_.set_value(e.left() == nullptr);
+  }
+
+  std::atomic_int count_{0};
+  std::promise<bool> refreshed_;
+};
+
+class SilentRefreshCallback : public ICloudProvider::IAuthCallback {
+ public:
+  Status userConsentRequired(const ICloudProvider&) override {
+    consents_++;
+    return Status::WaitForAuthorizationCode;
+  }
+
+  void done(const ICloudProvider&, EitherError<void> e) override {
+    if (e.left()) errors_++;
+  }
+
+  std::atomic_int consents_{0};
+  std::atomic_int errors_{0};
+};
+
+class StreamDirectoryCallback : public IStreamDirectoryCallback {
+ public:
+  void receivedItem(IItem::Pointer item) override {
+    names_.push_back(item->filename());
+  }
+
+  void done(EitherError<uint64_t>) override {}
+
+  std::vector<std::string> names_;
+};
+
+class ListingCallback : public IListDirectoryCallback {
+ public:
+  void receivedItem(IItem::Pointer item) override {
+    names_.push_back(item->filename());
+  }
+
+  void done(EitherError<IItem::List>) override {}
+
+  std::vector<std::string> names_;
+};
+
+class ChunkCallback : public IDownloadFileCallback {
+ public:
+  ChunkCallback(std::function<void(EitherError<void>)> done)
+      : done_(std::move(done)) {}
+
+  void receivedData(const char*, uint32_t) override {}
+
+  void progress(uint64_t, uint64_t) override {}
+
+  void done(EitherError<void> e) override { done_(e); }
+
+ private:
+  std::function<void(EitherError<void>)> done_;
+};
+
+class DataCallback : public IDownloadFileCallback {
+ public:
+  void receivedData(const char* data, uint32_t length) override {
+    data_.append(data, length);
+  }
+
+  void progress(uint64_t, uint64_t) override {}
+
+  void done(EitherError<void>) override {}
+
+  std::string data_;
+};
+
+class TrackedGoogleDrive : public GoogleDrive {
+ public:
+  DownloadFileRequest::Pointer downloadFileAsync(
+      IItem::Pointer file, IDownloadFileCallback::Pointer callback,
+      Range range) override {
+    auto request = std::make_shared<cloudstorage::DownloadFileRequest>(
+        shared_from_this(), std::move(file), std::move(callback), range,
+        [this](const IItem& item, std::ostream& input) {
+          return downloadFileRequest(item, input);
+        });
+    requests_.push_back(request);
+    return request->run();
+  }
+
+  size_t alive() const {
+    return std::count_if(
+        requests_.begin(), requests_.end(),
+        [](const std::weak_ptr<IGenericRequest>& r) { return !r.expired(); });
+  }
+
+ private:
+  std::vector<std::weak_ptr<IGenericRequest>> requests_;
+};
+
+class ListingGoogleDrive : public GoogleDrive {
+ public:
+  IHttpRequest::Pointer changesRequest(const std::string&,
+                                       std::ostream&) const override {
+    return nullptr;
+  }
+};
+
 class GoogleDriveTest : public ::testing::Test {
  public:
   void SetUp() override {}
@@ -64,6 +189,133 @@ ACTION(CallSend) {
   arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
 }
 
+ACTION(ThrottledSend) {
+  arg0(IHttpRequest::Response{
+      IHttpRequest::TooManyRequests, {{"retry-after", "0"}}, arg2, arg3});
+}
+
+ACTION_P2(FailedSend, code, headers) {
+  arg0(IHttpRequest::Response{code, headers, arg2, arg3});
+}
+
+ACTION_P(StalledSend, data) {
+  *arg2 << data;
+  arg0(IHttpRequest::Response{IHttpRequest::Timeout, {}, arg2, arg3});
+}
+
+ACTION_P(DeferredSend, send) {
+  auto callback = arg0;
+  auto output = arg2;
+  auto error = arg3;
+  auto http_callback = arg4;
+  *send = [=] {
+    EXPECT_FALSE(http_callback->abort());
+    Json::Value item;
+    item["id"] = "id";
+    item["name"] = "test";
+    *output << item;
+    callback(IHttpRequest::Response{IHttpRequest::Ok, {}, output, error});
+  };
+}
+
+ACTION(ItemSend) {
+  Json::Value item;
+  item["id"] = "id";
+  item["name"] = "test";
+  *arg2 << item;
+  arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
+}
+
+ACTION_P(DirectorySend, name) {
+  Json::Value json;
+  Json::Value item;
+  item["id"] = name;
+  item["name"] = name;
+  item["mimeType"] = "application/vnd.google-apps.folder";
+  json["files"].append(item);
+  *arg2 << json;
+  arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
+}
+
+ACTION_P(JsonSend, json) {
+  *arg2 << json;
+  arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
+}
+
+ACTION(EmptySend) {
+  arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
+}
+
+ACTION_P3(HeldTokenSend, token, send, sent) {
+  auto callback = arg0;
+  auto output = arg2;
+  auto error = arg3;
+  auto http_callback = arg4;
+  *send = [=] {
+    if (http_callback->abort())
+      return callback(
+          IHttpRequest::Response{IHttpRequest::Aborted, {}, output, error});
+    Json::Value json;
+    json["access_token"] = token;
+    json["expires_in"] = 3600;
+    *output << json;
+    callback(IHttpRequest::Response{IHttpRequest::Ok, {}, output, error});
+  };
+  sent->set_value();
+}
+
+ACTION_P(AbandonedSend, send) {
+  auto callback = arg0;
+  auto output = arg2;
+  auto error = arg3;
+  auto http_callback = arg4;
+  *send = [=] {
+    EXPECT_TRUE(http_callback->abort());
+    callback(IHttpRequest::Response{IHttpRequest::Aborted, {}, output, error});
+  };
+}
+
+ACTION_P3(PageSend, name, token, received) {
+  Json::Value json;
+  Json::Value item;
+  item["kind"] = "drive#file";
+  item["name"] = name;
+  json["files"].append(item);
+  if (!std::string(token).empty()) json["nextPageToken"] = token;
+  *arg2 << json;
+  EXPECT_EQ(received->back(), name);
+  arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
+}
+
+ACTION_P2(DeferredPageSend, send, received) {
+  auto callback = arg0;
+  auto output = arg2;
+  auto error = arg3;
+  *send = [=] {
+    Json::Value json;
+    Json::Value item;
+    item["kind"] = "drive#file";
+    item["name"] = "test";
+    json["files"].append(item);
+    *output << json;
+    EXPECT_EQ(received->size(), 1u);
+    callback(IHttpRequest::Response{IHttpRequest::Ok, {}, output, error});
+  };
+}
+
+ACTION_P2(TokenSend, token, expires_in) {
+  Json::Value json;
+  json["access_token"] = token;
+  json["expires_in"] = expires_in;
+  *arg2 << json;
+  arg0(IHttpRequest::Response{IHttpRequest::Ok, {}, arg2, arg3});
+}
+
+ACTION_P(RejectedTokenSend, sent) {
+  arg0(IHttpRequest::Response{IHttpRequest::Bad, {}, arg2, arg3});
+  sent->set_value();
+}
+
 ACTION(UnauthorizedSend) {
   Json::Value json;
   arg0(IHttpRequest::Response{IHttpRequest::Unauthorized, {}, arg2, arg3});
@@ -114,6 +366,1064 @@ TEST_F(GoogleDriveTest, ListDirectoryTest) {
   ASSERT_EQ(r.right()->front()->filename(), "test");
 }
 
+TEST_F(GoogleDriveTest, RetriesThrottledRequestTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto throttled_request = request_mock();
+  EXPECT_CALL(*throttled_request, send(_, _, _, _, _))
+      .WillOnce(ThrottledSend());
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(CallSend());
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", true))
+      .WillOnce(Return(throttled_request))
+      .WillOnce(Return(request));
+  auto r =
+      provider->listDirectorySimpleAsync(provider->rootDirectory())->result();
+  ASSERT_NE(r.right(), nullptr);
+  ASSERT_EQ(r.right()->size(), 2);
+}
+
+TEST_F(GoogleDriveTest, RetriesServerErrorOnlyWhenIdempotentTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["retry_base_delay"] = "1";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto failed_listing = request_mock();
+  EXPECT_CALL(*failed_listing, method())
+      .WillRepeatedly(ReturnRefOfCopy(std::string("GET")));
+  EXPECT_CALL(*failed_listing, send(_, _, _, _, _))
+      .WillOnce(FailedSend(IHttpRequest::BadGateway,
+                           IHttpRequest::HeaderParameters()));
+  auto listing = request_mock();
+  EXPECT_CALL(*listing, send(_, _, _, _, _)).WillOnce(CallSend());
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", true))
+      .WillOnce(Return(failed_listing))
+      .WillOnce(Return(listing));
+  auto listed =
+      provider->listDirectorySimpleAsync(provider->rootDirectory())->result();
+  ASSERT_NE(listed.right(), nullptr);
+  // The server may have created the directory before failing, so it's not
+  // created again.
+  auto failed_creation = request_mock();
+  EXPECT_CALL(*failed_creation, method())
+      .WillRepeatedly(ReturnRefOfCopy(std::string("POST")));
+  EXPECT_CALL(*failed_creation, send(_, _, _, _, _))
+      .WillOnce(FailedSend(IHttpRequest::BadGateway,
+                           IHttpRequest::HeaderParameters()));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "POST", true))
+      .WillOnce(Return(failed_creation));
+  auto created =
+      provider->createDirectoryAsync(provider->rootDirectory(), "directory",
+                                     [](EitherError<IItem>) {})
+          ->result();
+  ASSERT_NE(created.left(), nullptr);
+  EXPECT_EQ(static_cast<int>(IHttpRequest::BadGateway), created.left()->code_);
+}
+
+TEST_F(GoogleDriveTest, FailsWhenRetryAfterExceedsMaxDelayTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["retry_max_delay"] = "1000";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _))
+      .WillOnce(FailedSend(IHttpRequest::TooManyRequests,
+                           IHttpRequest::HeaderParameters{
+                               {"retry-after", "3600"}}));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", true))
+      .WillOnce(Return(request));
+  auto start = std::chrono::steady_clock::now();
+  auto r =
+      provider->listDirectorySimpleAsync(provider->rootDirectory())->result();
+  ASSERT_NE(r.left(), nullptr);
+  EXPECT_EQ(static_cast<int>(IHttpRequest::TooManyRequests), r.left()->code_);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST_F(GoogleDriveTest, DoesNotRetryStalledDownloadTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["retry_base_delay"] = "1";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _))
+      .WillOnce(StalledSend(std::string("first half")));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  auto callback = std::make_shared<DataCallback>();
+  auto r = provider
+               ->downloadFileAsync(
+                   std::make_shared<Item>(
+                       "file", "id", IItem::UnknownSize,
+                       IItem::UnknownTimeStamp, IItem::FileType::Unknown),
+                   callback)
+               ->result();
+  ASSERT_NE(r.left(), nullptr);
+  EXPECT_EQ(static_cast<int>(IHttpRequest::Timeout), r.left()->code_);
+  EXPECT_EQ(callback->data_, "first half");
+}
+
+TEST_F(GoogleDriveTest, RetriesStalledListingWithoutRepeatingItemsTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["retry_base_delay"] = "1";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  Json::Value json;
+  for (auto name : {"first", "second"}) {
+    Json::Value item;
+    item["kind"] = "drive#file";
+    item["name"] = name;
+    json["files"].append(item);
+  }
+  auto listing = util::json::to_string(json);
+  auto stalled = request_mock();
+  EXPECT_CALL(*stalled, send(_, _, _, _, _))
+      .WillOnce(StalledSend(listing.substr(0, listing.find("second"))));
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(JsonSend(json));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", true))
+      .WillOnce(Return(stalled))
+      .WillOnce(Return(request));
+  auto callback = std::make_shared<StreamDirectoryCallback>();
+  auto r = provider->streamDirectoryAsync(provider->rootDirectory(), callback)
+               ->result();
+  ASSERT_NE(r.right(), nullptr);
+  EXPECT_EQ(*r.right(), callback->names_.size());
+  EXPECT_EQ(std::count(callback->names_.begin(), callback->names_.end(),
+                       "first"),
+            1);
+  EXPECT_EQ(std::count(callback->names_.begin(), callback->names_.end(),
+                       "second"),
+            1);
+}
+
+TEST_F(GoogleDriveTest, StreamsDirectoryTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto callback = std::make_shared<StreamDirectoryCallback>();
+  auto first_page = request_mock();
+  EXPECT_CALL(*first_page, setParameter("pageToken", _)).Times(0);
+  EXPECT_CALL(*first_page, send(_, _, _, _, _))
+      .WillOnce(PageSend("first", "token", &callback->names_));
+  auto second_page = request_mock();
+  EXPECT_CALL(*second_page, setParameter("pageToken", "token"));
+  EXPECT_CALL(*second_page, send(_, _, _, _, _))
+      .WillOnce(PageSend("second", "", &callback->names_));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", true))
+      .WillOnce(Return(first_page))
+      .WillOnce(Return(second_page));
+  auto r = provider->streamDirectoryAsync(provider->rootDirectory(), callback)
+               ->result();
+  ASSERT_NE(r.right(), nullptr);
+  EXPECT_EQ(*r.right(), callback->names_.size());
+  EXPECT_EQ(callback->names_.front(), "first");
+  EXPECT_NE(std::find(callback->names_.begin(), callback->names_.end(),
+                      "second"),
+            callback->names_.end());
+}
+
+TEST_F(GoogleDriveTest, ReleasesFinishedSubrequestsTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = std::make_shared<TrackedGoogleDrive>();
+  provider->initialize(std::move(data));
+  const int chunks = 64;
+  std::function<void()> send;
+  auto& create = EXPECT_CALL(
+      http, create("https://www.googleapis.com/drive/v3/files/id", "GET", _));
+  for (int i = 0; i < chunks; i++) {
+    auto request = request_mock();
+    EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+    create.WillOnce(Return(request));
+  }
+  IItem::Pointer file =
+      std::make_shared<Item>("file", "id", IItem::UnknownSize,
+                             IItem::UnknownTimeStamp, IItem::FileType::Unknown);
+  uint64_t downloaded = 0;
+  Request<EitherError<void>>::Resolver download =
+      [&](Request<EitherError<void>>::Pointer r) {
+        r->make_subrequest(
+            &CloudProvider::downloadFileRangeAsync, file,
+            Range{downloaded * 1024, 1024},
+            std::make_shared<ChunkCallback>([&, r](EitherError<void> e) {
+              if (e.left() || ++downloaded == chunks)
+                r->done(e);
+              else
+                download(r);
+            }));
+      };
+  auto request = std::make_shared<Request<EitherError<void>>>(
+                     provider, [](EitherError<void>) {}, download)
+                     ->run();
+  size_t max_alive = 0;
+  while (send) {
+    util::exchange(send, nullptr)();
+    max_alive = std::max(max_alive, provider->alive());
+  }
+  EXPECT_EQ(request->result().left(), nullptr);
+  EXPECT_EQ(downloaded, chunks);
+  EXPECT_LE(max_alive, 2u);
+  request = nullptr;
+  provider->destroy();
+}
+
+TEST_F(GoogleDriveTest, CoalescesIdenticalRequestsTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  std::vector<ICloudProvider::GetItemDataRequest::Pointer> requests;
+  for (int i = 0; i < 3; i++)
+    requests.push_back(provider->getItemDataAsync("id"));
+  ASSERT_TRUE(static_cast<bool>(send));
+  send();
+  for (auto&& r : requests) {
+    auto item = r->result();
+    ASSERT_NE(item.right(), nullptr);
+    EXPECT_EQ(item.right()->filename(), "test");
+  }
+}
+
+TEST_F(GoogleDriveTest, CoalescesStreamedListingsTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto streamed = std::make_shared<ListingCallback>();
+  auto attached = std::make_shared<ListingCallback>();
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _))
+      .WillOnce(DeferredPageSend(&send, &streamed->names_));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", true))
+      .WillOnce(Return(request));
+  auto first =
+      provider->listDirectoryAsync(provider->rootDirectory(), streamed);
+  auto second =
+      provider->listDirectoryAsync(provider->rootDirectory(), attached);
+  ASSERT_TRUE(static_cast<bool>(send));
+  send();
+  for (auto r : {first.get(), second.get()}) {
+    ASSERT_NE(r->result().right(), nullptr);
+    EXPECT_EQ(r->result().right()->size(), 2u);
+  }
+  EXPECT_EQ(streamed->names_, attached->names_);
+  EXPECT_EQ(attached->names_.front(), "test");
+}
+
+TEST_F(GoogleDriveTest, CancelsCoalescedRequestWithLastCallerTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  auto cancelled = provider->getItemDataAsync("id");
+  auto waiting = provider->getItemDataAsync("id");
+  cancelled->cancel();
+  ASSERT_NE(cancelled->result().left(), nullptr);
+  EXPECT_EQ(cancelled->result().left()->code_,
+            static_cast<int>(IHttpRequest::Aborted));
+  ASSERT_TRUE(static_cast<bool>(send));
+  send();
+  ASSERT_NE(waiting->result().right(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, RunsCoalescedRequestWithLatestDeadlineTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  ICloudProvider::GetItemDataRequest::Pointer hurried;
+  {
+    DeadlineScope deadline(std::chrono::milliseconds(10));
+    hurried = provider->getItemDataAsync("id");
+  }
+  auto patient = provider->getItemDataAsync("id");
+  ASSERT_TRUE(static_cast<bool>(send));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  send();
+  EXPECT_NE(patient->result().right(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, RunsCoalescedRequestWithHighestPriorityTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["max_provider_requests"] = "1";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto running = request_mock();
+  auto bulk = request_mock();
+  auto interactive = request_mock();
+  {
+    InSequence sequence;
+    EXPECT_CALL(*running, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+    EXPECT_CALL(*bulk, send(_, _, _, _, _)).WillOnce(ItemSend());
+    EXPECT_CALL(*interactive, send(_, _, _, _, _)).WillOnce(ItemSend());
+  }
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(running));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id2", "GET", _))
+      .WillOnce(Return(bulk));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id3", "GET", _))
+      .WillOnce(Return(interactive));
+  auto first = provider->getItemDataAsync("id");
+  ASSERT_TRUE(static_cast<bool>(send));
+  ICloudProvider::GetItemDataRequest::Pointer background;
+  {
+    PriorityScope priority(IHttpRequest::Priority::Bulk);
+    background = provider->getItemDataAsync("id2");
+  }
+  auto other = provider->getItemDataAsync("id3");
+  auto joined = provider->getItemDataAsync("id2");
+  send();
+  EXPECT_NE(first->result().right(), nullptr);
+  EXPECT_NE(joined->result().right(), nullptr);
+  EXPECT_NE(other->result().right(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, CachesItemDataUntilDeletedTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["cache_item_ttl"] = "60000";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto& get = EXPECT_CALL(
+      http, create("https://www.googleapis.com/drive/v3/files/id", "GET", _));
+  for (int i = 0; i < 2; i++) {
+    auto request = request_mock();
+    EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+    get.WillOnce(Return(request));
+  }
+  auto remove = request_mock();
+  EXPECT_CALL(*remove, send(_, _, _, _, _)).WillOnce(EmptySend());
+  EXPECT_CALL(http, create("https://www.googleapis.com/drive/v3/files/id",
+                           "DELETE", _))
+      .WillOnce(Return(remove));
+  auto item = provider->getItemDataAsync("id")->result().right();
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(provider->getItemDataAsync("id")->result().right(), item);
+  EXPECT_EQ(provider->deleteItemAsync(item)->result().left(), nullptr);
+  auto fetched = provider->getItemDataAsync("id")->result().right();
+  ASSERT_NE(fetched, nullptr);
+  EXPECT_NE(fetched, item);
+}
+
+TEST_F(GoogleDriveTest, AnswersFromMetadataStoreAfterRestartTest) {
+  auto path = MetadataStore::path(util::temporary_directory(), "google",
+                                  "GoogleDriveTest");
+  std::remove((path + ".log").c_str());
+  std::remove((path + ".index").c_str());
+  auto create = [] {
+    ICloudProvider::InitData data;
+    data.http_engine_ = util::make_unique<HttpMock>();
+    data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+    data.callback_ = util::make_unique<AuthCallback>();
+    data.hints_["access_token"] = "access_token";
+    data.hints_["metadata_store"] = util::temporary_directory();
+    data.hints_["metadata_store_account"] = "GoogleDriveTest";
+    auto& http_factory =
+        static_cast<HttpServerFactoryMock&>(*data.http_server_);
+    EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+        .WillOnce(CreateFileServer());
+    return data;
+  };
+  {
+    auto data = create();
+    const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+    auto request = request_mock();
+    EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+    EXPECT_CALL(http, create("https://www.googleapis.com/drive/v3/files/id",
+                             "GET", _))
+        .WillOnce(Return(request));
+    auto provider =
+        ICloudStorage::create()->provider("google", std::move(data));
+    ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+  }
+  auto data = create();
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  IItem::Pointer item;
+  auto handle = provider->getItemDataAsync(
+      "id", [&](EitherError<IItem> e) { item = e.right(); });
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->filename(), "test");
+  ASSERT_TRUE(static_cast<bool>(send));
+  send();
+  provider = nullptr;
+  std::remove((path + ".log").c_str());
+  std::remove((path + ".index").c_str());
+}
+
+TEST_F(GoogleDriveTest, ResolvesIndexedPathWithoutRequestsTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["path_index_ttl"] = "60000";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto& list =
+      EXPECT_CALL(http, create("https://www.googleapis.com/drive/v3/files",
+                               "GET", _));
+  for (auto name : {"a", "b"}) {
+    auto request = request_mock();
+    EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(DirectorySend(name));
+    list.WillOnce(Return(request));
+  }
+  auto item = provider->getItemAsync("/a/b")->result().right();
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->id(), "b");
+  auto indexed = provider->getItemAsync("/a/b")->result().right();
+  ASSERT_NE(indexed, nullptr);
+  EXPECT_EQ(indexed->id(), "b");
+  EXPECT_NE(provider->getItemAsync("/a/c")->result().left(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, ReportsChangesAndInvalidatesListingTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["cache_item_ttl"] = "60000";
+  data.hints_["cache_directory_ttl"] = "60000";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto respond = [&](const std::string& url, const std::string& json) {
+    auto request = request_mock();
+    EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(JsonSend(json));
+    EXPECT_CALL(http,
+                create("https://www.googleapis.com/drive/v3/" + url, _, _))
+        .WillOnce(Return(request))
+        .RetiresOnSaturation();
+  };
+  auto listing =
+      R"({"files": [{"id": "a", "name": "a", "parents": ["R"]},
+                    {"id": "b", "name": "b", "parents": ["R"]},
+                    {"id": "e", "name": "e", "parents": ["R"]}]})";
+  respond("files", listing);
+  respond("files", listing);
+  respond("changes",
+          R"({"changes": [
+                {"fileId": "a", "removed": true},
+                {"fileId": "b", "file": {"id": "b", "name": "b",
+                                         "parents": ["d"]}},
+                {"fileId": "e", "file": {"id": "e", "name": "f",
+                                         "parents": ["R"]}},
+                {"fileId": "c", "file": {"id": "c", "name": "c",
+                                         "parents": ["d"]}}],
+              "newStartPageToken": "2"})");
+  respond("changes/startPageToken", R"({"startPageToken": "1"})");
+  respond("files/root", R"({"id": "R"})");
+  auto root = provider->rootDirectory();
+  ASSERT_NE(provider->listDirectorySimpleAsync(root)->result().right(),
+            nullptr);
+  auto start = provider->changesAsync("")->result();
+  ASSERT_NE(start.right(), nullptr);
+  EXPECT_TRUE(start.right()->changes_.empty());
+  EXPECT_EQ(start.right()->cursor_, "R:1");
+  ASSERT_NE(provider->listDirectorySimpleAsync(root)->result().right(),
+            nullptr);
+  auto changes = provider->changesAsync(start.right()->cursor_)->result();
+  ASSERT_NE(changes.right(), nullptr);
+  EXPECT_EQ(changes.right()->cursor_, "R:2");
+  const auto& c = changes.right()->changes_;
+  ASSERT_EQ(c.size(), 4u);
+  EXPECT_EQ(c[0].type_, Change::Type::Delete);
+  EXPECT_EQ(c[1].type_, Change::Type::Move);
+  EXPECT_EQ(c[2].type_, Change::Type::Modify);
+  EXPECT_EQ(c[2].item_->filename(), "f");
+  EXPECT_EQ(c[3].type_, Change::Type::Add);
+  ASSERT_NE(provider->listDirectorySimpleAsync(root)->result().right(),
+            nullptr);
+}
+
+TEST_F(GoogleDriveTest, ComparesListingsWithoutChangesFeedTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["cache_directory_ttl"] = "60000";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = std::make_shared<ListingGoogleDrive>();
+  provider->initialize(std::move(data));
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _))
+      .WillOnce(JsonSend(R"({"files": [{"id": "a", "name": "a2"},
+                                       {"id": "c", "name": "c"}]})"));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files", "GET", _))
+      .WillOnce(Return(request));
+  auto directory = std::make_shared<Item>("d", "d", IItem::UnknownSize,
+                                          IItem::UnknownTimeStamp,
+                                          IItem::FileType::Directory);
+  auto item = [](const std::string& id) {
+    return std::make_shared<Item>(id, id, IItem::UnknownSize,
+                                  IItem::UnknownTimeStamp,
+                                  IItem::FileType::Unknown);
+  };
+  auto cache = provider->metadata_cache();
+  cache->put_listing(directory, {item("a"), item("b")});
+  auto changes_async = [&](const std::string& cursor) {
+    return provider->changesAsync(cursor, [](EitherError<ChangesData>) {})
+        ->result();
+  };
+  auto start = changes_async("");
+  ASSERT_NE(start.right(), nullptr);
+  EXPECT_TRUE(start.right()->changes_.empty());
+  auto changes = changes_async(start.right()->cursor_);
+  ASSERT_NE(changes.right(), nullptr);
+  EXPECT_EQ(changes.right()->cursor_, start.right()->cursor_);
+  const auto& c = changes.right()->changes_;
+  ASSERT_EQ(c.size(), 3u);
+  EXPECT_EQ(c[0].type_, Change::Type::Modify);
+  EXPECT_EQ(c[0].item_->filename(), "a2");
+  EXPECT_EQ(c[1].type_, Change::Type::Add);
+  EXPECT_EQ(c[1].parents_, std::vector<std::string>{"d"});
+  EXPECT_EQ(c[2].type_, Change::Type::Delete);
+  EXPECT_EQ(c[2].item_->id(), "b");
+  IItem::List listing;
+  ASSERT_TRUE(cache->listing(*directory, listing));
+  EXPECT_EQ(listing.size(), 2u);
+  provider->destroy();
+}
+
+TEST_F(GoogleDriveTest, DestroysRequestWithoutWaitingTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(AbandonedSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "DELETE",
+                     _))
+      .WillOnce(Return(request));
+  IItem::Pointer file =
+      std::make_shared<Item>("file", "id", IItem::UnknownSize,
+                             IItem::UnknownTimeStamp, IItem::FileType::Unknown);
+  std::shared_ptr<Error> error;
+  auto handle = provider->deleteItemAsync(
+      file, [&](EitherError<void> e) { error = e.left(); });
+  ASSERT_TRUE(static_cast<bool>(send));
+  handle = nullptr;
+  EXPECT_EQ(error, nullptr);
+  send();
+  ASSERT_NE(error, nullptr);
+  EXPECT_EQ(error->code_, static_cast<int>(IHttpRequest::Aborted));
+}
+
+TEST_F(GoogleDriveTest, DestroyWaitsForCancelledRequestTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(AbandonedSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "DELETE",
+                     _))
+      .WillOnce(Return(request));
+  auto handle = provider->deleteItemAsync(
+      std::make_shared<Item>("file", "id", IItem::UnknownSize,
+                             IItem::UnknownTimeStamp, IItem::FileType::Unknown),
+      [](EitherError<void>) {});
+  ASSERT_TRUE(static_cast<bool>(send));
+  auto destroyed = std::async(std::launch::async, [&] { provider = nullptr; });
+  EXPECT_EQ(destroyed.wait_for(std::chrono::milliseconds(50)),
+            std::future_status::timeout);
+  send();
+  destroyed.get();
+  EXPECT_EQ(handle->result().left()->code_,
+            static_cast<int>(IHttpRequest::Aborted));
+}
+
+TEST_F(GoogleDriveTest, FailsRequestPastDeadlineTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(AbandonedSend(&send));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  ICloudProvider::GetItemDataRequest::Pointer item;
+  {
+    DeadlineScope deadline(std::chrono::milliseconds(10));
+    item = provider->getItemDataAsync("id");
+  }
+  ASSERT_TRUE(static_cast<bool>(send));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  send();
+  ASSERT_NE(item->result().left(), nullptr);
+  EXPECT_EQ(item->result().left()->code_,
+            static_cast<int>(IHttpRequest::Timeout));
+}
+
+TEST_F(GoogleDriveTest, DownloadDoesNotHoldConcurrencyLimitTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["max_provider_requests"] = "1";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto download = request_mock();
+  EXPECT_CALL(*download, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+  auto item = request_mock();
+  EXPECT_CALL(*item, send(_, _, _, _, _)).WillOnce(ItemSend());
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(download))
+      .WillOnce(Return(item));
+  auto callback = std::make_shared<DataCallback>();
+  auto request = provider->downloadFileAsync(
+      std::make_shared<Item>("file", "id", IItem::UnknownSize,
+                             IItem::UnknownTimeStamp, IItem::FileType::Unknown),
+      callback);
+  ASSERT_TRUE(static_cast<bool>(send));
+  EXPECT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+  send();
+  EXPECT_EQ(request->result().left(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, AbortsRequestCancelledWhileQueuedTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["max_provider_requests"] = "1";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  std::function<void()> send;
+  auto running = request_mock();
+  EXPECT_CALL(*running, send(_, _, _, _, _)).WillOnce(DeferredSend(&send));
+  auto queued = request_mock();
+  EXPECT_CALL(*queued, send(_, _, _, _, _)).Times(0);
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(running));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id2", "GET", _))
+      .WillOnce(Return(queued));
+  auto first = provider->getItemDataAsync("id");
+  ASSERT_TRUE(static_cast<bool>(send));
+  auto second = provider->getItemDataAsync("id2");
+  second->cancel();
+  ASSERT_NE(second->result().left(), nullptr);
+  EXPECT_EQ(second->result().left()->code_,
+            static_cast<int>(IHttpRequest::Aborted));
+  send();
+  EXPECT_NE(first->result().right(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, HedgesSlowRequestTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  data.hints_["hedge_percentile"] = "50";
+  data.hints_["hedge_budget"] = "100";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  const int samples = 16;
+  std::function<void()> send;
+  auto& create = EXPECT_CALL(
+      http, create("https://www.googleapis.com/drive/v3/files/id", "GET", _));
+  for (int i = 0; i < samples + 2; i++) {
+    auto request = request_mock();
+    EXPECT_CALL(*request, method())
+        .WillRepeatedly(ReturnRefOfCopy(std::string("GET")));
+    if (i == samples)
+      EXPECT_CALL(*request, send(_, _, _, _, _))
+          .WillOnce(AbandonedSend(&send));
+    else
+      EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+    create.WillOnce(Return(request));
+  }
+  for (int i = 0; i < samples; i++)
+    ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+  auto item = provider->getItemDataAsync("id")->result();
+  ASSERT_NE(item.right(), nullptr);
+  EXPECT_EQ(item.right()->filename(), "test");
+  ASSERT_TRUE(static_cast<bool>(send));
+  send();
+}
+
+TEST_F(GoogleDriveTest, DISABLED_ItemDataAllocationBenchmark) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<AuthCallback>();
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  const int iterations = 1000;
+  auto& create = EXPECT_CALL(
+      http, create("https://www.googleapis.com/drive/v3/files/id", "GET", _));
+  for (int i = 0; i < iterations; i++) {
+    auto request = request_mock();
+    EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+    create.WillOnce(Return(request));
+  }
+  allocations = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+  auto time = std::chrono::steady_clock::now() - start;
+  std::cout << "allocations: " << allocations / iterations << ", time: "
+            << std::chrono::duration_cast<std::chrono::microseconds>(time)
+                       .count() /
+                   iterations
+            << "us per request\n";
+}
+
+TEST_F(GoogleDriveTest, RefreshesTokenBeforeExpiryTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<TokenRefreshCallback>();
+  data.token_ = "refresh_token";
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  auto& callback = static_cast<TokenRefreshCallback&>(*data.callback_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto expired_request = request_mock();
+  EXPECT_CALL(*expired_request, send(_, _, _, _, _))
+      .WillOnce(UnauthorizedSend());
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+  auto refreshed_request = request_mock();
+  EXPECT_CALL(*refreshed_request,
+              setHeaderParameter("Authorization", "Bearer token2"));
+  EXPECT_CALL(*refreshed_request, send(_, _, _, _, _)).WillOnce(ItemSend());
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(expired_request))
+      .WillOnce(Return(request))
+      .WillOnce(Return(refreshed_request));
+  auto token_request = request_mock();
+  EXPECT_CALL(*token_request, send(_, _, _, _, _))
+      .WillOnce(TokenSend("token1", 2));
+  auto refresh_request = request_mock();
+  EXPECT_CALL(*refresh_request, send(_, _, _, _, _))
+      .WillOnce(TokenSend("token2", 3600));
+  EXPECT_CALL(
+      http, create("https://accounts.google.com/o/oauth2/token", "POST", true))
+      .WillOnce(Return(token_request))
+      .WillOnce(Return(refresh_request));
+  ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+  auto refreshed = callback.refreshed_.get_future();
+  ASSERT_EQ(refreshed.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_TRUE(refreshed.get());
+  ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, KeepsTokenRefreshWhenRequestIsCancelledTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<TokenRefreshCallback>();
+  data.token_ = "refresh_token";
+  data.hints_["access_token"] = "access_token";
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  auto& callback = static_cast<TokenRefreshCallback&>(*data.callback_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  auto expired_request = request_mock();
+  EXPECT_CALL(*expired_request, send(_, _, _, _, _))
+      .WillOnce(UnauthorizedSend());
+  auto request = request_mock();
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+  std::function<void()> send_item;
+  auto cancelled_request = request_mock();
+  EXPECT_CALL(*cancelled_request, send(_, _, _, _, _))
+      .WillOnce(AbandonedSend(&send_item));
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(expired_request))
+      .WillOnce(Return(request))
+      .WillOnce(Return(cancelled_request));
+  auto token_request = request_mock();
+  EXPECT_CALL(*token_request, send(_, _, _, _, _))
+      .WillOnce(TokenSend("token1", 2));
+  std::function<void()> send_token;
+  std::promise<void> refresh_sent;
+  auto refresh_request = request_mock();
+  EXPECT_CALL(*refresh_request, send(_, _, _, _, _))
+      .WillOnce(HeldTokenSend("token2", &send_token, &refresh_sent));
+  EXPECT_CALL(
+      http, create("https://accounts.google.com/o/oauth2/token", "POST", true))
+      .WillOnce(Return(token_request))
+      .WillOnce(Return(refresh_request));
+  ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+  ASSERT_EQ(refresh_sent.get_future().wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  auto cancelled = provider->getItemDataAsync("id");
+  ASSERT_TRUE(static_cast<bool>(send_item));
+  cancelled->cancel();
+  send_item();
+  EXPECT_NE(cancelled->result().left(), nullptr);
+  send_token();
+  auto refreshed = callback.refreshed_.get_future();
+  ASSERT_EQ(refreshed.wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_TRUE(refreshed.get());
+}
+
+TEST_F(GoogleDriveTest, RefreshesRestoredTokenBeforeExpiryTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<TokenRefreshCallback>();
+  data.token_ = "refresh_token";
+  data.hints_["access_token"] = "token1";
+  data.hints_["access_token_expires"] = std::to_string(
+      std::chrono::duration_cast<std::chrono::seconds>(
+          (std::chrono::system_clock::now() + std::chrono::seconds(2))
+              .time_since_epoch())
+          .count());
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  std::function<void()> send_token;
+  std::promise<void> refresh_sent;
+  auto refresh_request = request_mock();
+  EXPECT_CALL(*refresh_request, send(_, _, _, _, _))
+      .WillOnce(HeldTokenSend("token2", &send_token, &refresh_sent));
+  EXPECT_CALL(
+      http, create("https://accounts.google.com/o/oauth2/token", "POST", true))
+      .WillOnce(Return(refresh_request));
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  ASSERT_EQ(refresh_sent.get_future().wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  send_token();
+  auto refreshed_request = request_mock();
+  EXPECT_CALL(*refreshed_request,
+              setHeaderParameter("Authorization", "Bearer token2"));
+  EXPECT_CALL(*refreshed_request, send(_, _, _, _, _)).WillOnce(ItemSend());
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(refreshed_request));
+  ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+}
+
+TEST_F(GoogleDriveTest, RefreshesTokenSilentlyWhenRejectedTest) {
+  ICloudProvider::InitData data;
+  data.http_engine_ = util::make_unique<HttpMock>();
+  data.http_server_ = util::make_unique<HttpServerFactoryMock>();
+  data.callback_ = util::make_unique<SilentRefreshCallback>();
+  data.token_ = "refresh_token";
+  data.hints_["access_token"] = "token1";
+  data.hints_["access_token_expires"] = std::to_string(
+      std::chrono::duration_cast<std::chrono::seconds>(
+          (std::chrono::system_clock::now() + std::chrono::seconds(2))
+              .time_since_epoch())
+          .count());
+  const auto& http = static_cast<const HttpMock&>(*data.http_engine_);
+  auto& http_factory = static_cast<HttpServerFactoryMock&>(*data.http_server_);
+  auto& callback = static_cast<SilentRefreshCallback&>(*data.callback_);
+  EXPECT_CALL(http_factory, create(_, _, IHttpServer::Type::FileProvider))
+      .WillOnce(CreateFileServer());
+  std::promise<void> refresh_sent;
+  auto refresh_request = request_mock();
+  EXPECT_CALL(*refresh_request, send(_, _, _, _, _))
+      .WillOnce(RejectedTokenSend(&refresh_sent));
+  EXPECT_CALL(
+      http, create("https://accounts.google.com/o/oauth2/token", "POST", true))
+      .WillOnce(Return(refresh_request));
+  auto provider = ICloudStorage::create()->provider("google", std::move(data));
+  ASSERT_EQ(refresh_sent.get_future().wait_for(std::chrono::seconds(10)),
+            std::future_status::ready);
+  EXPECT_EQ(callback.consents_, 0);
+  EXPECT_EQ(callback.errors_, 0);
+  auto request = request_mock();
+  EXPECT_CALL(*request, setHeaderParameter("Authorization", "Bearer token1"));
+  EXPECT_CALL(*request, send(_, _, _, _, _)).WillOnce(ItemSend());
+  EXPECT_CALL(http,
+              create("https://www.googleapis.com/drive/v3/files/id", "GET", _))
+      .WillOnce(Return(request));
+  ASSERT_NE(provider->getItemDataAsync("id")->result().right(), nullptr);
+}
+
 TEST_F(GoogleDriveTest, AuthorizationTest) {
   ICloudProvider::InitData data;
   data.http_engine_ = util::make_unique<HttpMock>();
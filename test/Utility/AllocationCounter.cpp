@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * AllocationCounter.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+thread_local size_t allocations;
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  allocations++;
+  return std::malloc(size ? size : 1);
+}
+
+void* operator new(size_t size) {
+  if (auto p = operator new(size, std::nothrow)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
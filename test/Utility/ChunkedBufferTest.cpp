@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * ChunkedBufferTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "Utility/ChunkedBuffer.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+using namespace cloudstorage::util;
+
+namespace {
+
+std::string pattern(size_t size) {
+  std::string result(size, 0);
+  for (size_t i = 0; i < size; i++) result[i] = static_cast<char>('a' + i % 26);
+  return result;
+}
+
+}  // namespace
+
+TEST(ChunkedBufferTest, WritesAcrossBlocks) {
+  auto data = pattern(3 * ChunkedBuffer::BlockSize + 17);
+  ChunkedStream stream;
+  stream << data.substr(0, 5);
+  stream.write(data.data() + 5, data.size() - 5);
+  EXPECT_EQ(stream.rdbuf()->size(), data.size());
+  EXPECT_EQ(stream.rdbuf()->segments().size(), 4u);
+  EXPECT_EQ(stream.str(), data);
+  EXPECT_EQ(static_cast<size_t>(stream.tellp()), data.size());
+}
+
+TEST(ChunkedBufferTest, ReadsWhatWasWritten) {
+  auto data = pattern(2 * ChunkedBuffer::BlockSize + 3);
+  ChunkedStream stream;
+  stream << data;
+  std::string read(data.size(), 0);
+  stream.read(&read[0], read.size());
+  EXPECT_EQ(read, data);
+  EXPECT_EQ(stream.get(), std::char_traits<char>::eof());
+  stream.clear();
+  stream.seekg(ChunkedBuffer::BlockSize - 1);
+  EXPECT_EQ(static_cast<size_t>(stream.tellg()), ChunkedBuffer::BlockSize - 1);
+  EXPECT_EQ(stream.get(), data[ChunkedBuffer::BlockSize - 1]);
+  EXPECT_EQ(stream.get(), data[ChunkedBuffer::BlockSize]);
+}
+
+TEST(ChunkedBufferTest, GivesContiguousContents) {
+  ChunkedStream small;
+  small << "{\"id\": 1}";
+  std::string storage;
+  auto contents = cloudstorage::util::contents(small, storage);
+  EXPECT_EQ(contents.data_, small.rdbuf()->segments()[0].data_);
+  EXPECT_EQ(std::string(contents.data_, contents.size_), "{\"id\": 1}");
+  EXPECT_TRUE(storage.empty());
+
+  auto data = pattern(2 * ChunkedBuffer::BlockSize + 3);
+  ChunkedStream large;
+  large << data;
+  EXPECT_EQ(large.get(), data[0]);
+  contents = cloudstorage::util::contents(large, storage);
+  EXPECT_EQ(std::string(contents.data_, contents.size_), data.substr(1));
+  EXPECT_EQ(large.rdbuf()->segments().size(), 1u);
+  EXPECT_EQ(large.str(), data);
+  large << "tail";
+  EXPECT_EQ(large.str(), data + "tail");
+}
@@ -0,0 +1,313 @@
+/*****************************************************************************
+ * CoroutineTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "Utility/Coroutine.h"
+
+#ifdef UTIL_HAS_COROUTINES
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+#include "Utility/AllocationCounter.h"
+#include "Utility/Item.h"
+#include "Utility/ItemOperations.h"
+#include "gtest/gtest.h"
+
+using namespace cloudstorage;
+
+namespace {
+
+class EventQueue {
+ public:
+  Promise<int> step(int value) {
+    Promise<int> promise;
+    events_.push_back([promise, value] { promise.fulfill(value + 1); });
+    return promise;
+  }
+
+  void post(std::function<void()> event) { events_.push_back(event); }
+
+  void run() {
+    while (!events_.empty()) {
+      auto event = std::move(events_.front());
+      events_.pop_front();
+      event();
+    }
+  }
+
+ private:
+  std::deque<std::function<void()>> events_;
+};
+
+class FakeCloud : public ICloudAccess {
+ public:
+  FakeCloud() { add(root_, nullptr, ""); }
+
+  IItem::Pointer add(IItem::Pointer item, IItem::Pointer parent,
+                     std::string content) {
+    files_[item->id()] = {item, parent ? parent->id() : "", content};
+    return item;
+  }
+
+  static IItem::Pointer item(const std::string& name, IItem::FileType type) {
+    return std::make_shared<Item>(name, name, IItem::UnknownSize,
+                                  IItem::UnknownTimeStamp, type);
+  }
+
+  std::string name() const override { return "fake"; }
+  IItem::Pointer root() const override { return root_; }
+  std::string token() const override { return ""; }
+  ICloudProvider::Hints hints() const override { return {}; }
+
+  Promise<GeneralData> generalData() override { return unsupported(); }
+  Promise<IItem::List> listDirectory(IItem::Pointer directory) override {
+    IItem::List result;
+    for (const auto& d : files_)
+      if (d.second.parent_ == directory->id()) result.push_back(d.second.item_);
+    Promise<IItem::List> promise;
+    promise.fulfill(std::move(result));
+    return promise;
+  }
+  Promise<IItem::Pointer> getItem(const std::string&) override {
+    return unsupported();
+  }
+  Promise<std::string> getDaemonUrl(IItem::Pointer) override {
+    return unsupported();
+  }
+  Promise<std::string> getFileUrl(IItem::Pointer) override {
+    return unsupported();
+  }
+  Promise<IItem::Pointer> getItemData(const std::string&) override {
+    return unsupported();
+  }
+  Promise<> deleteItem(IItem::Pointer item) override {
+    files_.erase(item->id());
+    Promise<> promise;
+    promise.fulfill();
+    return promise;
+  }
+  Promise<IItem::Pointer> createDirectory(IItem::Pointer parent,
+                                          const std::string& name) override {
+    return fulfilled(add(item(name, IItem::FileType::Directory), parent, ""));
+  }
+  Promise<IItem::Pointer> moveItem(IItem::Pointer item,
+                                   IItem::Pointer parent) override {
+    files_[item->id()].parent_ = parent->id();
+    return fulfilled(item);
+  }
+  Promise<IItem::Pointer> renameItem(IItem::Pointer,
+                                     const std::string&) override {
+    return unsupported();
+  }
+  Promise<PageData> listDirectoryPage(IItem::Pointer,
+                                      const std::string&) override {
+    return unsupported();
+  }
+  Promise<IItem::Pointer> uploadFile(
+      IItem::Pointer parent, const std::string& name,
+      const std::shared_ptr<ICloudUploadCallback>& callback) override {
+    std::string content;
+    char buffer[4];
+    while (auto size = callback->putData(buffer, sizeof(buffer),
+                                         content.size()))
+      content.append(buffer, size);
+    return fulfilled(add(item(name, IItem::FileType::Unknown), parent, content));
+  }
+  Promise<> downloadFile(
+      IItem::Pointer file, Range,
+      const std::shared_ptr<ICloudDownloadCallback>& callback) override {
+    const auto& content = files_[file->id()].content_;
+    callback->receivedData(content.c_str(), content.size());
+    Promise<> promise;
+    promise.fulfill();
+    return promise;
+  }
+  Promise<> downloadThumbnail(
+      IItem::Pointer, const std::shared_ptr<ICloudDownloadCallback>&) override {
+    return unsupported();
+  }
+  Promise<> generateThumbnail(
+      IItem::Pointer, const std::shared_ptr<ICloudDownloadCallback>&) override {
+    return unsupported();
+  }
+  void subscribeChanges(ICloudProvider::IChangesListener::Pointer) override {}
+  void unsubscribeChanges(
+      const ICloudProvider::IChangesListener::Pointer&) override {}
+
+  struct File {
+    IItem::Pointer item_;
+    std::string parent_;
+    std::string content_;
+  };
+
+  std::map<std::string, File> files_;
+
+ private:
+  struct Unsupported {
+    template <class... Ts>
+    operator Promise<Ts...>() const {
+      Promise<Ts...> promise;
+      promise.reject(std::logic_error("unsupported"));
+      return promise;
+    }
+  };
+
+  static Unsupported unsupported() { return {}; }
+
+  static Promise<IItem::Pointer> fulfilled(IItem::Pointer item) {
+    Promise<IItem::Pointer> promise;
+    promise.fulfill(std::move(item));
+    return promise;
+  }
+
+  IItem::Pointer root_ = item("root", IItem::FileType::Directory);
+};
+
+util::Task<int> chain(EventQueue& queue, int steps) {
+  int value = 0;
+  for (int i = 0; i < steps; i++) value = co_await queue.step(value);
+  co_return value;
+}
+
+Promise<int> chain(EventQueue& queue) {
+  auto next = [&queue](int value) { return queue.step(value); };
+  return queue.step(0)
+      .then(next)
+      .then(next)
+      .then(next)
+      .then(next)
+      .then(next)
+      .then(next)
+      .then(next)
+      .then(next)
+      .then(next);
+}
+
+template <class... Ts>
+void expectResult(Promise<Ts...> promise, Ts... expected) {
+  bool settled = false;
+  promise.then([&](Ts... result) {
+    settled = true;
+    EXPECT_EQ(std::make_tuple(expected...), std::make_tuple(result...));
+  });
+  EXPECT_TRUE(settled);
+}
+
+}  // namespace
+
+TEST(CoroutineTest, AwaitsPromise) {
+  EventQueue queue;
+  auto result = util::spawn(chain(queue, 3));
+  queue.run();
+  expectResult(result, 3);
+}
+
+TEST(CoroutineTest, AwaitsSettledPromise) {
+  auto task = []() -> util::Task<std::tuple<int, std::string>> {
+    Promise<int, std::string> promise;
+    promise.fulfill(1, "test");
+    co_return co_await promise;
+  };
+  expectResult(util::spawn(task()), std::make_tuple(1, std::string("test")));
+}
+
+TEST(CoroutineTest, RethrowsRejection) {
+  auto task = []() -> util::Task<> {
+    Promise<> promise;
+    promise.reject(std::runtime_error("failed"));
+    co_await promise;
+    ADD_FAILURE();
+  };
+  std::string error;
+  util::spawn(task()).error<std::runtime_error>(
+      [&](const std::runtime_error& e) { error = e.what(); });
+  EXPECT_EQ(error, "failed");
+}
+
+TEST(CoroutineTest, ResumesOnExecutor) {
+  EventQueue queue, executor;
+  auto task = [&]() -> util::Task<int> {
+    co_return co_await util::resume_on(
+        [&](std::function<void()> f) { executor.post(std::move(f)); },
+        queue.step(1));
+  };
+  int result = 0;
+  util::spawn(task()).then([&](int value) { result = value; });
+  queue.run();
+  EXPECT_EQ(result, 0);
+  executor.run();
+  EXPECT_EQ(result, 2);
+}
+
+TEST(CoroutineTest, CopiesDirectoryBetweenClouds) {
+  FakeCloud source, destination;
+  auto directory = source.add(
+      FakeCloud::item("dir", IItem::FileType::Directory), source.root(), "");
+  source.add(FakeCloud::item("file", IItem::FileType::Unknown), directory,
+             "some content");
+  util::spawn(moveItem(source, directory, destination, destination.root()));
+  ASSERT_EQ(destination.files_.size(), 3);
+  EXPECT_EQ(destination.files_["dir"].parent_, "root");
+  EXPECT_EQ(destination.files_["file"].parent_, "dir");
+  EXPECT_EQ(destination.files_["file"].content_, "some content");
+  EXPECT_EQ(source.files_.count("dir"), 0);
+}
+
+TEST(CoroutineTest, MovesItemWithinCloud) {
+  FakeCloud cloud;
+  auto directory = cloud.add(FakeCloud::item("dir", IItem::FileType::Directory),
+                             cloud.root(), "");
+  auto file =
+      cloud.add(FakeCloud::item("file", IItem::FileType::Unknown), cloud.root(),
+                "some content");
+  util::spawn(moveItem(cloud, file, cloud, directory));
+  EXPECT_EQ(cloud.files_["file"].parent_, "dir");
+}
+
+TEST(CoroutineTest, DISABLED_ChainBenchmark) {
+  const int iterations = 10000;
+  EventQueue queue;
+  auto measure = [&](const char* name, auto&& start) {
+    allocations = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      auto result = start();
+      queue.run();
+      result.then([](int value) { ASSERT_EQ(value, 10); });
+    }
+    auto time = std::chrono::steady_clock::now() - begin;
+    std::cout << name << " allocations: " << allocations / iterations
+              << ", time: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(time)
+                         .count() /
+                     iterations
+              << "ns per chain\n";
+  };
+  measure("then", [&] { return chain(queue); });
+  measure("co_await", [&] { return util::spawn(chain(queue, 10)); });
+}
+
+#endif  // UTIL_HAS_COROUTINES
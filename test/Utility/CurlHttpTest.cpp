@@ -0,0 +1,583 @@
+/*****************************************************************************
+ * CurlHttpTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2016-2016 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "IHttp.h"
+#include "gtest/gtest.h"
+
+#ifdef WITH_CURL
+#include <curl/curl.h>
+#endif
+
+#ifdef __unix__
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace cloudstorage;
+
+namespace {
+
+const int REQUEST_COUNT = 32;
+const int MAX_HOST_CONNECTIONS = 2;
+
+// Minimal keep-alive HTTP/1.1 server answering every request with given body
+// after given delay; it only counts the connections the client opened.
+class HttpServer {
+ public:
+  HttpServer(std::chrono::milliseconds delay = std::chrono::milliseconds(),
+             std::string body = "")
+      : delay_(delay),
+        body_(std::move(body)),
+        connections_(),
+        socket_(socket(AF_INET, SOCK_STREAM, 0)) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(socket_, reinterpret_cast<sockaddr*>(&address), length);
+    listen(socket_, REQUEST_COUNT);
+    getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([=] {
+      int fd;
+      while ((fd = accept(socket_, nullptr, nullptr)) != -1) {
+        connections_++;
+        clients_.push_back(fd);
+        workers_.emplace_back([=] { serve(fd); });
+      }
+    });
+  }
+
+  ~HttpServer() {
+    shutdown(socket_, SHUT_RDWR);
+    thread_.join();
+    for (int fd : clients_) shutdown(fd, SHUT_RDWR);
+    for (auto& t : workers_) t.join();
+    for (int fd : clients_) close(fd);
+    close(socket_);
+  }
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(port_) + "/";
+  }
+
+  int connections() const { return connections_; }
+
+ private:
+  void serve(int fd) const {
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " +
+                                 std::to_string(body_.size()) + "\r\n\r\n" +
+                                 body_;
+    std::string buffer;
+    char data[1024];
+    ssize_t length;
+    while ((length = recv(fd, data, sizeof(data), 0)) > 0) {
+      buffer.append(data, length);
+      size_t end;
+      while ((end = buffer.find("\r\n\r\n")) != std::string::npos) {
+        buffer.erase(0, end + 4);
+        std::this_thread::sleep_for(delay_);
+        send(fd, response.data(), response.size(), MSG_NOSIGNAL);
+      }
+    }
+  }
+
+  std::chrono::milliseconds delay_;
+  std::string body_;
+  std::atomic_int connections_;
+  int socket_;
+  uint16_t port_;
+  std::vector<int> clients_;
+  std::vector<std::thread> workers_;
+  std::thread thread_;
+};
+// Minimal cleartext HTTP/2 server with prior knowledge: it answers every
+// stream with given body and counts the connections the client opened. Request
+// headers are never decoded, so it relies on them fitting in a single frame.
+class Http2Server {
+ public:
+  explicit Http2Server(std::string body)
+      : body_(std::move(body)),
+        connections_(),
+        max_streams_(),
+        socket_(socket(AF_INET, SOCK_STREAM, 0)) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(socket_, reinterpret_cast<sockaddr*>(&address), length);
+    listen(socket_, REQUEST_COUNT);
+    getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([=] {
+      int fd;
+      while ((fd = accept(socket_, nullptr, nullptr)) != -1) {
+        connections_++;
+        clients_.push_back(fd);
+        workers_.emplace_back([=] { serve(fd); });
+      }
+    });
+  }
+
+  ~Http2Server() {
+    shutdown(socket_, SHUT_RDWR);
+    thread_.join();
+    for (int fd : clients_) shutdown(fd, SHUT_RDWR);
+    for (auto& t : workers_) t.join();
+    for (int fd : clients_) close(fd);
+    close(socket_);
+  }
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(port_) + "/";
+  }
+
+  int connections() const { return connections_; }
+
+  int max_streams() const { return max_streams_; }
+
+ private:
+  enum FrameType { Data = 0, Headers = 1, Settings = 4, Ping = 6, GoAway = 7 };
+  enum Flag { Ack = 0x1, EndStream = 0x1, EndHeaders = 0x4 };
+
+  // Reads until buffer holds size bytes, calling idle whenever the client
+  // stays quiet for a while.
+  static bool read(int fd, std::string& buffer, size_t size,
+                   const std::function<void()>& idle) {
+    char data[4096];
+    while (buffer.size() < size) {
+      auto length = recv(fd, data, sizeof(data), 0);
+      if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        idle();
+        continue;
+      }
+      if (length <= 0) return false;
+      buffer.append(data, length);
+    }
+    return true;
+  }
+
+  static void frame(int fd, uint8_t type, uint8_t flags, uint32_t stream,
+                    const std::string& payload) {
+    std::string data = {static_cast<char>(payload.size() >> 16),
+                        static_cast<char>(payload.size() >> 8),
+                        static_cast<char>(payload.size()),
+                        static_cast<char>(type),
+                        static_cast<char>(flags),
+                        static_cast<char>(stream >> 24),
+                        static_cast<char>(stream >> 16),
+                        static_cast<char>(stream >> 8),
+                        static_cast<char>(stream)};
+    data += payload;
+    send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+  }
+
+  // Streams are answered only once the client goes quiet, so that requests
+  // sent together are open at the same time.
+  void serve(int fd) {
+    const size_t PREFACE_LENGTH = 24, HEADER_LENGTH = 9;
+    timeval timeout = {0, 50000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::vector<uint32_t> open;
+    auto respond = [&] {
+      max_streams_ = std::max<int>(max_streams_, open.size());
+      for (auto stream : open) {
+        // 0x88 is the static table entry of ":status: 200".
+        frame(fd, Headers, EndHeaders, stream, "\x88");
+        frame(fd, Data, EndStream, stream, body_);
+      }
+      open.clear();
+    };
+    std::string buffer;
+    if (!read(fd, buffer, PREFACE_LENGTH, [] {})) return;
+    buffer.erase(0, PREFACE_LENGTH);
+    frame(fd, Settings, 0, 0, "");
+    while (read(fd, buffer, HEADER_LENGTH, respond)) {
+      auto byte = [&](size_t i) { return static_cast<uint8_t>(buffer[i]); };
+      uint32_t length = byte(0) << 16 | byte(1) << 8 | byte(2);
+      uint8_t type = byte(3), flags = byte(4);
+      uint32_t stream =
+          (byte(5) & 0x7f) << 24 | byte(6) << 16 | byte(7) << 8 | byte(8);
+      if (!read(fd, buffer, HEADER_LENGTH + length, respond)) return;
+      auto payload = buffer.substr(HEADER_LENGTH, length);
+      buffer.erase(0, HEADER_LENGTH + length);
+      if (type == Settings && !(flags & Ack))
+        frame(fd, Settings, Ack, 0, "");
+      else if (type == Ping && !(flags & Ack))
+        frame(fd, Ping, Ack, 0, payload);
+      else if (type == Headers && (flags & EndStream))
+        open.push_back(stream);
+      else if (type == GoAway)
+        return;
+    }
+  }
+
+  std::string body_;
+  std::atomic_int connections_;
+  std::atomic_int max_streams_;
+  int socket_;
+  uint16_t port_;
+  std::vector<int> clients_;
+  std::vector<std::thread> workers_;
+  std::thread thread_;
+};
+
+
+// Discards everything written to it, only counting the bytes.
+class CountingBuffer : public std::streambuf {
+ public:
+  CountingBuffer() : count_() {}
+
+  uint64_t count() const { return count_; }
+
+ protected:
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    count_ += count;
+    return count;
+  }
+
+  int_type overflow(int_type c) override {
+    count_++;
+    return traits_type::not_eof(c);
+  }
+
+ private:
+  std::atomic<uint64_t> count_;
+};
+
+// Aborts when asked to, waking the transfer up instead of being polled; counts
+// how many times it was asked.
+class WakeupCallback : public IHttpRequest::ICallback {
+ public:
+  WakeupCallback() : abort_(), checks_() {}
+
+  bool isSuccess(int code,
+                 const IHttpRequest::HeaderParameters&) const override {
+    return IHttpRequest::isSuccess(code);
+  }
+
+  bool abort() override {
+    checks_++;
+    return abort_;
+  }
+
+  bool pause() override { return false; }
+
+  bool setWakeup(std::function<void()> wakeup) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeup_ = std::move(wakeup);
+    return true;
+  }
+
+  void progressDownload(uint64_t, uint64_t) override {}
+
+  void progressUpload(uint64_t, uint64_t) override {}
+
+  void cancel() {
+    abort_ = true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (wakeup_) wakeup_();
+  }
+
+  int checks() const { return checks_; }
+
+ private:
+  std::atomic_bool abort_;
+  std::atomic_int checks_;
+  std::mutex mutex_;
+  std::function<void()> wakeup_;
+};
+
+void get(const IHttp& http, const std::string& url,
+         IHttpRequest::Priority priority,
+         IHttpRequest::CompleteCallback callback,
+         IThrottle::Pointer throttle = nullptr) {
+  auto request = http.create(url, "GET", true);
+  request->setPriority(priority);
+  if (throttle) request->addThrottle(throttle);
+  request->send(callback, std::make_shared<std::stringstream>(),
+                std::make_shared<std::stringstream>(),
+                std::make_shared<std::stringstream>());
+}
+
+}  // namespace
+
+TEST(CurlHttpTest, LimitsConnectionsPerHost) {
+  IHttp::Options options;
+  options.max_host_connections_ = MAX_HOST_CONNECTIONS;
+  auto http = IHttp::create(options);
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  HttpServer server;
+  std::mutex mutex;
+  std::condition_variable done;
+  int completed = 0, succeeded = 0;
+  for (int i = 0; i < REQUEST_COUNT; i++) {
+    get(*http, server.url(), IHttpRequest::Priority::Interactive,
+        [&](IHttpRequest::Response response) {
+          std::unique_lock<std::mutex> lock(mutex);
+          completed++;
+          if (response.http_code_ == IHttpRequest::Ok) succeeded++;
+          done.notify_one();
+        });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait_for(lock, std::chrono::seconds(10),
+                [&] { return completed == REQUEST_COUNT; });
+  EXPECT_EQ(REQUEST_COUNT, succeeded);
+  EXPECT_LE(server.connections(), MAX_HOST_CONNECTIONS);
+}
+
+TEST(CurlHttpTest, MultiplexesListingsOverHttp2) {
+  const int LISTING_COUNT = 64;
+  IHttp::Options options;
+  options.version_ = IHttp::Version::Http2PriorKnowledge;
+  auto http = IHttp::create(options);
+  if (!http) GTEST_SKIP() << "no default http implementation";
+#ifdef WITH_CURL
+  // libcurl 7.x fails every stream but the first one on a cleartext connection
+  // with prior knowledge.
+  if (curl_version_info(CURLVERSION_NOW)->version_num < 0x080000)
+    GTEST_SKIP() << "libcurl can't multiplex cleartext HTTP/2";
+#endif
+  Http2Server server(R"({"entries": [], "has_more": false})");
+  std::mutex mutex;
+  std::condition_variable done;
+  int completed = 0, succeeded = 0;
+  for (int i = 0; i < LISTING_COUNT; i++) {
+    get(*http, server.url(), IHttpRequest::Priority::Interactive,
+        [&](IHttpRequest::Response response) {
+          std::unique_lock<std::mutex> lock(mutex);
+          completed++;
+          if (response.http_code_ == IHttpRequest::Ok) succeeded++;
+          done.notify_one();
+        });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait_for(lock, std::chrono::seconds(10),
+                [&] { return completed == LISTING_COUNT; });
+  EXPECT_EQ(LISTING_COUNT, succeeded);
+  // With PIPEWAIT the transfers wait for the first connection and multiplex
+  // over it instead of racing to open their own ones.
+  EXPECT_EQ(1, server.connections());
+  EXPECT_GT(server.max_streams(), 1);
+}
+
+TEST(CurlHttpTest, AdmitsHigherPriorityFirst) {
+  using Priority = IHttpRequest::Priority;
+  IHttp::Options options;
+  options.max_requests_ = 1;
+  options.worker_count_ = 1;
+  auto http = IHttp::create(options);
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  HttpServer server(std::chrono::milliseconds(50));
+  std::mutex mutex;
+  std::condition_variable done;
+  std::vector<Priority> completed;
+  // The first request is admitted right away, the rest wait for it.
+  std::vector<Priority> sent = {Priority::Bulk, Priority::Bulk,
+                                Priority::Streaming, Priority::Interactive,
+                                Priority::Bulk};
+  for (auto priority : sent) {
+    get(*http, server.url(), priority, [&, priority](IHttpRequest::Response) {
+      std::unique_lock<std::mutex> lock(mutex);
+      completed.push_back(priority);
+      done.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait_for(lock, std::chrono::seconds(10),
+                [&] { return completed.size() == sent.size(); });
+  std::vector<Priority> expected = {Priority::Bulk, Priority::Interactive,
+                                    Priority::Streaming, Priority::Bulk,
+                                    Priority::Bulk};
+  EXPECT_EQ(expected, completed);
+}
+
+TEST(CurlHttpTest, ThrottlesDownload) {
+  const uint64_t LIMIT = 64 * 1024;
+  auto http = IHttp::create(IHttp::Options());
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  // The bucket starts full, so the first LIMIT bytes arrive right away and the
+  // rest takes at least 1.5 seconds.
+  HttpServer server(std::chrono::milliseconds(),
+                    std::string(LIMIT * 5 / 2, 'x'));
+  auto throttle = IThrottle::create(LIMIT, 0);
+  std::promise<int> code;
+  auto start = std::chrono::steady_clock::now();
+  get(*http, server.url(), IHttpRequest::Priority::Bulk,
+      [&](IHttpRequest::Response response) {
+        code.set_value(response.http_code_);
+      },
+      throttle);
+  EXPECT_EQ(200, code.get_future().get());
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(CurlHttpTest, ReportsTransferMetrics) {
+  const std::string BODY(4096, 'x');
+  // Connections are cached per worker.
+  IHttp::Options options;
+  options.worker_count_ = 1;
+  auto http = IHttp::create(options);
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  HttpServer server(std::chrono::milliseconds(), BODY);
+  std::vector<IHttpRequest::Metrics> metrics;
+  for (int i = 0; i < 2; i++) {
+    std::promise<IHttpRequest::Metrics> result;
+    get(*http, server.url(), IHttpRequest::Priority::Interactive,
+        [&](IHttpRequest::Response response) {
+          result.set_value(response.metrics_);
+        });
+    metrics.push_back(result.get_future().get());
+  }
+  for (auto&& m : metrics) {
+    EXPECT_EQ(BODY.size(), m.downloaded_bytes_);
+    EXPECT_GT(m.start_transfer_time_, 0u);
+    EXPECT_GE(m.total_time_, m.start_transfer_time_);
+  }
+  EXPECT_FALSE(metrics[0].connection_reused_);
+  EXPECT_TRUE(metrics[1].connection_reused_);
+  EXPECT_EQ(1, server.connections());
+}
+
+TEST(CurlHttpTest, TimesOutSlowResponse) {
+  IHttp::Options options;
+  options.first_byte_timeout_ = std::chrono::milliseconds(200);
+  auto http = IHttp::create(options);
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  HttpServer server(std::chrono::seconds(1));
+  std::promise<int> first_byte, deadline;
+  auto start = std::chrono::steady_clock::now();
+  get(*http, server.url(), IHttpRequest::Priority::Interactive,
+      [&](IHttpRequest::Response response) {
+        first_byte.set_value(response.http_code_);
+      });
+  auto request = http->create(server.url(), "GET", true);
+  request->setDeadline(start + std::chrono::milliseconds(100));
+  request->send(
+      [&](IHttpRequest::Response response) {
+        deadline.set_value(response.http_code_);
+      },
+      std::make_shared<std::stringstream>(),
+      std::make_shared<std::stringstream>(),
+      std::make_shared<std::stringstream>());
+  EXPECT_EQ(static_cast<int>(IHttpRequest::Timeout),
+            first_byte.get_future().get());
+  EXPECT_EQ(static_cast<int>(IHttpRequest::Timeout),
+            deadline.get_future().get());
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(900));
+}
+
+TEST(CurlHttpTest, WaitsForLongPoll) {
+  IHttp::Options options;
+  options.first_byte_timeout_ = std::chrono::milliseconds(200);
+  options.stall_timeout_ = std::chrono::seconds(1);
+  auto http = IHttp::create(options);
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  HttpServer server(std::chrono::milliseconds(2500), "changed");
+  std::promise<int> code;
+  auto output = std::make_shared<std::stringstream>();
+  auto request = http->create(server.url(), "GET", true);
+  request->setLongPoll(true);
+  request->send(
+      [&](IHttpRequest::Response response) {
+        code.set_value(response.http_code_);
+      },
+      std::make_shared<std::stringstream>(), output,
+      std::make_shared<std::stringstream>());
+  EXPECT_EQ(static_cast<int>(IHttpRequest::Ok), code.get_future().get());
+  EXPECT_EQ("changed", output->str());
+}
+
+TEST(CurlHttpTest, WakesIdleTransferOnlyWhenAsked) {
+  auto http = IHttp::create();
+  if (!http) GTEST_SKIP() << "no default http implementation";
+  HttpServer server(std::chrono::seconds(2));
+  auto callback = std::make_shared<WakeupCallback>();
+  std::promise<int> code;
+  auto request = http->create(server.url(), "GET", true);
+  request->send(
+      [&](IHttpRequest::Response response) {
+        code.set_value(response.http_code_);
+      },
+      std::make_shared<std::stringstream>(),
+      std::make_shared<std::stringstream>(),
+      std::make_shared<std::stringstream>(), callback);
+  // Curl itself asks a few times while connecting and sending the request,
+  // then the transfer is idle until the response.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  int checks = callback->checks();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  EXPECT_LT(callback->checks() - checks, 8);
+  auto start = std::chrono::steady_clock::now();
+  callback->cancel();
+  EXPECT_EQ(static_cast<int>(IHttpRequest::Aborted), code.get_future().get());
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(100));
+}
+
+TEST(CurlHttpTest, DISABLED_DownloadThroughputBenchmark) {
+  const int DOWNLOAD_COUNT = 16;
+  const size_t BODY_SIZE = 64 * 1024 * 1024;
+  HttpServer server(std::chrono::milliseconds(), std::string(BODY_SIZE, 'x'));
+  for (uint32_t workers : {1u, 2u, 4u, 8u}) {
+    IHttp::Options options;
+    options.worker_count_ = workers;
+    auto http = IHttp::create(options);
+    if (!http) GTEST_SKIP() << "no default http implementation";
+    std::vector<CountingBuffer> buffers(DOWNLOAD_COUNT);
+    std::vector<std::future<void>> done;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& buffer : buffers) {
+      auto result = std::make_shared<std::promise<void>>();
+      done.push_back(result->get_future());
+      auto request = http->create(server.url(), "GET", true);
+      request->send([=](IHttpRequest::Response) { result->set_value(); },
+                    std::make_shared<std::stringstream>(),
+                    std::make_shared<std::ostream>(&buffer),
+                    std::make_shared<std::stringstream>());
+    }
+    for (auto& d : done) d.wait();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    uint64_t total = 0;
+    for (auto& buffer : buffers) total += buffer.count();
+    EXPECT_EQ(DOWNLOAD_COUNT * BODY_SIZE, total);
+    std::cerr << workers << " workers: "
+              << total / elapsed.count() / (1024 * 1024) << " MB/s\n";
+  }
+}
+
+#endif  // __unix__
@@ -28,6 +28,12 @@ using namespace cloudstorage;
 
 class HttpRequestMock : public IHttpRequest {
  public:
+  HttpRequestMock() {
+    ON_CALL(*this, method())
+        .WillByDefault(::testing::ReturnRefOfCopy(std::string("GET")));
+    EXPECT_CALL(*this, method()).Times(::testing::AtLeast(0));
+  }
+
   MOCK_METHOD2(setParameter,
                void(const std::string& parameter, const std::string& value));
 
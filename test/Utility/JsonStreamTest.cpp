@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * JsonStreamTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "Utility/JsonStream.h"
+#include "Utility/Utility.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace cloudstorage::util;
+
+namespace {
+
+std::string listing(size_t count) {
+  Json::Value json;
+  for (size_t i = 0; i < count; i++) {
+    Json::Value item;
+    item["kind"] = "drive#file";
+    item["id"] = "1mGQJOxIbd4Wn8y3Cw0BfjCh" + std::to_string(i);
+    item["name"] = "file [" + std::to_string(i) + "], \"quoted\".mp4";
+    item["mimeType"] = "video/mp4";
+    item["size"] = std::to_string(i * 1024);
+    item["modifiedTime"] = "2026-01-01T10:00:00.000Z";
+    item["parents"].append("0AB6ZJ6hZyYt2Uk9PVA");
+    json["files"].append(item);
+  }
+  json["nextPageToken"] = "token";
+  json["kind"] = "drive#fileList";
+  return json::to_string(json);
+}
+
+}  // namespace
+
+TEST(JsonStreamTest, EmitsElementsWhileWriting) {
+  std::vector<std::string> ids;
+  JsonStream stream({"_embedded", "items"}, [&](const Json::Value& v) {
+    ids.push_back(v["id"].asString());
+  });
+  stream << R"({"_embedded": {"items": [{"id": "a", "name": "[}\"]"},)";
+  EXPECT_EQ(ids, std::vector<std::string>({"a"}));
+  stream << R"( {"id": "b", "tags": [1, 2]} ], "total": 3}, "items": [1]})";
+  EXPECT_EQ(ids, std::vector<std::string>({"a", "b"}));
+  auto rest = stream.rdbuf()->finish();
+  EXPECT_EQ(rest["_embedded"]["items"].size(), 0u);
+  EXPECT_EQ(rest["_embedded"]["total"].asInt(), 3);
+  EXPECT_EQ(rest["items"].size(), 1u);
+}
+
+TEST(JsonStreamTest, ThrowsOnMalformedDocument) {
+  auto ignore = [](const Json::Value&) {};
+  JsonStream truncated({"files"}, ignore);
+  truncated << R"({"files": [{"id": "a"})";
+  EXPECT_THROW(truncated.rdbuf()->finish(), std::logic_error);
+  JsonStream invalid({"files"}, ignore);
+  invalid << R"({"files": [{"id": }]})";
+  EXPECT_THROW(invalid.rdbuf()->finish(), std::exception);
+  JsonStream failing({"files"}, [](const Json::Value&) {
+    throw std::logic_error("failed");
+  });
+  failing << R"({"files": [{"id": "a"}]})";
+  EXPECT_THROW(failing.rdbuf()->finish(), std::logic_error);
+}
+
+// Run with --gtest_also_run_disabled_tests.
+TEST(JsonStreamTest, DISABLED_ListingBenchmark) {
+  const int iterations = 20;
+  auto page = listing(10000);
+  auto measure = [&](const std::function<size_t()>& parse) {
+    size_t count = 0;
+    auto start = std::chrono::system_clock::now();
+    for (int i = 0; i < iterations; i++) count += parse();
+    auto time = std::chrono::system_clock::now() - start;
+    EXPECT_EQ(count, iterations * 10000u);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time).count();
+  };
+  auto dom = measure([&] {
+    size_t count = 0;
+    auto json = json::from_string(page);
+    for (const auto& v : json["files"]) count += !v["id"].asString().empty();
+    return count;
+  });
+  auto streaming = measure([&] {
+    size_t count = 0;
+    JsonBuffer buffer({"files"}, [&](const Json::Value& v) {
+      count += !v["id"].asString().empty();
+    });
+    buffer.write(page.data(), page.size());
+    buffer.finish();
+    return count;
+  });
+  std::cout << "dom: " << dom << "ms, streaming: " << streaming << "ms\n";
+}
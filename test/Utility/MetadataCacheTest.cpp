@@ -0,0 +1,162 @@
+/*****************************************************************************
+ * MetadataCacheTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "Utility/MetadataCache.h"
+#include "Utility/Item.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace cloudstorage;
+
+namespace {
+
+IItem::Pointer item(const std::string& id,
+                    IItem::FileType type = IItem::FileType::Unknown) {
+  return std::make_shared<Item>(id, id, IItem::UnknownSize,
+                                IItem::UnknownTimeStamp, type);
+}
+
+MetadataCache::Options options() {
+  MetadataCache::Options options;
+  options.item_ttl_ = std::chrono::minutes(1);
+  options.directory_ttl_ = std::chrono::minutes(1);
+  options.url_ttl_ = std::chrono::minutes(1);
+  options.path_ttl_ = std::chrono::minutes(1);
+  options.path_index_ttl_ = std::chrono::minutes(1);
+  return options;
+}
+
+}  // namespace
+
+TEST(MetadataCacheTest, IsDisabledByDefault) {
+  MetadataCache cache(MetadataCache::Options{});
+  EXPECT_FALSE(cache.enabled());
+  cache.put_item(item("a"));
+  EXPECT_EQ(cache.item("a"), nullptr);
+  EXPECT_EQ(cache.memory_usage(), 0u);
+}
+
+TEST(MetadataCacheTest, ExpiresEntries) {
+  auto o = options();
+  o.item_ttl_ = std::chrono::milliseconds(10);
+  MetadataCache cache(o);
+  auto a = item("a");
+  cache.put_item(a);
+  cache.put_url(*a, "url");
+  EXPECT_EQ(cache.item("a"), a);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(cache.item("a"), nullptr);
+  std::string url;
+  EXPECT_TRUE(cache.url(*a, url));
+  EXPECT_EQ(url, "url");
+}
+
+TEST(MetadataCacheTest, EvictsLeastRecentlyUsedOverBudget) {
+  MetadataCache measure(options());
+  measure.put_item(item("a"));
+  auto o = options();
+  o.memory_budget_ = measure.memory_usage() * 5 / 2;
+  MetadataCache cache(o);
+  cache.put_item(item("a"));
+  cache.put_item(item("b"));
+  EXPECT_NE(cache.item("a"), nullptr);
+  cache.put_item(item("c"));
+  EXPECT_NE(cache.item("a"), nullptr);
+  EXPECT_EQ(cache.item("b"), nullptr);
+  EXPECT_NE(cache.item("c"), nullptr);
+  EXPECT_LE(cache.memory_usage(), o.memory_budget_);
+}
+
+TEST(MetadataCacheTest, RemoveDropsListingsContainingItem) {
+  MetadataCache cache(options());
+  auto a = item("a"), b = item("b");
+  auto directory = item("directory", IItem::FileType::Directory);
+  auto other = item("other", IItem::FileType::Directory);
+  auto unrelated = item("unrelated", IItem::FileType::Directory);
+  cache.put_listing(directory, {a, b});
+  cache.put_page(*other, "token", {{a}, "next"});
+  cache.put_listing(unrelated, {b});
+  cache.put_path("/directory/a", a);
+  cache.put_item(a);
+  cache.remove(*a);
+  IItem::List items;
+  PageData page;
+  EXPECT_FALSE(cache.listing(*directory, items));
+  EXPECT_FALSE(cache.page(*other, "token", page));
+  EXPECT_TRUE(cache.listing(*unrelated, items));
+  EXPECT_EQ(cache.path("/directory/a"), nullptr);
+  EXPECT_EQ(cache.item("a"), nullptr);
+}
+
+TEST(MetadataCacheTest, InvalidatesAllPagesOfDirectory) {
+  MetadataCache cache(options());
+  auto directory = item("directory", IItem::FileType::Directory);
+  auto nested = item("directoryp", IItem::FileType::Directory);
+  cache.put_page(*directory, "", {{item("a")}, "1"});
+  cache.put_page(*directory, "1", {{item("b")}, ""});
+  cache.put_listing(nested, {item("c")});
+  cache.invalidate_directory("directory");
+  PageData page;
+  IItem::List items;
+  EXPECT_FALSE(cache.page(*directory, "", page));
+  EXPECT_FALSE(cache.page(*directory, "1", page));
+  EXPECT_TRUE(cache.listing(*nested, items));
+  cache.clear();
+  EXPECT_EQ(cache.memory_usage(), 0u);
+}
+
+TEST(MetadataCacheTest, IndexesChildrenByName) {
+  MetadataCache cache(options());
+  auto directory = item("directory", IItem::FileType::Directory);
+  auto a = item("a");
+  IItem::Pointer child;
+  EXPECT_FALSE(cache.child(*directory, "a", child));
+  cache.put_listing(directory, {a, item("b")});
+  ASSERT_TRUE(cache.child(*directory, "a", child));
+  EXPECT_EQ(child, a);
+  ASSERT_TRUE(cache.child(*directory, "c", child));
+  EXPECT_EQ(child, nullptr);
+  cache.remove(*a);
+  EXPECT_FALSE(cache.child(*directory, "b", child));
+}
+
+TEST(MetadataCacheTest, AppliesChangesToListings) {
+  MetadataCache cache(options());
+  auto a = item("a"), b = item("b");
+  auto directory = item("directory", IItem::FileType::Directory);
+  auto other = item("other", IItem::FileType::Directory);
+  cache.put_listing(directory, {a});
+  cache.put_listing(other, {});
+  cache.put_item(b);
+  ASSERT_EQ(cache.listings().size(), 2u);
+  EXPECT_EQ(cache.directories("a").count("directory"), 1u);
+  cache.apply({Change::Type::Modify, b, {"other"}});
+  IItem::List items;
+  EXPECT_TRUE(cache.listing(*directory, items));
+  EXPECT_FALSE(cache.listing(*other, items));
+  EXPECT_EQ(cache.item("b"), b);
+  cache.apply({Change::Type::Delete, a, {}});
+  EXPECT_FALSE(cache.listing(*directory, items));
+  EXPECT_EQ(cache.item("a"), nullptr);
+  EXPECT_TRUE(cache.listings().empty());
+}
@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * MetadataStoreTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "Utility/MetadataStore.h"
+#include "Utility/Item.h"
+#include "Utility/Utility.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace cloudstorage;
+
+namespace {
+
+IItem::Pointer item(const std::string& id,
+                    IItem::FileType type = IItem::FileType::Unknown) {
+  return std::make_shared<Item>(id + ".txt", id, id.size(),
+                                IItem::UnknownTimeStamp, type);
+}
+
+size_t file_size(const std::string& path) {
+  return std::ifstream(path, std::ios::binary | std::ios::ate).tellg();
+}
+
+class MetadataStoreTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    path_ = util::temporary_directory() + "cloudstorage-metadata-store-test";
+    TearDown();
+  }
+
+  void TearDown() override {
+    std::remove((path_ + ".log").c_str());
+    std::remove((path_ + ".index").c_str());
+  }
+
+ protected:
+  std::string path_;
+};
+
+}  // namespace
+
+TEST_F(MetadataStoreTest, KeepsItemsAndListingsAfterReopening) {
+  auto directory = item("directory", IItem::FileType::Directory);
+  auto file = std::make_shared<Item>(
+      "file.mp4", "file", 42,
+      IItem::TimeStamp(std::chrono::milliseconds(1500000000123)),
+      IItem::FileType::Video);
+  file->set_mime_type("video/mp4");
+  file->set_parents({"directory"});
+  {
+    auto store = MetadataStore::open(path_);
+    ASSERT_NE(store, nullptr);
+    store->put_listing("directory", {file, item("other")});
+    store->put_item(*directory);
+    store->flush();
+    store->put_item(*item("unindexed"));
+  }
+  auto store = MetadataStore::open(path_);
+  ASSERT_NE(store, nullptr);
+  EXPECT_EQ(store->size(), 5u);
+  auto stored = std::dynamic_pointer_cast<Item>(store->item("file"));
+  ASSERT_NE(stored, nullptr);
+  EXPECT_EQ(stored->filename(), "file.mp4");
+  EXPECT_EQ(stored->size(), 42u);
+  EXPECT_EQ(stored->timestamp(), file->timestamp());
+  EXPECT_EQ(stored->type(), IItem::FileType::Video);
+  EXPECT_EQ(stored->mime_type(), "video/mp4");
+  EXPECT_EQ(stored->parents(), file->parents());
+  IItem::List items;
+  ASSERT_TRUE(store->listing("directory", items));
+  ASSERT_EQ(items.size(), 2u);
+  EXPECT_EQ(items[0]->id(), "file");
+  EXPECT_EQ(items[1]->id(), "other");
+  EXPECT_NE(store->item("unindexed"), nullptr);
+  EXPECT_EQ(store->item("missing"), nullptr);
+}
+
+TEST_F(MetadataStoreTest, RemovingItemDropsListingContainingIt) {
+  {
+    auto store = MetadataStore::open(path_);
+    store->put_listing("directory", {item("a"), item("b")});
+    store->flush();
+    store->remove_item("a");
+  }
+  auto store = MetadataStore::open(path_);
+  IItem::List items;
+  EXPECT_FALSE(store->listing("directory", items));
+  EXPECT_EQ(store->item("a"), nullptr);
+  EXPECT_NE(store->item("b"), nullptr);
+  EXPECT_EQ(store->size(), 1u);
+}
+
+TEST_F(MetadataStoreTest, RecoversFromUnfinishedWrite) {
+  {
+    auto store = MetadataStore::open(path_);
+    store->put_item(*item("a"));
+    store->flush();
+    store->put_item(*item("b"));
+  }
+  std::ofstream(path_ + ".log", std::ios::binary | std::ios::app)
+      << std::string("\x40\0\0\0\1", 5);
+  {
+    auto store = MetadataStore::open(path_);
+    ASSERT_NE(store, nullptr);
+    EXPECT_NE(store->item("a"), nullptr);
+    EXPECT_NE(store->item("b"), nullptr);
+    store->put_item(*item("c"));
+  }
+  auto store = MetadataStore::open(path_);
+  EXPECT_NE(store->item("c"), nullptr);
+  EXPECT_EQ(store->size(), 3u);
+}
+
+TEST_F(MetadataStoreTest, CompactsSupersededRecords) {
+  auto store = MetadataStore::open(path_);
+  for (int i = 0; i < 4096; i++)
+    store->put_item(*item("item" + std::to_string(i % 16)));
+  store->flush();
+  EXPECT_EQ(store->size(), 16u);
+  EXPECT_LT(file_size(path_ + ".log"), 4096u);
+  store = nullptr;
+  store = MetadataStore::open(path_);
+  for (int i = 0; i < 16; i++)
+    EXPECT_NE(store->item("item" + std::to_string(i)), nullptr);
+}
+
+TEST_F(MetadataStoreTest, DISABLED_StartupBenchmark) {
+  const int directories = 1000, items = 1000;
+  {
+    auto store = MetadataStore::open(path_);
+    for (int i = 0; i < directories; i++) {
+      IItem::List listing;
+      for (int j = 0; j < items; j++)
+        listing.push_back(item(std::to_string(i) + "/" + std::to_string(j)));
+      store->put_listing(std::to_string(i), listing);
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto store = MetadataStore::open(path_);
+  auto opened = std::chrono::steady_clock::now();
+  IItem::List listing;
+  ASSERT_TRUE(store->listing("0", listing));
+  auto listed = std::chrono::steady_clock::now();
+  std::mt19937 random;
+  const int lookups = 100000;
+  for (int i = 0; i < lookups; i++)
+    ASSERT_NE(store->item(std::to_string(random() % directories) + "/" +
+                          std::to_string(random() % items)),
+              nullptr);
+  auto done = std::chrono::steady_clock::now();
+  auto us = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+  };
+  std::cerr << "items: " << store->size() << ", open: " << us(opened - start)
+            << "us, first listing: " << us(listed - opened)
+            << "us, lookup: " << us(done - listed) / double(lookups) << "us\n";
+}
@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * XmlStreamTest.cpp
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLAN
+ *
+ * Authors: Paweł Wegner <pawel.wegner95@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#include "Utility/XmlStream.h"
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace cloudstorage::util;
+
+TEST(XmlStreamTest, EmitsElementsWhileWriting) {
+  std::vector<std::string> keys;
+  XmlStream stream({"Contents", "response"},
+                   [&](const tinyxml2::XMLElement& e) {
+                     keys.push_back(e.FirstChildElement()->GetText());
+                   });
+  stream << R"(<?xml version="1.0" encoding="UTF-8"?>)"
+         << R"(<d:multistatus xmlns:d="DAV:"><Name>bucket</Name>)"
+         << R"(<Contents><Key attr='a/b'>a&amp;b</Key></Contents>)";
+  EXPECT_EQ(keys, std::vector<std::string>({"a&b"}));
+  stream << R"(<!-- <Contents> --><d:response><d:href><![CDATA[<b>]]>)"
+         << R"(</d:href><d:prop/></d:response>)"
+         << R"(<IsTruncated>true</IsTruncated></d:multistatus>)";
+  EXPECT_EQ(keys, std::vector<std::string>({"a&b", "<b>"}));
+  tinyxml2::XMLDocument document;
+  stream.rdbuf()->finish(document);
+  EXPECT_STREQ(document.RootElement()->FirstChildElement("Name")->GetText(),
+               "bucket");
+}
+
+TEST(XmlStreamTest, KeepsRestOfDocument) {
+  int count = 0;
+  XmlStream stream({"Contents"},
+                   [&](const tinyxml2::XMLElement&) { count++; });
+  stream << "<ListBucketResult><Name>bucket</Name><Contents><Key>a</Key>"
+            "</Contents><Contents><Key>b</Key></Contents>"
+            "<IsTruncated>false</IsTruncated></ListBucketResult>";
+  EXPECT_EQ(count, 2);
+  tinyxml2::XMLDocument document;
+  stream.rdbuf()->finish(document);
+  auto root = document.RootElement();
+  EXPECT_EQ(root->FirstChildElement("Contents"), nullptr);
+  EXPECT_STREQ(root->FirstChildElement("IsTruncated")->GetText(), "false");
+
+  XmlStream truncated({"Contents"}, [](const tinyxml2::XMLElement&) {});
+  truncated << "<ListBucketResult><Contents><Key>a</Key>";
+  EXPECT_THROW(truncated.rdbuf()->finish(document), std::logic_error);
+}